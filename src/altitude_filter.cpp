@@ -0,0 +1,94 @@
+#include "altitude_filter.h"
+#include <M5Unified.h>
+#include "config.h"
+
+AltitudeFilter::AltitudeFilter()
+{
+  reset(0.0f);
+}
+
+void AltitudeFilter::reset(float baroAltitude)
+{
+  x[0] = baroAltitude;
+  x[1] = 0.0f;
+  x[2] = 0.0f;
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      P[i][j] = 0.0f;
+    }
+  }
+  // Until the GPS reports only h + b is known: h and b are uncertain but fully anti-correlated
+  const float offsetVariance = VARIO_KF_INITIAL_OFFSET_M * VARIO_KF_INITIAL_OFFSET_M;
+  P[0][0] = offsetVariance + VARIO_KF_BARO_NOISE_M * VARIO_KF_BARO_NOISE_M;
+  P[1][1] = 1.0f;
+  P[2][2] = offsetVariance;
+  P[0][2] = P[2][0] = -offsetVariance;
+}
+
+void AltitudeFilter::predict(float dt)
+{
+  if (dt <= 0.0f)
+  {
+    return;
+  }
+
+  // x = F x with F = [1 dt 0; 0 1 0; 0 0 1]
+  x[0] += x[1] * dt;
+
+  // P = F P F^T
+  P[0][0] += dt * (P[1][0] + P[0][1]) + dt * dt * P[1][1];
+  P[0][1] += dt * P[1][1];
+  P[1][0] = P[0][1];
+  P[0][2] += dt * P[1][2];
+  P[2][0] = P[0][2];
+
+  // + Q: white noise acceleration on h/v, random walk on b
+  const float q = VARIO_KF_ACCEL_NOISE_MPS2 * VARIO_KF_ACCEL_NOISE_MPS2;
+  float dt2 = dt * dt;
+  P[0][0] += q * dt2 * dt2 / 4.0f;
+  P[0][1] += q * dt2 * dt / 2.0f;
+  P[1][0] = P[0][1];
+  P[1][1] += q * dt2;
+  P[2][2] += VARIO_KF_OFFSET_DRIFT_M * VARIO_KF_OFFSET_DRIFT_M * dt;
+}
+
+void AltitudeFilter::update(const float H[3], float z, float r)
+{
+  // PHt = P H^T, S = H P H^T + r
+  float PHt[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    PHt[i] = P[i][0] * H[0] + P[i][1] * H[1] + P[i][2] * H[2];
+  }
+  float S = H[0] * PHt[0] + H[1] * PHt[1] + H[2] * PHt[2] + r;
+  float innovation = z - (H[0] * x[0] + H[1] * x[1] + H[2] * x[2]);
+
+  // K = PHt / S, x += K y, P -= K (H P); H P is PHt^T because P is symmetric
+  float K[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    K[i] = PHt[i] / S;
+    x[i] += K[i] * innovation;
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      P[i][j] -= K[i] * PHt[j];
+    }
+  }
+}
+
+void AltitudeFilter::updateBaro(float baroAltitude)
+{
+  const float H[3] = {1.0f, 0.0f, 1.0f};
+  update(H, baroAltitude, VARIO_KF_BARO_NOISE_M * VARIO_KF_BARO_NOISE_M);
+}
+
+void AltitudeFilter::updateGps(float gpsAltitude)
+{
+  const float H[3] = {1.0f, 0.0f, 0.0f};
+  update(H, gpsAltitude, VARIO_KF_GPS_NOISE_M * VARIO_KF_GPS_NOISE_M);
+}
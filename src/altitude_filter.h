@@ -0,0 +1,34 @@
+#ifndef ALTITUDE_FILTER_H
+#define ALTITUDE_FILTER_H
+
+// Kalman filter fusing barometric and GPS altitude. State: altitude h (m, GPS reference), vertical speed v (m/s)
+// and the offset b of the barometric altitude against it (m). Vertical acceleration is modelled as white noise,
+// the offset as a slow random walk (weather, temperature). The barometer measures h + b at a high rate with
+// little noise, the GPS measures h at a low rate with much noise; together they give a responsive vertical speed
+// and an altitude without the QNH error of the barometer.
+class AltitudeFilter
+{
+public:
+  AltitudeFilter();
+  // Start at a barometric altitude, vertical speed 0, offset unknown
+  void reset(float baroAltitude);
+  // Advance the state by dt seconds
+  void predict(float dt);
+  void updateBaro(float baroAltitude);
+  void updateGps(float gpsAltitude);
+
+  float altitude() const { return x[0]; }
+  float verticalSpeed() const { return x[1]; }
+  float baroOffset() const { return x[2]; }
+  float altitudeVariance() const { return P[0][0]; }
+  float verticalSpeedVariance() const { return P[1][1]; }
+
+private:
+  // Scalar measurement z = H x with variance r
+  void update(const float H[3], float z, float r);
+
+  float x[3];
+  float P[3][3];
+};
+
+#endif // ALTITUDE_FILTER_H
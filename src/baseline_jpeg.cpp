@@ -0,0 +1,679 @@
+#include "baseline_jpeg.h"
+#include <stdlib.h> // For malloc, free
+#include <string.h> // For memset
+
+static const int JPEG_MAX_COMPONENTS = 3;
+static const int JPEG_MAX_BLOCKS_PER_MCU = 6; // 4:2:0: four luma blocks and one block per chroma component
+static const int JPEG_FAST_BITS = 9;          // Huffman codes up to this length are decoded with one table lookup
+
+// Position of the n-th coefficient of the zigzag scan in the 8x8 block
+static const uint8_t zigzagOrder[64] = {
+    0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+struct JpegHuffmanTable
+{
+  uint16_t fast[1 << JPEG_FAST_BITS]; // (length << 8) | value of the code starting with these bits, 0 = longer code
+  int32_t maxCode[18];                // Codes of length l are below maxCode[l], left aligned to 16 bits
+  int32_t valueDelta[17];             // Index into values = code + valueDelta[length]
+  uint8_t values[256];
+  bool defined;
+};
+
+struct JpegComponent
+{
+  int id;
+  int h; // Sampling factors
+  int v;
+  int quantTable;
+  int dcTable;
+  int acTable;
+  int dcPredictor;
+};
+
+struct JpegBitReader
+{
+  const uint8_t *data;
+  size_t length;
+  size_t position;
+  uint32_t bits; // Left aligned
+  int count;
+  bool marker; // Reached a marker, the rest of the segment reads as zeros
+};
+
+struct JpegDecoder
+{
+  JpegHuffmanTable dcTables[2]; // Baseline allows two tables of each class
+  JpegHuffmanTable acTables[2];
+  uint16_t quantTables[4][64]; // Zigzag order, as transmitted
+  bool quantDefined[4];
+  JpegComponent components[JPEG_MAX_COMPONENTS];
+  int componentCount;
+  int width;
+  int height;
+  int hMax;
+  int vMax;
+  int restartInterval;
+  size_t scanOffset; // First byte of the entropy coded data
+  JpegBitReader reader;
+  int16_t coefficients[64];
+  uint8_t blocks[JPEG_MAX_BLOCKS_PER_MCU][64];
+};
+
+static int readUint16(const uint8_t *data)
+{
+  return (data[0] << 8) | data[1];
+}
+
+static bool buildHuffmanTable(JpegHuffmanTable *table, const uint8_t *counts, const uint8_t *values, int valueCount)
+{
+  memset(table->fast, 0, sizeof(table->fast));
+  memcpy(table->values, values, valueCount);
+  int code = 0;
+  int index = 0;
+  for (int length = 1; length <= 16; ++length)
+  {
+    table->valueDelta[length] = index - code;
+    for (int i = 0; i < counts[length - 1]; ++i, ++code, ++index)
+    {
+      if (length <= JPEG_FAST_BITS)
+      {
+        int first = code << (JPEG_FAST_BITS - length);
+        for (int j = 0; j < (1 << (JPEG_FAST_BITS - length)); ++j)
+        {
+          table->fast[first + j] = (uint16_t)((length << 8) | values[index]);
+        }
+      }
+    }
+    if (code > (1 << length))
+    {
+      return false; // More codes than fit into this length
+    }
+    table->maxCode[length] = code << (16 - length);
+    code <<= 1;
+  }
+  table->maxCode[17] = 0x7FFFFFFF;
+  table->defined = true;
+  return true;
+}
+
+static void fillBits(JpegBitReader *reader)
+{
+  while (reader->count <= 24)
+  {
+    uint32_t byte = 0;
+    if (!reader->marker && reader->position < reader->length)
+    {
+      byte = reader->data[reader->position];
+      if (byte != 0xFF)
+      {
+        reader->position++;
+      }
+      else if (reader->position + 1 < reader->length && reader->data[reader->position + 1] == 0x00)
+      {
+        reader->position += 2; // Stuffed zero byte
+      }
+      else
+      {
+        reader->marker = true; // Stay on the marker, a restart interval continues behind it
+        byte = 0;
+      }
+    }
+    reader->bits |= byte << (24 - reader->count);
+    reader->count += 8;
+  }
+}
+
+static int getBits(JpegBitReader *reader, int count)
+{
+  fillBits(reader);
+  int value = (int)(reader->bits >> (32 - count));
+  reader->bits <<= count;
+  reader->count -= count;
+  return value;
+}
+
+// Sign extension of a magnitude category value (F.2.2.1)
+static int extendValue(int value, int count)
+{
+  return value < (1 << (count - 1)) ? value - (1 << count) + 1 : value;
+}
+
+static int decodeHuffman(JpegBitReader *reader, const JpegHuffmanTable *table)
+{
+  fillBits(reader);
+  uint32_t peek = reader->bits >> 16;
+  uint16_t fast = table->fast[peek >> (16 - JPEG_FAST_BITS)];
+  if (fast != 0)
+  {
+    int length = fast >> 8;
+    reader->bits <<= length;
+    reader->count -= length;
+    return fast & 0xFF;
+  }
+  int length = JPEG_FAST_BITS + 1;
+  while (length <= 16 && (int32_t)peek >= table->maxCode[length])
+  {
+    length++;
+  }
+  if (length > 16)
+  {
+    return -1; // Not a valid code
+  }
+  int code = (int)(peek >> (16 - length));
+  reader->bits <<= length;
+  reader->count -= length;
+  return table->values[code + table->valueDelta[length]];
+}
+
+// Integer inverse DCT of jidctint.c (islow): constants scaled by 4096, the column pass keeps 2 extra bits
+struct IdctTerms
+{
+  int x0, x1, x2, x3; // Even part
+  int t0, t1, t2, t3; // Odd part
+};
+
+static inline IdctTerms idct1D(int s0, int s1, int s2, int s3, int s4, int s5, int s6, int s7)
+{
+  IdctTerms terms;
+  int p1 = (s2 + s6) * 2217;
+  int t2 = p1 - s6 * 7568;
+  int t3 = p1 + s2 * 3135;
+  int t0 = (s0 + s4) * 4096;
+  int t1 = (s0 - s4) * 4096;
+  terms.x0 = t0 + t3;
+  terms.x3 = t0 - t3;
+  terms.x1 = t1 + t2;
+  terms.x2 = t1 - t2;
+
+  int p3 = s7 + s3;
+  int p4 = s5 + s1;
+  p1 = s7 + s1;
+  int p2 = s5 + s3;
+  int p5 = (p3 + p4) * 4816;
+  p1 = p5 - p1 * 3686;
+  p2 = p5 - p2 * 10498;
+  p3 = -p3 * 8035;
+  p4 = -p4 * 1598;
+  terms.t0 = s7 * 1223 + p1 + p3;
+  terms.t1 = s5 * 8410 + p2 + p4;
+  terms.t2 = s3 * 12586 + p2 + p3;
+  terms.t3 = s1 * 6149 + p1 + p4;
+  return terms;
+}
+
+static inline uint8_t clampSample(int value)
+{
+  return value < 0 ? 0 : (value > 255 ? 255 : (uint8_t)value);
+}
+
+static void inverseDct(const int16_t *coefficients, uint8_t *out)
+{
+  int temp[64];
+  for (int column = 0; column < 8; ++column)
+  {
+    const int16_t *in = coefficients + column;
+    if (in[8] == 0 && in[16] == 0 && in[24] == 0 && in[32] == 0 && in[40] == 0 && in[48] == 0 && in[56] == 0)
+    {
+      int dc = in[0] * 4; // Flat column, very common in map tiles
+      for (int row = 0; row < 8; ++row)
+      {
+        temp[row * 8 + column] = dc;
+      }
+      continue;
+    }
+    IdctTerms terms = idct1D(in[0], in[8], in[16], in[24], in[32], in[40], in[48], in[56]);
+    terms.x0 += 512;
+    terms.x1 += 512;
+    terms.x2 += 512;
+    terms.x3 += 512;
+    temp[0 * 8 + column] = (terms.x0 + terms.t3) >> 10;
+    temp[7 * 8 + column] = (terms.x0 - terms.t3) >> 10;
+    temp[1 * 8 + column] = (terms.x1 + terms.t2) >> 10;
+    temp[6 * 8 + column] = (terms.x1 - terms.t2) >> 10;
+    temp[2 * 8 + column] = (terms.x2 + terms.t1) >> 10;
+    temp[5 * 8 + column] = (terms.x2 - terms.t1) >> 10;
+    temp[3 * 8 + column] = (terms.x3 + terms.t0) >> 10;
+    temp[4 * 8 + column] = (terms.x3 - terms.t0) >> 10;
+  }
+  for (int row = 0; row < 8; ++row)
+  {
+    const int *in = temp + row * 8;
+    uint8_t *outRow = out + row * 8;
+    IdctTerms terms = idct1D(in[0], in[1], in[2], in[3], in[4], in[5], in[6], in[7]);
+    // Rounding and the +128 level shift in one constant
+    const int bias = 65536 + (128 << 17);
+    terms.x0 += bias;
+    terms.x1 += bias;
+    terms.x2 += bias;
+    terms.x3 += bias;
+    outRow[0] = clampSample((terms.x0 + terms.t3) >> 17);
+    outRow[7] = clampSample((terms.x0 - terms.t3) >> 17);
+    outRow[1] = clampSample((terms.x1 + terms.t2) >> 17);
+    outRow[6] = clampSample((terms.x1 - terms.t2) >> 17);
+    outRow[2] = clampSample((terms.x2 + terms.t1) >> 17);
+    outRow[5] = clampSample((terms.x2 - terms.t1) >> 17);
+    outRow[3] = clampSample((terms.x3 + terms.t0) >> 17);
+    outRow[4] = clampSample((terms.x3 - terms.t0) >> 17);
+  }
+}
+
+static bool parseFrame(const uint8_t *segment, size_t size, BaselineJpegInfo *info, JpegDecoder *decoder)
+{
+  if (size < 6 || segment[0] != 8)
+  {
+    return false; // 12-bit samples
+  }
+  int height = readUint16(segment + 1);
+  int width = readUint16(segment + 3);
+  int componentCount = segment[5];
+  if (width == 0 || height == 0 || (componentCount != 1 && componentCount != 3) || size < 6 + 3 * (size_t)componentCount)
+  {
+    return false; // Height defined later by DNL, or CMYK
+  }
+  if (componentCount == 3)
+  {
+    // Full resolution chroma, or luma sampled twice horizontally and/or vertically
+    int lumaH = segment[7] >> 4;
+    int lumaV = segment[7] & 0x0F;
+    if (lumaH < 1 || lumaH > 2 || lumaV < 1 || lumaV > 2 || segment[10] != 0x11 || segment[13] != 0x11)
+    {
+      return false;
+    }
+  }
+  if (info != nullptr)
+  {
+    info->width = width;
+    info->height = height;
+    info->components = componentCount;
+  }
+  if (decoder == nullptr)
+  {
+    return true;
+  }
+
+  decoder->width = width;
+  decoder->height = height;
+  decoder->componentCount = componentCount;
+  decoder->hMax = 1;
+  decoder->vMax = 1;
+  for (int i = 0; i < componentCount; ++i)
+  {
+    const uint8_t *spec = segment + 6 + 3 * i;
+    JpegComponent &component = decoder->components[i];
+    component.id = spec[0];
+    // A single component scan is not interleaved, one block per MCU whatever the sampling factors say
+    component.h = componentCount == 1 ? 1 : spec[1] >> 4;
+    component.v = componentCount == 1 ? 1 : spec[1] & 0x0F;
+    component.quantTable = spec[2];
+    if (component.quantTable > 3)
+    {
+      return false;
+    }
+    decoder->hMax = component.h > decoder->hMax ? component.h : decoder->hMax;
+    decoder->vMax = component.v > decoder->vMax ? component.v : decoder->vMax;
+  }
+  return true;
+}
+
+static bool parseHuffmanTables(const uint8_t *segment, size_t size, JpegDecoder *decoder)
+{
+  size_t position = 0;
+  while (position + 17 <= size)
+  {
+    int tableClass = segment[position] >> 4;
+    int tableId = segment[position] & 0x0F;
+    if (tableClass > 1 || tableId > 1)
+    {
+      return false; // Not baseline
+    }
+    const uint8_t *counts = segment + position + 1;
+    int valueCount = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+      valueCount += counts[i];
+    }
+    position += 17;
+    if (valueCount > 256 || position + valueCount > size)
+    {
+      return false;
+    }
+    JpegHuffmanTable *table = tableClass == 0 ? &decoder->dcTables[tableId] : &decoder->acTables[tableId];
+    if (!buildHuffmanTable(table, counts, segment + position, valueCount))
+    {
+      return false;
+    }
+    position += valueCount;
+  }
+  return position == size;
+}
+
+static bool parseQuantTables(const uint8_t *segment, size_t size, JpegDecoder *decoder)
+{
+  size_t position = 0;
+  while (position < size)
+  {
+    int precision = segment[position] >> 4;
+    int tableId = segment[position] & 0x0F;
+    size_t tableSize = precision == 0 ? 64 : 128;
+    position++;
+    if (precision > 1 || tableId > 3 || position + tableSize > size)
+    {
+      return false;
+    }
+    for (int i = 0; i < 64; ++i)
+    {
+      decoder->quantTables[tableId][i] = precision == 0 ? segment[position + i] : (uint16_t)readUint16(segment + position + 2 * i);
+    }
+    decoder->quantDefined[tableId] = true;
+    position += tableSize;
+  }
+  return true;
+}
+
+static bool parseScan(const uint8_t *segment, size_t size, JpegDecoder *decoder)
+{
+  int scanComponents = size > 0 ? segment[0] : 0;
+  if (scanComponents != decoder->componentCount || size < 4 + 2 * (size_t)scanComponents)
+  {
+    return false; // One scan per component is not supported
+  }
+  for (int i = 0; i < scanComponents; ++i)
+  {
+    int id = segment[1 + 2 * i];
+    int tables = segment[2 + 2 * i];
+    JpegComponent *component = nullptr;
+    for (int c = 0; c < decoder->componentCount; ++c)
+    {
+      if (decoder->components[c].id == id)
+      {
+        component = &decoder->components[c];
+      }
+    }
+    if (component == nullptr)
+    {
+      return false;
+    }
+    component->dcTable = tables >> 4;
+    component->acTable = tables & 0x0F;
+    component->dcPredictor = 0;
+    if (component->dcTable > 1 || component->acTable > 1 || !decoder->dcTables[component->dcTable].defined ||
+        !decoder->acTables[component->acTable].defined || !decoder->quantDefined[component->quantTable])
+    {
+      return false;
+    }
+  }
+  // Spectral selection 0..63 and no successive approximation
+  const uint8_t *selection = segment + 1 + 2 * scanComponents;
+  return selection[0] == 0 && selection[1] == 63 && selection[2] == 0;
+}
+
+// Walk the markers up to the first scan. Without a decoder only the frame header is read.
+static bool parseHeaders(const uint8_t *data, size_t length, BaselineJpegInfo *info, JpegDecoder *decoder)
+{
+  if (length < 4 || data[0] != 0xFF || data[1] != 0xD8)
+  {
+    return false;
+  }
+  bool frameSeen = false;
+  size_t position = 2;
+  while (position + 4 <= length)
+  {
+    if (data[position] != 0xFF)
+    {
+      return false;
+    }
+    uint8_t marker = data[position + 1];
+    if (marker == 0xFF)
+    {
+      position++; // Fill byte
+      continue;
+    }
+    size_t segmentLength = readUint16(data + position + 2);
+    if (segmentLength < 2 || position + 2 + segmentLength > length)
+    {
+      return false;
+    }
+    const uint8_t *segment = data + position + 4;
+    size_t segmentSize = segmentLength - 2;
+
+    if (marker == 0xC0 || marker == 0xC1)
+    {
+      if (frameSeen || !parseFrame(segment, segmentSize, info, decoder))
+      {
+        return false;
+      }
+      if (decoder == nullptr)
+      {
+        return true;
+      }
+      frameSeen = true;
+    }
+    else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4)
+    {
+      return false; // Progressive, lossless or arithmetic coding
+    }
+    else if (marker == 0xD9)
+    {
+      return false; // End of image before the first scan
+    }
+    else if (decoder != nullptr)
+    {
+      bool valid = true;
+      switch (marker)
+      {
+      case 0xC4:
+        valid = parseHuffmanTables(segment, segmentSize, decoder);
+        break;
+      case 0xDB:
+        valid = parseQuantTables(segment, segmentSize, decoder);
+        break;
+      case 0xDD:
+        valid = segmentSize >= 2;
+        decoder->restartInterval = valid ? readUint16(segment) : 0;
+        break;
+      case 0xDA:
+        if (!frameSeen || !parseScan(segment, segmentSize, decoder))
+        {
+          return false;
+        }
+        decoder->scanOffset = position + 2 + segmentLength;
+        return true;
+      default:
+        break; // APPn, COM
+      }
+      if (!valid)
+      {
+        return false;
+      }
+    }
+    position += 2 + segmentLength;
+  }
+  return false;
+}
+
+static bool decodeBlock(JpegDecoder *decoder, JpegComponent *component, uint8_t *out)
+{
+  JpegBitReader *reader = &decoder->reader;
+  const uint16_t *quant = decoder->quantTables[component->quantTable];
+  int16_t *coefficients = decoder->coefficients;
+  memset(coefficients, 0, sizeof(decoder->coefficients));
+
+  int category = decodeHuffman(reader, &decoder->dcTables[component->dcTable]);
+  if (category < 0 || category > 11)
+  {
+    return false;
+  }
+  if (category > 0)
+  {
+    component->dcPredictor += extendValue(getBits(reader, category), category);
+  }
+  coefficients[0] = (int16_t)(component->dcPredictor * quant[0]);
+
+  const JpegHuffmanTable *acTable = &decoder->acTables[component->acTable];
+  for (int k = 1; k < 64;)
+  {
+    int symbol = decodeHuffman(reader, acTable);
+    if (symbol < 0)
+    {
+      return false;
+    }
+    int run = symbol >> 4;
+    int size = symbol & 0x0F;
+    if (size == 0)
+    {
+      if (run != 15)
+      {
+        break; // End of block
+      }
+      k += 16;
+      continue;
+    }
+    k += run;
+    if (k > 63)
+    {
+      return false;
+    }
+    coefficients[zigzagOrder[k]] = (int16_t)(extendValue(getBits(reader, size), size) * quant[k]);
+    k++;
+  }
+  inverseDct(coefficients, out);
+  return true;
+}
+
+// Skip to behind the next RSTn marker and reset the predictors
+static void restartDecoder(JpegDecoder *decoder)
+{
+  JpegBitReader *reader = &decoder->reader;
+  size_t position = reader->position;
+  while (position + 1 < reader->length &&
+         !(reader->data[position] == 0xFF && reader->data[position + 1] >= 0xD0 && reader->data[position + 1] <= 0xD7))
+  {
+    position++;
+  }
+  reader->position = position + 2;
+  reader->bits = 0;
+  reader->count = 0;
+  reader->marker = false;
+  for (int i = 0; i < decoder->componentCount; ++i)
+  {
+    decoder->components[i].dcPredictor = 0;
+  }
+}
+
+static inline uint16_t packSwapped565(int r, int g, int b)
+{
+  uint16_t color = (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+  return (uint16_t)((color >> 8) | (color << 8)); // lgfx::swap565_t byte order
+}
+
+static void writeMcu(const JpegDecoder *decoder, int mcuX, int mcuY, uint16_t *pixels)
+{
+  int mcuWidth = 8 * decoder->hMax;
+  int mcuHeight = 8 * decoder->vMax;
+  int left = mcuX * mcuWidth;
+  int top = mcuY * mcuHeight;
+  int columns = decoder->width - left < mcuWidth ? decoder->width - left : mcuWidth;
+  int rows = decoder->height - top < mcuHeight ? decoder->height - top : mcuHeight;
+
+  if (decoder->componentCount == 1)
+  {
+    const uint8_t *luma = decoder->blocks[0];
+    for (int y = 0; y < rows; ++y)
+    {
+      uint16_t *out = pixels + (size_t)(top + y) * decoder->width + left;
+      for (int x = 0; x < columns; ++x)
+      {
+        int value = luma[y * 8 + x];
+        out[x] = packSwapped565(value, value, value);
+      }
+    }
+    return;
+  }
+
+  // Chroma contribution of each chroma sample, shared by the luma samples it covers (16-bit fixed point, BT.601)
+  int lumaBlocks = decoder->hMax * decoder->vMax;
+  const uint8_t *cbBlock = decoder->blocks[lumaBlocks];
+  const uint8_t *crBlock = decoder->blocks[lumaBlocks + 1];
+  int redTerm[64];
+  int greenTerm[64];
+  int blueTerm[64];
+  for (int i = 0; i < 64; ++i)
+  {
+    int cb = cbBlock[i] - 128;
+    int cr = crBlock[i] - 128;
+    redTerm[i] = (91881 * cr + 32768) >> 16;
+    greenTerm[i] = (-22554 * cb - 46802 * cr + 32768) >> 16;
+    blueTerm[i] = (116130 * cb + 32768) >> 16;
+  }
+
+  int hShift = decoder->hMax - 1; // Chroma is upsampled by replication
+  int vShift = decoder->vMax - 1;
+  for (int y = 0; y < rows; ++y)
+  {
+    uint16_t *out = pixels + (size_t)(top + y) * decoder->width + left;
+    const uint8_t *lumaRow = decoder->blocks[(y >> 3) * decoder->hMax] + (y & 7) * 8;
+    int chromaRow = (y >> vShift) * 8;
+    for (int x = 0; x < columns; ++x)
+    {
+      int luma = lumaRow[(x >> 3) * 64 + (x & 7)];
+      int chroma = chromaRow + (x >> hShift);
+      out[x] = packSwapped565(clampSample(luma + redTerm[chroma]), clampSample(luma + greenTerm[chroma]),
+                              clampSample(luma + blueTerm[chroma]));
+    }
+  }
+}
+
+bool baselineJpegInfo(const uint8_t *data, size_t length, BaselineJpegInfo *info)
+{
+  return parseHeaders(data, length, info, nullptr);
+}
+
+bool baselineJpegDecode(const uint8_t *data, size_t length, uint16_t *pixels, int width, int height)
+{
+  JpegDecoder *decoder = (JpegDecoder *)malloc(sizeof(JpegDecoder)); // About 5 KB, too much for the task stacks
+  if (decoder == nullptr)
+  {
+    return false;
+  }
+  memset(decoder, 0, sizeof(JpegDecoder));
+  bool decoded = parseHeaders(data, length, nullptr, decoder) && decoder->width == width && decoder->height == height;
+  if (decoded)
+  {
+    decoder->reader.data = data;
+    decoder->reader.length = length;
+    decoder->reader.position = decoder->scanOffset;
+
+    int mcusX = (width + 8 * decoder->hMax - 1) / (8 * decoder->hMax);
+    int mcusY = (height + 8 * decoder->vMax - 1) / (8 * decoder->vMax);
+    int untilRestart = decoder->restartInterval;
+    for (int mcuY = 0; mcuY < mcusY && decoded; ++mcuY)
+    {
+      for (int mcuX = 0; mcuX < mcusX && decoded; ++mcuX)
+      {
+        if (decoder->restartInterval > 0 && untilRestart-- == 0)
+        {
+          restartDecoder(decoder);
+          untilRestart = decoder->restartInterval - 1;
+        }
+        int block = 0;
+        for (int c = 0; c < decoder->componentCount && decoded; ++c)
+        {
+          JpegComponent *component = &decoder->components[c];
+          for (int i = 0; i < component->h * component->v && decoded; ++i)
+          {
+            decoded = decodeBlock(decoder, component, decoder->blocks[block++]);
+          }
+        }
+        if (decoded)
+        {
+          writeMcu(decoder, mcuX, mcuY, pixels);
+        }
+      }
+    }
+  }
+  free(decoder);
+  return decoded;
+}
@@ -0,0 +1,25 @@
+#ifndef BASELINE_JPEG_H
+#define BASELINE_JPEG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Software decoder for baseline (sequential, Huffman coded, 8-bit) JPEG tiles. Decodes MCU by MCU straight into a
+// byte-swapped RGB565 buffer, the pixel format of M5Canvas sprites and of the tile cache slots, without a full
+// frame intermediate. Grayscale and YCbCr with 4:4:4, 4:2:2 or 4:2:0 sampling; chroma is upsampled by replication.
+// Progressive, arithmetic coded, 12-bit and multi-scan files are rejected so the caller can fall back.
+// No Arduino dependencies, the native tests build it too. Thread-safe: the working state is allocated per call.
+
+struct BaselineJpegInfo
+{
+  int width;
+  int height;
+  int components; // 1 = grayscale, 3 = YCbCr
+};
+
+// Parse the headers up to the first scan. Returns false if the data is not a baseline JPEG this decoder handles.
+bool baselineJpegInfo(const uint8_t *data, size_t length, BaselineJpegInfo *info);
+// Decode into pixels (width * height RGB565 words, byte-swapped). width and height must match the image.
+bool baselineJpegDecode(const uint8_t *data, size_t length, uint16_t *pixels, int width, int height);
+
+#endif // BASELINE_JPEG_H
@@ -0,0 +1,232 @@
+#include "compositor.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <algorithm> // For std::max
+#include "config.h"
+#include "compositor_regions.h"
+
+struct CompositorLayer
+{
+  M5Canvas *canvas;
+  int x;
+  int y;
+  bool visible;
+};
+
+// A composed frame waiting for the flush task
+struct CompositorFrame
+{
+  int buffer;
+  int regionCount;
+  CompositorRect regions[COMPOSITOR_MAX_DIRTY_RECTS];
+};
+
+static const int FRAME_BUFFER_COUNT = 2;
+
+static LovyanGFX *compositorDisplay = nullptr;
+static M5Canvas frameCanvases[FRAME_BUFFER_COUNT]; // Composed screen content, regions are pushed from here
+static SemaphoreHandle_t frameBufferFree[FRAME_BUFFER_COUNT]; // Given by the flush task once a buffer is on screen
+static QueueHandle_t frameQueue = nullptr;
+static int backBuffer = 0;
+static CompositorLayer layers[COMPOSITOR_MAX_LAYERS];
+static int layerCount = 0;
+static CompositorDirtyList dirtyList = {};
+// Regions of the previous frame: the back buffer still holds the content from before them
+static CompositorDirtyList previousList = {};
+static TickType_t lastFrameTick = 0;
+static uint32_t lastFrameUs = 0;
+static CompositorStats compositorStats = {};
+static portMUX_TYPE compositorStatsMux = portMUX_INITIALIZER_UNLOCKED;
+
+bool initCompositor(LovyanGFX *display)
+{
+  compositorDisplay = display;
+  for (int i = 0; i < FRAME_BUFFER_COUNT; ++i)
+  {
+    frameCanvases[i].setPsram(true);
+    if (frameCanvases[i].createSprite(display->width(), display->height()) == nullptr)
+    {
+      ESP_LOGE("Compositor", "Failed to allocate the %ldx%ld frame buffers.", display->width(), display->height());
+      return false;
+    }
+    frameCanvases[i].fillSprite(TFT_BLACK);
+    frameBufferFree[i] = xSemaphoreCreateBinary();
+    xSemaphoreGive(frameBufferFree[i]);
+  }
+  frameQueue = xQueueCreate(FRAME_BUFFER_COUNT, sizeof(CompositorFrame));
+  ESP_LOGI("Compositor", "Compositor initialized, %d frames of %ldx%ld, %d fps.", FRAME_BUFFER_COUNT,
+           display->width(), display->height(), COMPOSITOR_TARGET_FPS);
+  return true;
+}
+
+void compositorFlushTask(void *pvParameters)
+{
+  (void)pvParameters; // Suppress unused parameter warning
+
+  CompositorFrame frame;
+  for (;;)
+  {
+    if (xQueueReceive(frameQueue, &frame, portMAX_DELAY) != pdTRUE)
+    {
+      continue;
+    }
+
+    uint32_t startUs = micros();
+    uint64_t pixels = 0;
+    for (int i = 0; i < frame.regionCount; ++i)
+    {
+      const CompositorRect &rect = frame.regions[i];
+      // Push the region once, in one transaction
+      compositorDisplay->startWrite();
+      compositorDisplay->setClipRect(rect.x, rect.y, rect.w, rect.h);
+      frameCanvases[frame.buffer].pushSprite(compositorDisplay, 0, 0);
+      compositorDisplay->clearClipRect();
+      compositorDisplay->endWrite();
+      pixels += (uint64_t)rect.w * rect.h;
+    }
+    uint32_t flushUs = micros() - startUs;
+    xSemaphoreGive(frameBufferFree[frame.buffer]);
+
+    portENTER_CRITICAL(&compositorStatsMux);
+    compositorStats.regions += frame.regionCount;
+    compositorStats.pixels += pixels;
+    compositorStats.lastFlushUs = flushUs;
+    compositorStats.maxFlushUs = std::max(compositorStats.maxFlushUs, flushUs);
+    portEXIT_CRITICAL(&compositorStatsMux);
+  }
+}
+
+int compositorAddLayer(M5Canvas *canvas, int x, int y)
+{
+  if (layerCount == COMPOSITOR_MAX_LAYERS)
+  {
+    ESP_LOGE("Compositor", "Too many layers, increase COMPOSITOR_MAX_LAYERS.");
+    return -1;
+  }
+  if (canvas->getColorDepth() != 16)
+  {
+    ESP_LOGE("Compositor", "Layers are copied as RGB565, the canvas has %d bits per pixel.", canvas->getColorDepth());
+    return -1;
+  }
+  layers[layerCount] = {canvas, x, y, true};
+  return layerCount++;
+}
+
+void compositorSetLayerPosition(int layer, int x, int y)
+{
+  if (layer < 0 || (layers[layer].x == x && layers[layer].y == y))
+  {
+    return;
+  }
+  compositorMarkDirty(layer); // Uncovered area
+  layers[layer].x = x;
+  layers[layer].y = y;
+  compositorMarkDirty(layer);
+}
+
+void compositorSetLayerVisible(int layer, bool visible)
+{
+  if (layer < 0 || layers[layer].visible == visible)
+  {
+    return;
+  }
+  layers[layer].visible = visible;
+  compositorMarkDirty(layer);
+}
+
+void compositorMarkDirty(int layer)
+{
+  if (layer < 0)
+  {
+    return;
+  }
+  compositorMarkDirtyRect(layer, 0, 0, layers[layer].canvas->width(), layers[layer].canvas->height());
+}
+
+void compositorMarkDirtyRect(int layer, int x, int y, int w, int h)
+{
+  if (layer < 0 || compositorDisplay == nullptr)
+  {
+    return;
+  }
+  compositorDirtyAdd(&dirtyList, {layers[layer].x + x, layers[layer].y + y, w, h}, compositorDisplay->width(),
+                     compositorDisplay->height());
+}
+
+int compositorFlush()
+{
+  if (dirtyList.count == 0 || frameQueue == nullptr)
+  {
+    return 0;
+  }
+
+  // Pace to the target frame rate. After an idle period the next frame goes out at once.
+  bool paced = false;
+  const TickType_t framePeriod = pdMS_TO_TICKS(1000 / COMPOSITOR_TARGET_FPS);
+  TickType_t now = xTaskGetTickCount();
+  if (now - lastFrameTick < framePeriod)
+  {
+    vTaskDelayUntil(&lastFrameTick, framePeriod);
+    paced = true;
+  }
+  else
+  {
+    lastFrameTick = now;
+  }
+
+  // Wait until the flush task is done with the back buffer
+  bool blocked = false;
+  if (xSemaphoreTake(frameBufferFree[backBuffer], 0) != pdTRUE)
+  {
+    blocked = true;
+    xSemaphoreTake(frameBufferFree[backBuffer], portMAX_DELAY);
+  }
+
+  uint32_t startUs = micros();
+  // Layer buffers are read in place, both they and the frame buffers hold RGB565 in the same byte order
+  CompositorSurface surfaces[COMPOSITOR_MAX_LAYERS];
+  for (int i = 0; i < layerCount; ++i)
+  {
+    const CompositorLayer &layer = layers[i];
+    surfaces[i] = {(const uint16_t *)layer.canvas->getBuffer(), (int)layer.canvas->width(), (int)layer.canvas->height(),
+                   layer.x, layer.y, layer.visible};
+  }
+  CompositorFrame frame;
+  frame.buffer = backBuffer;
+  frame.regionCount = compositorComposeFrame((uint16_t *)frameCanvases[backBuffer].getBuffer(), compositorDisplay->width(),
+                                             surfaces, layerCount, &dirtyList, &previousList, TFT_BLACK);
+  for (int i = 0; i < frame.regionCount; ++i)
+  {
+    frame.regions[i] = previousList.rects[i];
+  }
+  uint32_t composeUs = micros() - startUs;
+
+  xQueueSend(frameQueue, &frame, portMAX_DELAY);
+  backBuffer = (backBuffer + 1) % FRAME_BUFFER_COUNT;
+
+  uint32_t frameUs = micros();
+  portENTER_CRITICAL(&compositorStatsMux);
+  if (compositorStats.frames > 0)
+  {
+    uint32_t intervalUs = frameUs - lastFrameUs;
+    compositorStats.frameIntervalUs += intervalUs;
+    compositorStats.maxFrameIntervalUs = std::max(compositorStats.maxFrameIntervalUs, intervalUs);
+  }
+  compositorStats.frames++;
+  compositorStats.lastComposeUs = composeUs;
+  compositorStats.maxComposeUs = std::max(compositorStats.maxComposeUs, composeUs);
+  compositorStats.pacedFrames += paced ? 1 : 0;
+  compositorStats.blockedFrames += blocked ? 1 : 0;
+  portEXIT_CRITICAL(&compositorStatsMux);
+  lastFrameUs = frameUs;
+  return frame.regionCount;
+}
+
+void compositorGetStats(CompositorStats *stats)
+{
+  portENTER_CRITICAL(&compositorStatsMux);
+  *stats = compositorStats;
+  portEXIT_CRITICAL(&compositorStatsMux);
+}
@@ -0,0 +1,47 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <Arduino.h>
+#include <M5Unified.h>
+#include <stdint.h>
+
+#include "compositor_regions.h"
+
+// Frame compositor for the map and the HUD widgets. Every widget canvas (16-bit) is a layer at a fixed screen
+// position; layers added later are drawn on top. Drawing code only marks layers dirty, compositorFlush() then
+// composes each changed screen region once from all layers covering it into one of two frame buffers.
+// compositorFlushTask pushes that frame to the display, each region in a single transaction, while the next frame
+// is prepared. Frames are paced to COMPOSITOR_TARGET_FPS.
+// The region merging and the composition itself are in compositor_regions.cpp and tested on the host
+// (test_compositor); this file adds the layers, the pacing and the FreeRTOS flush task.
+
+struct CompositorStats
+{
+  uint32_t frames;            // Submitted frames
+  uint32_t regions;           // Pushed screen regions
+  uint64_t pixels;            // Pushed pixels
+  uint32_t lastComposeUs;     // Time to compose the last frame into the back buffer
+  uint32_t maxComposeUs;
+  uint32_t lastFlushUs;       // Time to push the last frame to the display
+  uint32_t maxFlushUs;
+  uint64_t frameIntervalUs;   // Sum of the intervals between submitted frames, average = / (frames - 1)
+  uint32_t maxFrameIntervalUs;
+  uint32_t pacedFrames;       // Frames delayed to keep the target frame rate
+  uint32_t blockedFrames;     // Frames that waited for the display to finish the previous one
+};
+
+// Allocate the two full screen frame buffers (PSRAM). Call once before adding layers and starting the flush task.
+bool initCompositor(LovyanGFX *display);
+void compositorFlushTask(void *pvParameters);
+// Register a 16-bit canvas at a screen position. Returns the layer id, -1 on failure.
+int compositorAddLayer(M5Canvas *canvas, int x, int y);
+void compositorSetLayerPosition(int layer, int x, int y);
+void compositorSetLayerVisible(int layer, bool visible);
+// Mark a whole layer, or a rectangle in layer coordinates, as changed
+void compositorMarkDirty(int layer);
+void compositorMarkDirtyRect(int layer, int x, int y, int w, int h);
+// Compose all dirty regions into the back buffer and hand it to the flush task. Returns the number of regions.
+int compositorFlush();
+void compositorGetStats(CompositorStats *stats);
+
+#endif // COMPOSITOR_H
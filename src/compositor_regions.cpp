@@ -0,0 +1,112 @@
+#include "compositor_regions.h"
+#include <string.h>  // For memcpy
+#include <algorithm> // For std::min, std::max, std::fill
+
+bool compositorRectsTouch(const CompositorRect &a, const CompositorRect &b)
+{
+  return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+static CompositorRect rectUnion(const CompositorRect &a, const CompositorRect &b)
+{
+  int left = std::min(a.x, b.x);
+  int top = std::min(a.y, b.y);
+  int right = std::max(a.x + a.w, b.x + b.w);
+  int bottom = std::max(a.y + a.h, b.y + b.h);
+  return {left, top, right - left, bottom - top};
+}
+
+// Overlapping part of two rectangles, false if they do not overlap
+static bool rectIntersection(const CompositorRect &a, const CompositorRect &b, CompositorRect *out)
+{
+  int left = std::max(a.x, b.x);
+  int top = std::max(a.y, b.y);
+  int right = std::min(a.x + a.w, b.x + b.w);
+  int bottom = std::min(a.y + a.h, b.y + b.h);
+  if (right <= left || bottom <= top)
+  {
+    return false;
+  }
+  *out = {left, top, right - left, bottom - top};
+  return true;
+}
+
+void compositorDirtyAdd(CompositorDirtyList *list, CompositorRect rect, int screenWidth, int screenHeight)
+{
+  // Clip to the screen
+  CompositorRect screen = {0, 0, screenWidth, screenHeight};
+  if (!rectIntersection(rect, screen, &rect))
+  {
+    return;
+  }
+
+  // Merging can make the result touch rectangles that were separate before, so repeat until stable
+  bool merged = true;
+  while (merged)
+  {
+    merged = false;
+    for (int i = 0; i < list->count; ++i)
+    {
+      if (compositorRectsTouch(rect, list->rects[i]))
+      {
+        rect = rectUnion(rect, list->rects[i]);
+        list->rects[i] = list->rects[--list->count];
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  if (list->count == COMPOSITOR_MAX_DIRTY_RECTS)
+  {
+    // List full: fold everything into one region
+    for (int i = 0; i < list->count; ++i)
+    {
+      rect = rectUnion(rect, list->rects[i]);
+    }
+    list->count = 0;
+  }
+  list->rects[list->count++] = rect;
+}
+
+void compositorComposeRegion(uint16_t *target, int screenWidth, const CompositorSurface *layers, int layerCount,
+                             const CompositorRect &rect, uint16_t background)
+{
+  for (int y = rect.y; y < rect.y + rect.h; ++y)
+  {
+    uint16_t *row = target + (size_t)y * screenWidth + rect.x;
+    std::fill(row, row + rect.w, background);
+  }
+  for (int layer = 0; layer < layerCount; ++layer)
+  {
+    const CompositorSurface &surface = layers[layer];
+    CompositorRect area;
+    if (!surface.visible || surface.pixels == nullptr ||
+        !rectIntersection(rect, {surface.x, surface.y, surface.width, surface.height}, &area))
+    {
+      continue;
+    }
+    // Layers are opaque: one row copy per line of the covered area
+    for (int y = area.y; y < area.y + area.h; ++y)
+    {
+      const uint16_t *source = surface.pixels + (size_t)(y - surface.y) * surface.width + (area.x - surface.x);
+      memcpy(target + (size_t)y * screenWidth + area.x, source, area.w * sizeof(uint16_t));
+    }
+  }
+}
+
+int compositorComposeFrame(uint16_t *target, int screenWidth, const CompositorSurface *layers, int layerCount,
+                           CompositorDirtyList *dirty, CompositorDirtyList *previous, uint16_t background)
+{
+  for (int i = 0; i < previous->count; ++i)
+  {
+    compositorComposeRegion(target, screenWidth, layers, layerCount, previous->rects[i], background); // Catch up
+  }
+  for (int i = 0; i < dirty->count; ++i)
+  {
+    compositorComposeRegion(target, screenWidth, layers, layerCount, dirty->rects[i], background);
+  }
+  *previous = *dirty;
+  dirty->count = 0;
+  return previous->count;
+}
@@ -0,0 +1,53 @@
+#ifndef COMPOSITOR_REGIONS_H
+#define COMPOSITOR_REGIONS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <M5Unified.h>
+#include "config.h" // For COMPOSITOR_MAX_DIRTY_RECTS
+
+// Dirty region bookkeeping and composition of the compositor, on plain RGB565 buffers. No FreeRTOS or display
+// dependencies: compositor.cpp runs it on the frame buffers, the native test test_compositor on memory buffers.
+
+struct CompositorRect
+{
+  int x;
+  int y;
+  int w;
+  int h;
+};
+
+// A layer as the compose step sees it: an opaque 16-bit canvas buffer at a screen position
+struct CompositorSurface
+{
+  const uint16_t *pixels;
+  int width;
+  int height;
+  int x;
+  int y;
+  bool visible;
+};
+
+// Changed screen regions of one frame
+struct CompositorDirtyList
+{
+  CompositorRect rects[COMPOSITOR_MAX_DIRTY_RECTS];
+  int count;
+};
+
+// True if the rectangles overlap or share an edge
+bool compositorRectsTouch(const CompositorRect &a, const CompositorRect &b);
+// Add a screen rectangle, clipped to the screen and merged with every rectangle it touches. A full list is
+// folded into one region.
+void compositorDirtyAdd(CompositorDirtyList *list, CompositorRect rect, int screenWidth, int screenHeight);
+// Compose one screen region of target (screenWidth pixels per row) from the layers, bottom to top.
+// Pixels no visible layer covers are set to background.
+void compositorComposeRegion(uint16_t *target, int screenWidth, const CompositorSurface *layers, int layerCount,
+                             const CompositorRect &rect, uint16_t background);
+// Compose the dirty regions into the back buffer of a double buffered screen. The back buffer also missed the
+// regions of the frame composed into the other buffer; previous holds them and is replaced by the dirty regions,
+// which are the regions of this frame. The dirty list is cleared. Returns the number of regions of this frame.
+int compositorComposeFrame(uint16_t *target, int screenWidth, const CompositorSurface *layers, int layerCount,
+                           CompositorDirtyList *dirty, CompositorDirtyList *previous, uint16_t background);
+
+#endif // COMPOSITOR_REGIONS_H
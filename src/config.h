@@ -21,7 +21,7 @@ extern bool globalManualMapMode; // New: Flag to indicate if map is in manual dr
 const int MIN_ZOOM_LEVEL = 1;
 const int DEFAULT_MAP_ZOOM_LEVEL = 15;
 const int MAX_ZOOM_LEVEL = 19;
-const int ZOOM_THRESHOLD = 50; // Pixels for distance change to trigger zoom
+const int ZOOM_THRESHOLD = 50; // Pixels of finger distance change before a pinch starts scaling the map
 const int TOUCH_TASK_STACK_SIZE = 4096; // Stack size for touch monitoring task
 const int TOUCH_TASK_DELAY_MS = 20;    // Delay for touch monitoring task
 const int DOUBLE_TAP_THRESHOLD_MS = 300; // Time in ms to detect a double tap
@@ -43,15 +43,46 @@ const int BUTTON_TASK_STACK_SIZE = 2048; // New: Stack size for button monitorin
 const int BUTTON_TASK_DELAY_MS = 50;    // New: Delay for button monitoring task
 
 // GUI Constants
-const size_t TILE_CACHE_SIZE_BYTES = 1 * 1024 * 1024; // 1MB cache
+const size_t TILE_CACHE_TILE_BYTES = TILE_SIZE * TILE_SIZE * 2; // One decoded RGB565 tile (128KB)
+const size_t TILE_CACHE_SIZE_BYTES = 6 * 1024 * 1024; // 6MB PSRAM cache (48 tiles, 1MB could not even hold the 3x3 grid)
+const int TILE_CACHE_STATS_LOG_INTERVAL = 10; // Log cache counters every N map redraws
 const int SCREEN_BUFFER_TILE_DIMENSION = 4;
 const int TILE_PATH_MAX_LENGTH = 128;
+const size_t TILE_BLOB_MAX_BYTES = 192 * 1024; // Largest compressed tile (JPEG or PNG) read in one go
+const size_t TILE_EXISTENCE_MAX_BITMAP_BYTES = 2 * 1024 * 1024; // Larger zoom bitmaps fall back to index/SD lookups
+const int TILE_FALLBACK_MAX_LEVELS = 4; // Ancestor zoom levels searched for an upscaled placeholder or overzoom
+const int TILE_MISSING_CACHE_SIZE = 64; // Remembered missing tiles per layer without existence bitmap
+const int TILE_DECODER_BACKEND = 1; // 0 = M5GFX software decoders, 1 = ESP32-P4 hardware JPEG, 2 = baseline_jpeg.cpp (PNG stays on M5GFX)
+const int TILE_DECODER_HW_TIMEOUT_MS = 100;
 const int SCREEN_BUFFER_CENTER_OFFSET = 1;
 const int DRAW_GRID_DIMENSION = 3;
 const int DRAW_GRID_CENTER_OFFSET = 1;
+const bool MAP_INCREMENTAL_SCROLL = true; // Shift the tile grid on tile crossings and decode only the exposed row/column
+const bool MAP_SMOOTH_FOLLOW = true; // Re-center the map on every position update, not only on tile crossings
+const int MAP_ZOOM_PREVIEW_MAX_LEVELS = 2; // Zoom changes up to this many levels first show the current map rescaled (0 = off)
+const int COMPOSITOR_MAX_LAYERS = 8;
+const int COMPOSITOR_MAX_DIRTY_RECTS = 8; // Separate screen regions per frame, more are merged into one
+const int COMPOSITOR_TARGET_FPS = 30; // Upper bound of frames handed to the display
+const int COMPOSITOR_FLUSH_TASK_STACK_SIZE = 4096;
+const int COMPOSITOR_FLUSH_TASK_CORE = 0; // Display transfer runs beside the GUI task composing the next frame
 const int DRAW_IMAGE_TASK_DELAY_MS = 2000;
+const int GUI_TELEMETRY_QUEUE_DEPTH = 16; // Messages the GUI can fall behind by before the oldest are dropped
 const int GPS_FIX_CIRCLE_RADIUS = 5;
 
+// Telemetry Bus Constants
+const int TELEMETRY_MAX_SUBSCRIBERS = 8;
+
+// Tile Prefetch Constants
+const int PREFETCH_TASK_STACK_SIZE = 8192;
+const int PREFETCH_TASK_DELAY_MS = 500;        // Minimum interval between predictions
+const int PREFETCH_TELEMETRY_QUEUE_DEPTH = 2;  // Only the newest fix is used
+const int PREFETCH_TASK_CORE = 0;              // Decode on the core the GUI task does not use
+const double PREFETCH_MIN_SPEED_KMPH = 5.0;    // Below this speed nothing is prefetched
+const double PREFETCH_LOOKAHEAD_S = 30.0;      // How far ahead along the track tiles are predicted
+const int PREFETCH_MAX_LOOKAHEAD_TILES = 4;    // Upper bound of the lookahead distance in tiles
+const int PREFETCH_MAX_TILES_PER_CYCLE = 6;    // Decodes per prediction cycle
+const double EARTH_CIRCUMFERENCE_M = 40075016.686;
+
 // Arrow Constants
 const int ARROW_HEAD_LENGTH = 10;
 const int ARROW_HEAD_WIDTH = 10;
@@ -85,30 +116,72 @@ const int TEXT_ZONE_SPEED_Y = 0;
 const int TEXT_ZONE_ALTITUDE_X = TEXT_ZONE_WIDTH * 2;
 const int TEXT_ZONE_ALTITUDE_Y = 0;
 
+// Barometer Constants
+const int BARO_PRESSURE_RATE_HZ = 50;       // Pressure samples per second, up to ~100 at OSR 4096
+const int BARO_PRESSURE_OSR = 4;            // Ms5637Osr: 0 = 256 ... 4 = 4096 (8.2 ms), 5 = 8192 (16.4 ms)
+const int BARO_TEMPERATURE_OSR = 2;         // 1024 (2.1 ms), temperature changes slowly
+const int BARO_TEMPERATURE_DECIMATION = 10; // Pressure samples per temperature sample
+const unsigned long BARO_STATS_LOG_INTERVAL_MS = 10000;
+
 // Variometer Constants
 const float STANDARD_SEA_LEVEL_PRESSURE_HPA = 1013.25;
 const float ALTITUDE_CONSTANT_A = 44330.0;
 const float ALTITUDE_CONSTANT_B = 5.255;
+const float VARIO_QNH_HPA = 1013.25; // Sea level pressure of the barometric altitude; the fusion filter corrects a wrong QNH with GPS
+const float PRESSURE_ALTITUDE_MIN_HPA = 150.0; // Table range of the pressure to altitude kernel, about 13.6 km
+const float PRESSURE_ALTITUDE_STEP_HPA = 10.0; // Segment width; cubic segments keep the error far below a centimetre
+const int PRESSURE_ALTITUDE_SEGMENTS = 96;     // Up to 1110 hPa
 const int SPEAKER_DEFAULT_VOLUME = 64;
-const unsigned long VARIOMETER_UPDATE_INTERVAL_MS = 200;
 const float ALTITUDE_CHANGE_THRESHOLD_MPS = 0.5;
+const float VARIO_TONE_HYSTERESIS_MPS = 0.2; // A climb or sink tone stops this far inside the threshold that started it
 const int RISING_TONE_BASE_FREQ_HZ = 1000;
 const int RISING_TONE_MULTIPLIER_HZ_PER_MPS = 50;
-const int TONE_DURATION_MS = 50;
 const int SINKING_TONE_BASE_FREQ_HZ = 500;
 const int SINKING_TONE_MULTIPLIER_HZ_PER_MPS = 50;
 const int MIN_TONE_FREQ_HZ = 100;
-const int VARIOMETER_TASK_DELAY_MS = 50;
+const float VARIO_CLIMB_PERIOD_MS = 600;         // Beep period just above the climb threshold
+const float VARIO_CLIMB_PERIOD_MS_PER_MPS = 100; // Beeps get faster with the climb rate
+const float VARIO_CLIMB_MIN_PERIOD_MS = 150;
+const float VARIO_CLIMB_DUTY = 0.5;              // Fraction of the period the beep is on
+const float VARIO_SINK_ALARM_THRESHOLD_MPS = -4.0; // Below this the sink tone becomes a two-tone siren
+const float VARIO_SINK_ALARM_HIGH_HZ = 1200;
+const float VARIO_SINK_ALARM_LOW_HZ = 700;
+const float VARIO_SINK_ALARM_PERIOD_MS = 400;
+const float VARIO_TONE_GLIDE_MS = 30; // Time constant of the pitch glide
+const float VARIO_TONE_RAMP_MS = 4;   // Fade in and out of every beep against clicks
+const int16_t VARIO_TONE_AMPLITUDE = 12000;
+
+// Vario Audio
+const uint32_t VARIO_AUDIO_SAMPLE_RATE = 16000;
+const int VARIO_AUDIO_BLOCK_SAMPLES = 128; // 8 ms per block; queued audio stays below 20 ms
+const int VARIO_AUDIO_BUFFER_COUNT = 3;    // Playing, queued and rendering
+const int VARIO_AUDIO_CHANNEL = 0;         // Virtual speaker channel reserved for the vario tone
+const int VARIO_AUDIO_TASK_STACK_SIZE = 4096;
 
 // Altitude Filter
-const int ALTITUDE_FILTER_SIZE = 10; // Number of samples for moving average filter
+const int ALTITUDE_FILTER_SIZE = 10; // Number of samples of the previous moving average filter, used by the replay comparison in test/test_vario_filter
+const float VARIO_KF_ACCEL_NOISE_MPS2 = 1.0f; // Vertical acceleration the filter expects; higher reacts faster but is noisier
+const float VARIO_KF_BARO_NOISE_M = 0.4f;     // Noise of one barometric altitude sample
+const float VARIO_KF_GPS_NOISE_M = 6.0f;      // Noise of the GPS altitude
+const float VARIO_KF_OFFSET_DRIFT_M = 0.05f;  // Random walk of the barometer offset per sqrt(s)
+const float VARIO_KF_INITIAL_OFFSET_M = 100.0f; // Barometer offset uncertainty before the first GPS fix (QNH unknown)
+const int VARIO_TELEMETRY_QUEUE_DEPTH = 16;
+const unsigned long VARIOMETER_UPDATE_INTERVAL_MS = 200; // Publish interval, the tone follows every sample; the filter itself runs at the barometer rate
 
 // GPS Constants
-const int GPS_TASK_DELAY_MS = 1000;
+const int GPS_RX_WAIT_TIMEOUT_MS = 1000; // Wake-up without UART data, for fix-loss detection and test data
 const int GPS_INIT_DELAY_MS = 2000;
+const int GPS_RECEIVER_PROTOCOL = 3; // 0 = unconfigured, 1 = UBX, 2 = PMTK, 3 = CASIC (see GpsReceiverProtocol)
+const int GPS_NAV_RATE_HZ = 10; // Navigation rate set at startup, 5-10 Hz
+const int GPS_CONFIG_ACK_TIMEOUT_MS = 300; // Wait for a UBX or PMTK acknowledge
+const int GPS_CONFIG_COMMAND_DELAY_MS = 50; // Gap after commands that are not acknowledged
+const unsigned long GPS_STATS_LOG_INTERVAL_MS = 10000;
 const int GPS_FIX_TIMEOUT_MS = 10000; // 10 seconds
 const int GPS_SERIAL_BAUD_RATE = 115200; //115200bps@8N1
 const int GPS_SERIAL_RX_PIN = 17; // GPIO17
 const int GPS_SERIAL_TX_PIN = 16; // GPIO16
 const int GPS_SERIAL_MODE   = SERIAL_8N1;
-const int GPS_UART = 1; // Use UART1 for GPS
\ No newline at end of file
+const int GPS_UART = 1; // Use UART1 for GPS
+const int GPS_SERIAL_RX_BUFFER_SIZE = 2048; // Bytes buffered by the UART driver while the GPS task is busy
+const int GPS_SERIAL_RX_CHUNK_SIZE = 256; // Bytes passed to the NMEA parser per call
+const int GPS_SERIAL_RX_TIMEOUT_SYMBOLS = 2; // Idle time in character times that raises the RX event after a sentence
\ No newline at end of file
@@ -1,35 +1,174 @@
 #include "gps_task.h"
 #include <M5Unified.h>
-#include <TinyGPSPlus.h>
-#include <freertos/semphr.h> // Required for mutex
+#include <algorithm>         // For std::min
 #include "config.h"          // Include configuration constants
+#include "nmea_parser.h"
 #include "tile_calculator.h"
-#include "gui.h" // Include gui.h for event group
+#include "telemetry.h" // For gpsState
+#include "telemetry_bus.h"
 
 #include "gpsTestData.h" // Include GPS test data
 
-// Declare extern global variables and mutex from main.cpp
-extern double globalLatitude;
-extern double globalLongitude;
-extern double globalAltitude;
-extern bool globalTestdata; // Flag to indicate if test data is being used
-extern bool globalValid;    // Indicates if a valid GPS fix is available
-extern double globalDirection;
-extern uint32_t globalTime;
-extern SemaphoreHandle_t xGPSMutex;
+// Declare extern global variables from main.cpp
 extern bool globalManualMapMode; // New: Flag to indicate if map is in manual drag mode
 
-// The TinyGPSPlus object
-TinyGPSPlus gps;
+static NmeaParser nmeaParser;
+static char rxChunk[GPS_SERIAL_RX_CHUNK_SIZE]; // Bytes handed to the parser in one call
+static unsigned long lastPositionMs = 0;       // millis() of the last valid position
 
 // The serial port for GPS
 HardwareSerial gpsSerial(GPS_UART); // Use UART1
 
+static TaskHandle_t gpsTaskHandle = NULL;
+static volatile uint32_t lastRxEventUs = 0; // micros() of the last UART RX event
+static GpsIngestStats ingestStats = {};
+static portMUX_TYPE ingestStatsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Runs in the UART event task of the Arduino core whenever the RX FIFO fills up or the line goes idle
+// after a sentence; wakes the GPS task to parse what arrived.
+static void onGpsReceive()
+{
+    lastRxEventUs = micros();
+    if (gpsTaskHandle != NULL)
+    {
+        xTaskNotifyGive(gpsTaskHandle);
+    }
+}
+
+static void onGpsReceiveError(hardwareSerial_error_t error)
+{
+    if (error == UART_FIFO_OVF_ERROR || error == UART_BUFFER_FULL_ERROR)
+    {
+        portENTER_CRITICAL(&ingestStatsMux);
+        ingestStats.rxOverflows++;
+        portEXIT_CRITICAL(&ingestStatsMux);
+    }
+}
+
+// Send an NMEA command, "$" + body; the checksum and line end are appended
+static void sendNmeaCommand(const char *body)
+{
+    uint8_t checksum = 0;
+    for (const char *c = body + 1; *c != '\0'; ++c)
+    {
+        checksum ^= (uint8_t)*c;
+    }
+    gpsSerial.printf("%s*%02X\r\n", body, checksum);
+}
+
+// Wait for a byte sequence in the receiver output, e.g. an acknowledge. Called before the GPS task runs,
+// so the skipped bytes are not missed by anyone.
+static bool waitForGpsReply(const uint8_t *reply, size_t length)
+{
+    size_t matched = 0;
+    unsigned long start = millis();
+    while (millis() - start < GPS_CONFIG_ACK_TIMEOUT_MS)
+    {
+        if (gpsSerial.available() == 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(1));
+            continue;
+        }
+        uint8_t c = (uint8_t)gpsSerial.read();
+        matched = c == reply[matched] ? matched + 1 : (c == reply[0] ? 1 : 0);
+        if (matched == length)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool waitForGpsReply(const char *reply)
+{
+    return waitForGpsReply((const uint8_t *)reply, strlen(reply));
+}
+
+// Send a UBX message and wait for its ACK-ACK
+static bool sendUbxCommand(uint8_t msgClass, uint8_t msgId, const uint8_t *payload, uint16_t length)
+{
+    uint8_t header[6] = {0xB5, 0x62, msgClass, msgId, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8)};
+    uint8_t checksumA = 0;
+    uint8_t checksumB = 0;
+    for (int i = 2; i < 6; ++i)
+    {
+        checksumA += header[i];
+        checksumB += checksumA;
+    }
+    for (uint16_t i = 0; i < length; ++i)
+    {
+        checksumA += payload[i];
+        checksumB += checksumA;
+    }
+    gpsSerial.write(header, sizeof(header));
+    gpsSerial.write(payload, length);
+    gpsSerial.write(checksumA);
+    gpsSerial.write(checksumB);
+
+    const uint8_t ack[] = {0xB5, 0x62, 0x05, 0x01, 0x02, 0x00, msgClass, msgId};
+    return waitForGpsReply(ack, sizeof(ack));
+}
+
+// Set the navigation rate to GPS_NAV_RATE_HZ and turn off the sentences the parser does not use (only GGA and RMC are)
+static void configureGpsReceiver()
+{
+    const int intervalMs = 1000 / GPS_NAV_RATE_HZ;
+    char command[32];
+    bool acknowledged = true;
+
+    switch (GPS_RECEIVER_PROTOCOL)
+    {
+    case GPS_PROTOCOL_UBX:
+    {
+        const uint8_t unusedSentences[] = {0x01, 0x02, 0x03, 0x05, 0x08}; // GLL, GSA, GSV, VTG, ZDA
+        for (uint8_t sentence : unusedSentences)
+        {
+            const uint8_t cfgMsg[] = {0xF0, sentence, 0}; // CFG-MSG: NMEA class, rate 0 on this port
+            acknowledged &= sendUbxCommand(0x06, 0x01, cfgMsg, sizeof(cfgMsg));
+        }
+        const uint8_t cfgRate[] = {(uint8_t)(intervalMs & 0xFF), (uint8_t)(intervalMs >> 8), 1, 0, 1, 0}; // CFG-RATE: measRate, navRate 1, GPS time
+        acknowledged &= sendUbxCommand(0x06, 0x08, cfgRate, sizeof(cfgRate));
+        break;
+    }
+    case GPS_PROTOCOL_PMTK:
+        sendNmeaCommand("$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0"); // GLL, RMC, VTG, GGA, GSA, GSV, ...
+        acknowledged &= waitForGpsReply("$PMTK001,314,3");
+        snprintf(command, sizeof(command), "$PMTK220,%d", intervalMs);
+        sendNmeaCommand(command);
+        acknowledged &= waitForGpsReply("$PMTK001,220,3");
+        break;
+    case GPS_PROTOCOL_CASIC:
+        // CASIC receivers do not acknowledge PCAS commands
+        sendNmeaCommand("$PCAS03,1,0,0,0,1,0,0,0,0,0,,,0,0,,,,0"); // GGA, GLL, GSA, GSV, RMC, VTG, ZDA, ...
+        vTaskDelay(pdMS_TO_TICKS(GPS_CONFIG_COMMAND_DELAY_MS));
+        snprintf(command, sizeof(command), "$PCAS02,%d", intervalMs);
+        sendNmeaCommand(command);
+        vTaskDelay(pdMS_TO_TICKS(GPS_CONFIG_COMMAND_DELAY_MS));
+        break;
+    default:
+        ESP_LOGI("GPS", "Receiver left at its default configuration.");
+        return;
+    }
+
+    if (acknowledged)
+    {
+        ESP_LOGI("GPS", "Receiver configured for %d Hz, GGA and RMC only.", GPS_NAV_RATE_HZ);
+    }
+    else
+    {
+        ESP_LOGW("GPS", "Receiver did not acknowledge every configuration command, it may still run at its default rate.");
+    }
+}
+
 void initGPSTask()
 {
     // Initialize UART1 for GPS communication
     // RX (GPS TX) on GPIO0, TX (GPS RX) on GPIO1
+    gpsSerial.setRxBufferSize(GPS_SERIAL_RX_BUFFER_SIZE); // Must be set before begin()
     gpsSerial.begin(GPS_SERIAL_BAUD_RATE, GPS_SERIAL_MODE, GPS_SERIAL_RX_PIN, GPS_SERIAL_TX_PIN);
+    gpsSerial.setRxTimeout(GPS_SERIAL_RX_TIMEOUT_SYMBOLS); // Idle gap that ends a sentence burst
+    gpsSerial.onReceive(onGpsReceive);
+    gpsSerial.onReceiveError(onGpsReceiveError);
 
     if (!gpsSerial)
     {
@@ -41,47 +180,83 @@ void initGPSTask()
     {
         ESP_LOGI("GPS", "GPS serial port initialized successfully.");
     }
+    configureGpsReceiver();
+}
+
+// Publish a valid position once per navigation epoch, as soon as its last GGA or RMC sentence is complete
+static void onNmeaSentence(NmeaSentenceType type, const NmeaFix &nmeaFix, bool epochComplete, void *context)
+{
+    (void)type;
+    if (!epochComplete || !nmeaFix.locationValid)
+    {
+        return;
+    }
+    uint32_t rxEventUs = *(const uint32_t *)context;
+
+    GpsSnapshot fix;
+    fix.latitude = nmeaFix.latitude;
+    fix.longitude = nmeaFix.longitude;
+    fix.altitude = nmeaFix.altitude;
+    fix.altitudeCount = nmeaFix.altitudeCount;
+    fix.direction = nmeaFix.courseDeg;
+    fix.speed = nmeaFix.speedKmph;
+    fix.time = nmeaFix.time;
+    fix.valid = true;     // GPS fix is valid
+    fix.testdata = false; // Clear test data flag
+    fix.updateMs = millis();
+    gpsState.write(fix);
+    telemetryPublish(fix);
+    lastPositionMs = fix.updateMs;
+
+    // Fix age: from the UART event that delivered the sentence to the fix being published
+    uint32_t fixAgeUs = micros() - rxEventUs;
+    portENTER_CRITICAL(&ingestStatsMux);
+    ingestStats.fixes++;
+    ingestStats.fixAgeUs += fixAgeUs;
+    ingestStats.lastFixAgeUs = fixAgeUs;
+    if (fixAgeUs > ingestStats.maxFixAgeUs)
+    {
+        ingestStats.maxFixAgeUs = fixAgeUs;
+    }
+    portEXIT_CRITICAL(&ingestStatsMux);
+
+    ESP_LOGD("GPS", "Updated GPS Data: Lat %.6f, Lon %.6f, Alt %.2f m, Speed %.2f km/h, Dir %.2f deg, Time %lu, Age %lu us",
+             fix.latitude, fix.longitude, fix.altitude, fix.speed, fix.direction, fix.time, fixAgeUs);
 }
 
 void gpsReadTask(void *pvParameters)
 {
     (void)pvParameters; // Suppress unused parameter warning
 
+    gpsTaskHandle = xTaskGetCurrentTaskHandle();
+
     for (;;)
     {
-        while (gpsSerial.available() > 0)
-            gps.encode(gpsSerial.read());
+        // Sleep until the UART reports data. The timeout keeps fix-loss detection and test data going without a receiver.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(GPS_RX_WAIT_TIMEOUT_MS));
+        uint32_t rxEventUs = lastRxEventUs;
 
-        if (gps.location.isUpdated())
+        // Hand whatever arrived to the parser in chunks; fixes are published from onNmeaSentence
+        int available;
+        while ((available = gpsSerial.available()) > 0)
         {
-            if (xSemaphoreTake(xGPSMutex, portMAX_DELAY) == pdTRUE)
-            {
-                globalLatitude = gps.location.lat();
-                globalLongitude = gps.location.lng();
-                globalAltitude = gps.altitude.meters();
-                globalDirection = gps.course.deg();
-                globalSpeed = gps.speed.kmph(); // Update global speed
-                globalTime = gps.time.value();
-                globalValid = true;     // GPS fix is valid
-                globalTestdata = false; // Clear test data flag
-
-                ESP_LOGI("GPS", "Updated GPS Data: Lat %.6f, Lon %.6f, Alt %.2f m, Speed %.2f km/h, Dir %.2f deg, Time %lu",
-                         globalLatitude, globalLongitude, globalAltitude, globalSpeed, globalDirection, globalTime);
-
-                xSemaphoreGive(xGPSMutex);
-                xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_GPS_DATA_READY); // Signal GUI task
-            }
+            size_t length = gpsSerial.readBytes((uint8_t *)rxChunk, std::min((size_t)available, sizeof(rxChunk)));
+            nmeaParser.parse(rxChunk, length, onNmeaSentence, &rxEventUs);
         }
 
-        if (!gps.location.isValid())
+        if (!nmeaParser.fix().locationValid || millis() - lastPositionMs > GPS_FIX_TIMEOUT_MS)
         {
-            // If gps.location.isValid() is false, then there is no valid GPS fix.
-            if (xSemaphoreTake(xGPSMutex, portMAX_DELAY) == pdTRUE)
+            // The receiver reports no fix, or has gone silent
+            bool fixLost = false;
+            gpsState.modify([&fixLost](GpsSnapshot &fix) {
+                fixLost = fix.valid;
+                fix.valid = false; // No valid GPS fix
+            });
+            if (fixLost)
             {
-                globalValid = false; // No valid GPS fix
-                xSemaphoreGive(xGPSMutex);
+                telemetryPublish(gpsState.read()); // Consumers do not poll, tell them once
             }
-            ESP_LOGD("GPS", "GPS location is NOT valid. globalValid set to false and %s", globalManualMapMode ? "manual map mode is ON." : "manual map mode is OFF.");
+            ESP_LOGD("GPS", "GPS location is NOT valid. Fix set to invalid and %s", globalManualMapMode ? "manual map mode is ON." : "manual map mode is OFF.");
         }
 
         // nothing to do if not a valid sentence
@@ -89,23 +264,59 @@ void gpsReadTask(void *pvParameters)
         static unsigned long lastTestDataUpdateTime = 0;
         const unsigned long TESTDATA_UPDATE_INTERVAL_MS = 15000; // 15 seconds
 
-        if (USE_TESTDATA && !globalManualMapMode && !globalValid)
+        if (USE_TESTDATA && !globalManualMapMode && !gpsState.read().valid)
         {
             if ((millis() - lastTestDataUpdateTime) >= TESTDATA_UPDATE_INTERVAL_MS)
             {
-                if (xSemaphoreTake(xGPSMutex, portMAX_DELAY) == pdTRUE)
-                {
-                    int randomIndex = rand() % gpsTestData.size();
-                    globalLatitude = gpsTestData[randomIndex].lat;
-                    globalLongitude = gpsTestData[randomIndex].lon;
-                    globalTestdata = true;
-                    ESP_LOGW("GPS", "Using test data: Lat %.5f, Lon %.5f (globalValid: %d)", globalLatitude, globalLongitude, globalValid);
-                    lastTestDataUpdateTime = millis(); // Update the last update time
-                    xSemaphoreGive(xGPSMutex);
-                }
-                xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_GPS_DATA_READY);
+                int randomIndex = rand() % gpsTestData.size();
+                double latitude = gpsTestData[randomIndex].lat;
+                double longitude = gpsTestData[randomIndex].lon;
+                gpsState.modify([latitude, longitude](GpsSnapshot &fix) {
+                    fix.latitude = latitude;
+                    fix.longitude = longitude;
+                    fix.testdata = true;
+                    fix.updateMs = millis();
+                });
+                ESP_LOGW("GPS", "Using test data: Lat %.5f, Lon %.5f", latitude, longitude);
+                lastTestDataUpdateTime = millis(); // Update the last update time
+                telemetryPublish(gpsState.read());
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(GPS_TASK_DELAY_MS));
+
+        // At 10 Hz the per-fix log is too much, summarize instead; a drop shows as fewer fixes, overflows or checksum errors
+        static unsigned long lastStatsLogTime = 0;
+        static uint32_t lastStatsFixes = 0;
+        if (millis() - lastStatsLogTime >= GPS_STATS_LOG_INTERVAL_MS)
+        {
+            GpsIngestStats stats;
+            gpsGetIngestStats(&stats);
+            float seconds = (millis() - lastStatsLogTime) / 1000.0f;
+            const NmeaParserStats &parserStats = nmeaParser.stats();
+            ESP_LOGI("GPS", "%.1f fixes/s, fix age avg %llu us max %lu us, %lu sentences, %lu checksum errors, %lu RX overflows",
+                     (stats.fixes - lastStatsFixes) / seconds, stats.fixes > 0 ? stats.fixAgeUs / stats.fixes : 0ULL,
+                     stats.maxFixAgeUs, stats.sentences, stats.failedChecksums, stats.rxOverflows);
+            ESP_LOGI("GPS", "GGA %lu/%lu, RMC %lu/%lu, VTG %lu/%lu, GSA %lu/%lu (parsed/checksum errors), %lu unsupported, %lu malformed",
+                     parserStats.sentences[NMEA_GGA].parsed, parserStats.sentences[NMEA_GGA].checksumErrors,
+                     parserStats.sentences[NMEA_RMC].parsed, parserStats.sentences[NMEA_RMC].checksumErrors,
+                     parserStats.sentences[NMEA_VTG].parsed, parserStats.sentences[NMEA_VTG].checksumErrors,
+                     parserStats.sentences[NMEA_GSA].parsed, parserStats.sentences[NMEA_GSA].checksumErrors,
+                     parserStats.unsupported, parserStats.malformed);
+            lastStatsLogTime = millis();
+            lastStatsFixes = stats.fixes;
+        }
     }
-}
\ No newline at end of file
+}
+
+void gpsGetIngestStats(GpsIngestStats *stats)
+{
+    portENTER_CRITICAL(&ingestStatsMux);
+    *stats = ingestStats;
+    portEXIT_CRITICAL(&ingestStatsMux);
+    const NmeaParserStats &parserStats = nmeaParser.stats();
+    stats->sentences = parserStats.unsupported;
+    for (int type = 0; type < NMEA_SENTENCE_COUNT; ++type)
+    {
+        stats->sentences += parserStats.sentences[type].parsed;
+    }
+    stats->failedChecksums = parserStats.checksumErrors;
+}
@@ -7,20 +7,34 @@
 extern "C" {
 #endif
 
-extern double globalLatitude;
-extern double globalLongitude;
-extern double globalAltitude;
-extern unsigned long globalSatellites;
-extern unsigned long globalHDOP;
-extern double globalDirection;
-extern double globalSpeed; // Declared extern for GPS speed
-extern uint32_t globalTime;
-extern SemaphoreHandle_t xGPSMutex;
+// The latest fix is kept in gpsState (telemetry.h) and published on TOPIC_GPS_FIX (telemetry_bus.h)
+
+// Command set used to configure the receiver at startup (GPS_RECEIVER_PROTOCOL)
+enum GpsReceiverProtocol
+{
+    GPS_PROTOCOL_NONE = 0, // Leave the receiver at its defaults
+    GPS_PROTOCOL_UBX,      // u-blox
+    GPS_PROTOCOL_PMTK,     // MediaTek / Quectel L80/L86
+    GPS_PROTOCOL_CASIC     // AT6558 / AT6668 (M5Stack GPS units)
+};
+
+// Counters of the UART ingestion
+struct GpsIngestStats
+{
+    uint32_t fixes;           // Published fixes
+    uint64_t fixAgeUs;        // Sum of the fix ages, average = / fixes
+    uint32_t lastFixAgeUs;    // Time from the UART RX event to publishing the fix
+    uint32_t maxFixAgeUs;
+    uint32_t rxOverflows;     // UART FIFO or RX buffer overflows, bytes were lost
+    uint32_t sentences;       // NMEA sentences accepted by the parser
+    uint32_t failedChecksums; // NMEA sentences rejected by the parser
+};
 
 void initGPSTask();
 void gpsReadTask(void *pvParameters);
 void updateDisplayWithGPSTelemetry(double latitude, double longitude, double altitude, unsigned long satellites, unsigned long hdop, double speed);
 void updateDisplayGPSInvalid();
+void gpsGetIngestStats(GpsIngestStats *stats);
 
 #ifdef __cplusplus
 }
@@ -8,159 +8,102 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/semphr.h>
-#include <freertos/event_groups.h> // Include for EventGroupHandle_t
 #include <limits>                  // For INT_MAX
 #include "gps_task.h"
 #include "tile_calculator.h"
+#include "tile_cache.h"
+#include "tile_loader.h"
+#include "compositor.h"
+#include "telemetry.h"
+#include "telemetry_bus.h"
 #include "gui.h"    // Include its own header
 #include "config.h" // Include configuration constants
 
 // External global variables from main.cpp
-extern EventGroupHandle_t xGuiUpdateEventGroup; // Declare extern for the event group
 extern bool globalSoundEnabled;                 // Declare global sound enable flag
 extern bool globalBikeOverlayEnabled;          // Declare extern for bike overlay flag
 extern bool globalHikeOverlayEnabled;          // Declare extern for hike overlay flag
-extern SemaphoreHandle_t xGPSMutex;             // Declare extern here
-extern double globalLatitude;                   // Declare extern here
-extern double globalLongitude;                  // Declare extern here
-extern bool globalValid;                        // Declare extern here
-extern bool globalTestdata;                     // Declare extern here
 extern bool globalManualMapMode;                // Declare extern here
-extern double globalSpeed;                      // Declare extern here
-extern double globalAltitude;                   // Declare extern here
-extern double globalDirection;                  // Declare extern here
-
-extern SemaphoreHandle_t xSensorMutex;
-extern float globalPressure;
-extern float globalTemperature;
-extern float globalAltitude_m;
-extern float globalVerticalSpeed_mps;
-extern SemaphoreHandle_t xVariometerMutex;
 
 extern SemaphoreHandle_t xPositionMutex;
 extern int globalTileX;
 extern int globalTileY;
 extern int globalTileZ;
-// Global LRU Cache instance (1MB)
 M5Canvas tileCanvas(&M5.Display);         // Declare M5Canvas globally for individual tile drawing
 M5Canvas screenBufferCanvas(&M5.Display); // Declare M5Canvas globally for full screen buffer
+M5Canvas mapGridCanvas(&M5.Display);      // Tile-aligned DRAW_GRID_DIMENSION x DRAW_GRID_DIMENSION grid of decoded tiles
+M5Canvas zoomScratchCanvas(&M5.Display);  // Copy of the grid, source of the rescaled preview on zoom changes
 M5Canvas gpsCanvas(&M5.Display);
 M5Canvas varioCanvas(&M5.Display);
 M5Canvas verticalSpeedCanvas(&M5.Display);
 M5Canvas hikeButtonCanvas(&M5.Display); // Declare M5Canvas for hike overlay button
 M5Canvas bikeButtonCanvas(&M5.Display); // Declare M5Canvas for bike overlay button
+M5Canvas soundButtonCanvas(&M5.Display);
 M5Canvas dir_icon(&M5.Display);         // Declare M5Canvas globally for direction icon
 
 // Define globalCurrentTilePath
-char globalLastDrawnTilePath[TILE_PATH_MAX_LENGTH] = "";
 char globalCurrentCenterTilePath[TILE_PATH_MAX_LENGTH] = "";
 char tilePaths[SCREEN_BUFFER_TILE_DIMENSION][SCREEN_BUFFER_TILE_DIMENSION][TILE_PATH_MAX_LENGTH]; // Define global tilePaths
 
-// Helper function to draw a single tile, handling cache and SD loading
-void drawTile(M5Canvas &canvas, int tileX, int tileY, int zoom, const char *filePath)
-{
-  // Check if the requested tile is already loaded
-  if (strcmp(globalLastDrawnTilePath, filePath) == 0)
-  {
-    ESP_LOGI("drawTile", "Tile already loaded: %s", filePath);
-    return;
-  }
+// Compressed tile data buffer for the GUI task
+static uint8_t *guiTileBlobBuffer = nullptr;
 
-  File file = SD_MMC.open(filePath);
-  if (!file)
-  {
-    ESP_LOGE("SD_CARD", "Failed to open file for reading: %s", filePath);
-    return;
-  }
-  canvas.drawJpgFile(SD_MMC, filePath, 0, 0);
-  file.close();
-  ESP_LOGI("drawTile", "Loaded and drew Jpeg from SD: %s", filePath);
+// Compositor layers, bottom to top
+static int mapLayer = -1;
+static int varioLayer = -1;
+static int verticalSpeedLayer = -1;
+static int gpsLayer = -1;
+static int soundButtonLayer = -1;
+static int hikeButtonLayer = -1;
+static int bikeButtonLayer = -1;
 
-  // Update the globalCurrentTilePath
-  strncpy(globalLastDrawnTilePath, filePath, TILE_PATH_MAX_LENGTH - 1);
-  globalLastDrawnTilePath[TILE_PATH_MAX_LENGTH - 1] = '\0'; // Ensure null-termination
-}
-
-// Helper function to draw a single tile, handling cache and SD loading
-void drawHikeOverlayFromTile(M5Canvas &canvas, int tileX, int tileY, int zoom, const char *filePath)
+// Parts of the screen a pass of the GUI loop has to redraw
+enum GuiRedraw
 {
-  // Create a mutable copy of filePath to modify the extension
-  char modifiedFilePath[TILE_PATH_MAX_LENGTH];
-  strncpy(modifiedFilePath, filePath, TILE_PATH_MAX_LENGTH - 1);
-  modifiedFilePath[TILE_PATH_MAX_LENGTH - 1] = '\0';
-
-  // Find the last occurrence of ".png" and replace with ".jpg"
-  char *jpegExtension = strstr(modifiedFilePath, ".jpeg");
-  if (jpegExtension != nullptr) {
-      // Replace .jpeg with .png
-      strncpy(jpegExtension, ".png", 4); // 4 for .png and null terminator
-      jpegExtension[4] = '\0';
-  }
-
-   // Find "pixelkarte-farbe" and replace with "hike"
-  char *pathSegment = strstr(modifiedFilePath, "pixelkarte-farbe");
-  if (pathSegment != nullptr) {
-      // Calculate the length of the part before "pixelkarte-farbe"
-      size_t prefixLen = pathSegment - modifiedFilePath;
-      char tempPath[TILE_PATH_MAX_LENGTH];
-      strncpy(tempPath, modifiedFilePath, prefixLen);
-      tempPath[prefixLen] = '\0';
-      strcat(tempPath, "hike");
-      strcat(tempPath, pathSegment + strlen("pixelkarte-farbe"));
-      strncpy(modifiedFilePath, tempPath, TILE_PATH_MAX_LENGTH - 1);
-      modifiedFilePath[TILE_PATH_MAX_LENGTH - 1] = '\0';
-  }
-
-  File file = SD_MMC.open(modifiedFilePath); // Use modifiedFilePath
-  if (!file)
+  REDRAW_GPS = 1 << 0,
+  REDRAW_VARIO = 1 << 1,
+  REDRAW_MAP = 1 << 2, // Pan or zoom level change
+  REDRAW_SOUND_BUTTON = 1 << 3,
+  REDRAW_HIKE_BUTTON = 1 << 4,
+  REDRAW_BIKE_BUTTON = 1 << 5,
+  REDRAW_ZOOM_PREVIEW = 1 << 6,
+  REDRAW_ALL = (1 << 7) - 1
+};
+
+static uint32_t redrawForMessage(const TelemetryMessage &message)
+{
+  switch (message.topic)
   {
-    ESP_LOGE("SD_CARD", "Failed to open file for reading: %s", modifiedFilePath); // Log modifiedFilePath
-    return;
+  case TOPIC_GPS_FIX:
+    return REDRAW_GPS;
+  case TOPIC_VARIO:
+    return REDRAW_VARIO;
+  case TOPIC_UI_INPUT:
+  {
+    // Several events can arrive merged in one message
+    uint32_t redraw = 0;
+    uint32_t events = message.ui.events;
+    redraw |= (events & UI_INPUT_MASK(UI_INPUT_MAP_MOVED)) != 0 ? REDRAW_MAP : 0;
+    redraw |= (events & UI_INPUT_MASK(UI_INPUT_MAP_ZOOM_PREVIEW)) != 0 ? REDRAW_ZOOM_PREVIEW : 0;
+    redraw |= (events & UI_INPUT_MASK(UI_INPUT_SOUND_BUTTON)) != 0 ? REDRAW_SOUND_BUTTON : 0;
+    redraw |= (events & UI_INPUT_MASK(UI_INPUT_HIKE_BUTTON)) != 0 ? REDRAW_HIKE_BUTTON : 0;
+    redraw |= (events & UI_INPUT_MASK(UI_INPUT_BIKE_BUTTON)) != 0 ? REDRAW_BIKE_BUTTON : 0;
+    return redraw;
+  }
+  default:
+    return 0;
   }
-  canvas.drawPngFile(SD_MMC, modifiedFilePath, 0, 0);
-  file.close();
-  ESP_LOGI("drawHikeOverlayFromTile", "Loaded and drew Png from SD: %s", modifiedFilePath);
 }
 
-// Helper function to draw a single tile, handling cache and SD loading
-void drawBikeOverlayFromTile(M5Canvas &canvas, int tileX, int tileY, int zoom, const char *filePath)
+// Helper function to draw a single tile with the enabled overlays, handling cache and SD loading
+bool drawTile(M5Canvas &canvas, int tileX, int tileY, int zoom, uint8_t overlays, const char *filePath)
 {
-  // Create a mutable copy of filePath to modify the extension
-  char modifiedFilePath[TILE_PATH_MAX_LENGTH];
-  strncpy(modifiedFilePath, filePath, TILE_PATH_MAX_LENGTH - 1);
-  modifiedFilePath[TILE_PATH_MAX_LENGTH - 1] = '\0';
-
-  // Find the last occurrence of ".png" and replace with ".jpg"
-  char *jpegExtension = strstr(modifiedFilePath, ".jpeg");
-  if (jpegExtension != nullptr) {
-      // Replace .jpeg with .png
-      strncpy(jpegExtension, ".png", 4); // 4 for .png and null terminator
-      jpegExtension[4] = '\0';
-  }
-
-   // Find "pixelkarte-farbe" and replace with "bike"
-  char *pathSegment = strstr(modifiedFilePath, "pixelkarte-farbe");
-  if (pathSegment != nullptr) {
-      // Calculate the length of the part before "pixelkarte-farbe"
-      size_t prefixLen = pathSegment - modifiedFilePath;
-      char tempPath[TILE_PATH_MAX_LENGTH];
-      strncpy(tempPath, modifiedFilePath, prefixLen);
-      tempPath[prefixLen] = '\0';
-      strcat(tempPath, "bike");
-      strcat(tempPath, pathSegment + strlen("pixelkarte-farbe"));
-      strncpy(modifiedFilePath, tempPath, TILE_PATH_MAX_LENGTH - 1);
-      modifiedFilePath[TILE_PATH_MAX_LENGTH - 1] = '\0';
-  }
-
-  File file = SD_MMC.open(modifiedFilePath); // Use modifiedFilePath
-  if (!file)
+  if (!drawCompositedTile(canvas, zoom, tileX, tileY, overlays, guiTileBlobBuffer))
   {
-    ESP_LOGE("SD_CARD", "Failed to open file for reading: %s", modifiedFilePath); // Log modifiedFilePath
-    return;
+    return false;
   }
-  canvas.drawPngFile(SD_MMC, modifiedFilePath, 0, 0);
-  file.close();
-  ESP_LOGI("drawBikeOverlayFromTile", "Loaded and drew Png from SD: %s", modifiedFilePath);
+  ESP_LOGD("drawTile", "Drew tile %s with overlays 0x%02x", filePath, overlays);
+  return true;
 }
 
 void initDirectionIcon()
@@ -206,33 +149,118 @@ void initDirectionIcon()
   dir_icon.setPivot(DIR_ICON_R, DIR_ICON_R);
 }
 
+// State of the tile-aligned map grid: slot [0][0] of mapGridCanvas holds tile (gridCenterTileX - DRAW_GRID_CENTER_OFFSET, ...)
+static bool gridValid = false;
+static int gridCenterTileX = 0;
+static int gridCenterTileY = 0;
+static int gridTileZ = 0;
+static bool gridHikeOverlay = false;
+static bool gridBikeOverlay = false;
+
+// Decode one tile (base map plus enabled overlays) into its slot of the map grid.
+// With previewOnly, a tile that is not cached yet is replaced by an upscaled cached ancestor and false is returned,
+// so the caller can show the preview and decode the sharp tile afterwards.
+bool drawGridTile(int slotX, int slotY, int tileZ, bool previewOnly)
+{
+  const char *tilePath = tilePaths[slotY - DRAW_GRID_CENTER_OFFSET + SCREEN_BUFFER_CENTER_OFFSET][slotX - DRAW_GRID_CENTER_OFFSET + SCREEN_BUFFER_CENTER_OFFSET];
+  int tileX = gridCenterTileX - DRAW_GRID_CENTER_OFFSET + slotX;
+  int tileY = gridCenterTileY - DRAW_GRID_CENTER_OFFSET + slotY;
+  uint8_t overlays = activeTileOverlays();
+  bool sharp = true;
+
+  tileCanvas.clear(TFT_DARKCYAN); // Clear the individual tile canvas
+  if (previewOnly && !tileCacheContains({tileZ, tileX, tileY, overlays}))
+  {
+    drawTileFallback(tileCanvas, tileZ, tileX, tileY, overlays, guiTileBlobBuffer, false);
+    sharp = false;
+  }
+  else if (!drawTile(tileCanvas, tileX, tileY, tileZ, overlays, tilePath))
+  {
+    // Missing at this zoom (outside the covered area or beyond the highest stored zoom): overzoom an ancestor
+    drawTileFallback(tileCanvas, tileZ, tileX, tileY, overlays, guiTileBlobBuffer, true);
+  }
+  tileCanvas.pushSprite(&mapGridCanvas, slotX * TILE_SIZE, slotY * TILE_SIZE); // Draw tile into its grid slot
+  return sharp;
+}
+
+// Rescale the grid content from the current zoom to newZoom so that it lines up with the grid around the new
+// center tile. The result is a blurry but correctly placed preview until the tiles of the new zoom are decoded.
+static void rescaleGridForZoom(int newZoom, int newCenterTileX, int newCenterTileY)
+{
+  double scale = ldexp(1.0, newZoom - gridTileZ);
+  // Global pixel of grid slot [0][0] before (old zoom) and after (new zoom) the change
+  double oldOriginX = (double)(gridCenterTileX - DRAW_GRID_CENTER_OFFSET) * TILE_SIZE;
+  double oldOriginY = (double)(gridCenterTileY - DRAW_GRID_CENTER_OFFSET) * TILE_SIZE;
+  double newOriginX = (double)(newCenterTileX - DRAW_GRID_CENTER_OFFSET) * TILE_SIZE;
+  double newOriginY = (double)(newCenterTileY - DRAW_GRID_CENTER_OFFSET) * TILE_SIZE;
+
+  mapGridCanvas.pushSprite(&zoomScratchCanvas, 0, 0);
+  mapGridCanvas.fillSprite(TFT_DARKCYAN);
+  zoomScratchCanvas.pushRotateZoom(&mapGridCanvas, (float)(oldOriginX * scale - newOriginX), (float)(oldOriginY * scale - newOriginY),
+                                   0, (float)scale, (float)scale);
+  ESP_LOGD("updateTiles", "Rescaled grid from zoom %d to %d.", gridTileZ, newZoom);
+}
+
+// Compose the visible map from the grid so that the given position is centered and mark the map layer dirty.
+// The frame goes out with the next compositorFlush(), normally the one at the end of the GUI pass.
+void renderMapViewport(const TileProjection *position, double globalDirection)
+{
+  renderScaledMapViewport(position, globalDirection, 1.0f, 0, 0);
+}
+
+// Same as renderMapViewport with the map scaled around a display point, used while a pinch is in progress.
+// Only the already decoded grid is scaled, so this is cheap enough to follow the fingers.
+void renderScaledMapViewport(const TileProjection *position, double globalDirection, float scale, int anchorX, int anchorY)
+{
+  // The GPS coordinate lies pixelOffset into the center slot of the grid; place that point in the middle of the buffer.
+  int centerX = screenBufferCanvas.width() / 2;
+  int centerY = screenBufferCanvas.height() / 2;
+  int gridOriginX = centerX - (DRAW_GRID_CENTER_OFFSET * TILE_SIZE + position->pixelOffsetX);
+  int gridOriginY = centerY - (DRAW_GRID_CENTER_OFFSET * TILE_SIZE + position->pixelOffsetY);
+
+  // Calculate offsets to center the screenBufferCanvas on the M5.Display.
+  // The screenBufferCanvas is larger than the display, so negative offsets are expected.
+  const int offsetX = (M5.Display.width() - screenBufferCanvas.width()) / 2;
+  const int offsetY = (M5.Display.height() - screenBufferCanvas.height()) / 2;
+
+  screenBufferCanvas.clear(TFT_BLACK); // Clear the screen buffer
+  if (scale == 1.0f)
+  {
+    mapGridCanvas.pushSprite(&screenBufferCanvas, gridOriginX, gridOriginY);
+  }
+  else
+  {
+    // Keep the grid pixel under the anchor in place
+    int bufferAnchorX = anchorX - offsetX;
+    int bufferAnchorY = anchorY - offsetY;
+    mapGridCanvas.setPivot(bufferAnchorX - gridOriginX, bufferAnchorY - gridOriginY);
+    mapGridCanvas.pushRotateZoom(&screenBufferCanvas, bufferAnchorX, bufferAnchorY, 0, scale, scale);
+  }
+
+  // Draw arrow head (triangle)
+  drawDirectionIcon(screenBufferCanvas, centerX, centerY, globalDirection); // Buttons are separate compositor layers on top
+
+  compositorSetLayerPosition(mapLayer, offsetX, offsetY);
+  compositorMarkDirty(mapLayer);
+  ESP_LOGD("updateTiles", "Composed screenBufferCanvas at offsetX: %d, offsetY: %d", offsetX, offsetY);
+}
+
 // New function to update and draw map tiles
-void updateTiles(double currentLatitude, double currentLongitude, int currentTileZ, int currentTileX, int currentTileY, double globalDirection)
+void updateTiles(const TileProjection *position, int currentTileZ, double globalDirection)
 {
-  int pixelOffsetX = 0;
-  int pixelOffsetY = 0;
- 
-  double effectiveLatitude = currentLatitude;
-  double effectiveLongitude = currentLongitude;
-  int effectiveTileX = currentTileX;
-  int effectiveTileY = currentTileY;
- 
-  ESP_LOGD("updateTiles", "Initial - Lat: %.6f, Lng: %.6f, TileZ: %d", currentLatitude, currentLongitude, currentTileZ);
-  latLngToPixelOffset(currentLatitude, currentLongitude, currentTileZ, &pixelOffsetX, &pixelOffsetY);
- 
-  // Calculate the top-left coordinates for the drawing grid
-  // The central tile (effectiveTileX, effectiveTileY) will be at index [DRAW_GRID_CENTER_OFFSET][DRAW_GRID_CENTER_OFFSET] in the DRAW_GRID_DIMENSION x DRAW_GRID_DIMENSION array
-  int conceptualGridStartX = effectiveTileX - DRAW_GRID_CENTER_OFFSET;
-  int conceptualGridStartY = effectiveTileY - DRAW_GRID_CENTER_OFFSET;
+  const int currentTileX = position->tileX;
+  const int currentTileY = position->tileY;
+  ESP_LOGD("updateTiles", "Initial - Tile: %d/%d, offset %d/%d, TileZ: %d", currentTileX, currentTileY,
+           position->pixelOffsetX, position->pixelOffsetY, currentTileZ);
 
-  // Populate the TILE_GRID_DIMENSION x TILE_GRID_DIMENSION tilePaths array
+  // Populate the SCREEN_BUFFER_TILE_DIMENSION x SCREEN_BUFFER_TILE_DIMENSION tilePaths array
   for (int y = 0; y < SCREEN_BUFFER_TILE_DIMENSION; ++y)
   {
     for (int x = 0; x < SCREEN_BUFFER_TILE_DIMENSION; ++x)
     {
-      int tileToLoadX = effectiveTileX - SCREEN_BUFFER_CENTER_OFFSET + x;
-      int tileToLoadY = effectiveTileY - SCREEN_BUFFER_CENTER_OFFSET + y;
-      sprintf(tilePaths[y][x], "/maps/pixelkarte-farbe/%d/%d/%d.jpeg", currentTileZ, tileToLoadX, tileToLoadY);
+      int tileToLoadX = currentTileX - SCREEN_BUFFER_CENTER_OFFSET + x;
+      int tileToLoadY = currentTileY - SCREEN_BUFFER_CENTER_OFFSET + y;
+      formatTileLayerPath(tilePaths[y][x], TILE_LAYER_BASE, currentTileZ, tileToLoadX, tileToLoadY);
       if (x == SCREEN_BUFFER_CENTER_OFFSET && y == SCREEN_BUFFER_CENTER_OFFSET)
       {
           strncpy(globalCurrentCenterTilePath, tilePaths[y][x], TILE_PATH_MAX_LENGTH - 1);
@@ -241,57 +269,156 @@ void updateTiles(double currentLatitude, double currentLongitude, int currentTil
     }
   }
 
-  // Calculate the drawing origin so that the GPS coordinate (pixelOffsetX, pixelOffsetY within its tile)
-  // is centered on the screen.
-  // The tile containing the GPS coordinate is (currentTileX, currentTileY).
-  // The top-left corner of this tile should be drawn at:
-  // (screenBufferCanvas.width() / 2 - pixelOffsetX, screenBufferCanvas.height() / 2 - pixelOffsetY)
-  int drawOriginX = (screenBufferCanvas.width() / 2) - pixelOffsetX;
-  int drawOriginY = (screenBufferCanvas.height() / 2) - pixelOffsetY;
+  // A crossing into a neighbouring tile keeps six of the nine tiles: shift the grid by one slot and decode only
+  // the newly exposed row and/or column. Zoom or overlay changes invalidate the whole grid.
+  int shiftX = currentTileX - gridCenterTileX;
+  int shiftY = currentTileY - gridCenterTileY;
+  bool canScroll = MAP_INCREMENTAL_SCROLL && gridValid && currentTileZ == gridTileZ &&
+                   gridHikeOverlay == globalHikeOverlayEnabled && gridBikeOverlay == globalBikeOverlayEnabled &&
+                   abs(shiftX) <= 1 && abs(shiftY) <= 1;
+
+  // Zoom change: show the current map rescaled around the anchor at once, then refine it tile by tile
+  bool zoomPreview = gridValid && currentTileZ != gridTileZ && abs(currentTileZ - gridTileZ) <= MAP_ZOOM_PREVIEW_MAX_LEVELS;
+  if (zoomPreview)
+  {
+    rescaleGridForZoom(currentTileZ, currentTileX, currentTileY);
+  }
 
-  screenBufferCanvas.clear(TFT_BLACK); // Clear the screen buffer
-  ESP_LOGD("updateTiles", "Performing full redraw.");
-  // Draw all DRAW_GRID_DIMENSION * DRAW_GRID_DIMENSION tiles to the screen buffer
-  for (int yOffset = -DRAW_GRID_CENTER_OFFSET; yOffset <= DRAW_GRID_CENTER_OFFSET; ++yOffset)
+  gridCenterTileX = currentTileX;
+  gridCenterTileY = currentTileY;
+  gridTileZ = currentTileZ;
+  gridHikeOverlay = globalHikeOverlayEnabled;
+  gridBikeOverlay = globalBikeOverlayEnabled;
+  gridValid = true;
+
+  // Collect the slots that need new content
+  int slotsToDraw[DRAW_GRID_DIMENSION * DRAW_GRID_DIMENSION][2];
+  int slotCount = 0;
+  if (canScroll)
   {
-    for (int xOffset = -DRAW_GRID_CENTER_OFFSET; xOffset <= DRAW_GRID_CENTER_OFFSET; ++xOffset)
+    if (shiftX != 0 || shiftY != 0)
     {
-      int currentDrawX = drawOriginX + (xOffset * TILE_SIZE);
-      int currentDrawY = drawOriginY + (yOffset * TILE_SIZE);
-      tileCanvas.clear(TFT_DARKCYAN); // Clear the individual tile canvas
-      drawTile(tileCanvas, conceptualGridStartX + xOffset, conceptualGridStartY + yOffset,
-               currentTileZ, tilePaths[yOffset + SCREEN_BUFFER_CENTER_OFFSET][xOffset + SCREEN_BUFFER_CENTER_OFFSET]);
-      if(globalHikeOverlayEnabled){
-        ESP_LOGD("updateTiles", "Drawing Hike Overlay on tile at offsetX: %d, offsetY: %d, path: %s", xOffset, yOffset, tilePaths[yOffset + SCREEN_BUFFER_CENTER_OFFSET][xOffset + SCREEN_BUFFER_CENTER_OFFSET]);
-        drawHikeOverlayFromTile(tileCanvas, conceptualGridStartX + xOffset, conceptualGridStartY + yOffset,
-                                currentTileZ, tilePaths[yOffset + SCREEN_BUFFER_CENTER_OFFSET][xOffset + SCREEN_BUFFER_CENTER_OFFSET]);
+      mapGridCanvas.scroll(-shiftX * TILE_SIZE, -shiftY * TILE_SIZE);
+      int newColumn = shiftX > 0 ? DRAW_GRID_DIMENSION - 1 : 0;
+      int newRow = shiftY > 0 ? DRAW_GRID_DIMENSION - 1 : 0;
+      for (int slotY = 0; slotY < DRAW_GRID_DIMENSION; ++slotY)
+      {
+        for (int slotX = 0; slotX < DRAW_GRID_DIMENSION; ++slotX)
+        {
+          if ((shiftX != 0 && slotX == newColumn) || (shiftY != 0 && slotY == newRow))
+          {
+            slotsToDraw[slotCount][0] = slotX;
+            slotsToDraw[slotCount][1] = slotY;
+            slotCount++;
+          }
+        }
       }
-      if(globalBikeOverlayEnabled){
-        ESP_LOGD("updateTiles", "Drawing Bike Overlay on tile at offsetX: %d, offsetY: %d, path: %s", xOffset, yOffset, tilePaths[yOffset + SCREEN_BUFFER_CENTER_OFFSET][xOffset + SCREEN_BUFFER_CENTER_OFFSET]);
-        drawBikeOverlayFromTile(tileCanvas, conceptualGridStartX + xOffset, conceptualGridStartY + yOffset,
-                                currentTileZ, tilePaths[yOffset + SCREEN_BUFFER_CENTER_OFFSET][xOffset + SCREEN_BUFFER_CENTER_OFFSET]);
+    }
+    ESP_LOGD("updateTiles", "Scrolled grid by %d/%d tiles.", shiftX, shiftY);
+  }
+  else
+  {
+    ESP_LOGD("updateTiles", "Performing full redraw.");
+    for (int slotY = 0; slotY < DRAW_GRID_DIMENSION; ++slotY)
+    {
+      for (int slotX = 0; slotX < DRAW_GRID_DIMENSION; ++slotX)
+      {
+        slotsToDraw[slotCount][0] = slotX;
+        slotsToDraw[slotCount][1] = slotY;
+        slotCount++;
       }
-      tileCanvas.pushSprite(&screenBufferCanvas, currentDrawX, currentDrawY); // Draw tile to screen buffer
     }
   }
 
-  // Draw a red point at the GPS fix location (center of the screen) on the screen buffer
-  int centerX = screenBufferCanvas.width() / 2;
-  int centerY = screenBufferCanvas.height() / 2;
+  // Slow decodes follow, so the preview and every swapped-in tile are flushed right away; each flush may wait for
+  // the frame pacing, at most once per decoded tile. The last frame goes out with the flush ending the GUI pass.
+  if (zoomPreview)
+  {
+    renderMapViewport(position, globalDirection);
+    compositorFlush();
+  }
 
-  // Draw arrow head (triangle)
-  drawDirectionIcon(screenBufferCanvas, centerX, centerY, globalDirection);
-  drawSoundButton(); // Sound button now drawn directly to M5.Display
-  drawHikeOverlayButton();
-  drawBikeButton();
+  // First pass: cached tiles and upscaled ancestors only, no SD access. Uncached slots keep the rescaled preview.
+  bool pending[DRAW_GRID_DIMENSION * DRAW_GRID_DIMENSION];
+  int pendingCount = 0;
+  uint8_t overlays = activeTileOverlays();
+  for (int i = 0; i < slotCount; ++i)
+  {
+    int slotX = slotsToDraw[i][0];
+    int slotY = slotsToDraw[i][1];
+    TileKey key = {currentTileZ, currentTileX - DRAW_GRID_CENTER_OFFSET + slotX, currentTileY - DRAW_GRID_CENTER_OFFSET + slotY, overlays};
+    if (zoomPreview && !tileCacheContains(key))
+    {
+      pending[i] = true;
+    }
+    else
+    {
+      pending[i] = !drawGridTile(slotX, slotY, currentTileZ, true);
+    }
+    pendingCount += pending[i] ? 1 : 0;
+  }
 
-  // Calculate offsets to center the screenBufferCanvas on the M5.Display.
-  // The screenBufferCanvas is larger than the display, so negative offsets are expected.
-  const int offsetX = (M5.Display.width() - screenBufferCanvas.width()) / 2;
-  const int offsetY = (M5.Display.height() - screenBufferCanvas.height()) / 2;
-  
-  screenBufferCanvas.pushSprite(offsetX, offsetY);
-  ESP_LOGD("updateTiles", "Pushing screenBufferCanvas with calculated offsetX: %d, offsetY: %d", offsetX, offsetY);
+  // Second pass: show the preview, then decode the sharp tiles and show each one as soon as it is swapped in
+  // instead of waiting for the whole grid.
+  if (pendingCount > 0)
+  {
+    if (!zoomPreview)
+    {
+      renderMapViewport(position, globalDirection);
+      compositorFlush();
+    }
+    int remaining = pendingCount;
+    for (int i = 0; i < slotCount; ++i)
+    {
+      if (pending[i])
+      {
+        drawGridTile(slotsToDraw[i][0], slotsToDraw[i][1], currentTileZ, false);
+        remaining--;
+        renderMapViewport(position, globalDirection);
+        if (remaining > 0)
+        {
+          compositorFlush();
+        }
+      }
+    }
+  }
+  ESP_LOGD("updateTiles", "Drew %d tiles into the map grid, %d decoded.", slotCount, pendingCount);
+
+  if (pendingCount == 0)
+  {
+    renderMapViewport(position, globalDirection);
+  }
+
+  static int redrawCount = 0;
+  if (++redrawCount % TILE_CACHE_STATS_LOG_INTERVAL == 0)
+  {
+    TileCacheStats stats;
+    tileCacheGetStats(&stats);
+    ESP_LOGI("TileCache", "Hits: %lu, Misses: %lu, Evictions: %lu, Entries: %lu/%lu, Prefetch hits: %lu, wasted: %lu",
+             stats.hits, stats.misses, stats.evictions, stats.entries, stats.capacity,
+             stats.prefetchHits, stats.prefetchWasted);
+
+    TileLoadStats loadStats;
+    tileLoaderGetStats(&loadStats);
+    if (loadStats.tiles > 0)
+    {
+      ESP_LOGI("TileLoader", "Loads: %lu, avg %lu bytes, avg/max us open %lu/%lu, read %lu/%lu, decode %lu/%lu",
+               loadStats.tiles, (uint32_t)(loadStats.bytes / loadStats.tiles),
+               (uint32_t)(loadStats.openUs / loadStats.tiles), loadStats.maxOpenUs,
+               (uint32_t)(loadStats.readUs / loadStats.tiles), loadStats.maxReadUs,
+               (uint32_t)(loadStats.decodeUs / loadStats.tiles), loadStats.maxDecodeUs);
+    }
+
+    CompositorStats compositorStats;
+    compositorGetStats(&compositorStats);
+    ESP_LOGI("Compositor", "Frames: %lu (paced %lu, blocked %lu), Regions: %lu, Pixels/frame: %lu, "
+             "Interval avg/max: %lu/%lu us, Compose last/max: %lu/%lu us, Flush last/max: %lu/%lu us",
+             compositorStats.frames, compositorStats.pacedFrames, compositorStats.blockedFrames, compositorStats.regions,
+             compositorStats.frames > 0 ? (uint32_t)(compositorStats.pixels / compositorStats.frames) : 0,
+             compositorStats.frames > 1 ? (uint32_t)(compositorStats.frameIntervalUs / (compositorStats.frames - 1)) : 0,
+             compositorStats.maxFrameIntervalUs, compositorStats.lastComposeUs, compositorStats.maxComposeUs,
+             compositorStats.lastFlushUs, compositorStats.maxFlushUs);
+  }
 }
 
 void drawImageMatrixTask(void *pvParameters)
@@ -299,12 +426,10 @@ void drawImageMatrixTask(void *pvParameters)
   ESP_LOGI("drawImageMatrixTask", "Task started.");
   ESP_LOGI("drawImageMatrixTask", "Display Width: %d, Height: %d", M5.Display.width(), M5.Display.height());
 
-  int currentTileX = 0;
-  int currentTileY = 0;
+  TileProjection currentPosition = {}; // Position at currentTileZ, projected once per pass
   int currentTileZ = 0;
   double currentLatitude = 0;
   double currentLongitude = 0;
-  double currentSpeed = 0;
   bool currentValid = false;
   bool currentTestdata = false;
 
@@ -312,10 +437,19 @@ void drawImageMatrixTask(void *pvParameters)
   int prevTileX = -1;
   int prevTileY = -1;
   int prevTileZ = -1;
+  double prevLatitude = 0;
+  double prevLongitude = 0;
+  double prevDirection = 0;
 
   tileCanvas.createSprite(TILE_SIZE, TILE_SIZE); // Initialize M5Canvas for individual tiles
+  guiTileBlobBuffer = allocTileBlobBuffer();     // Compressed tile data read from the SD card
   // Todo could not the complete screen size be used here?
   screenBufferCanvas.createSprite(SCREEN_BUFFER_TILE_DIMENSION * TILE_SIZE, SCREEN_BUFFER_TILE_DIMENSION * TILE_SIZE); // Initialize M5Canvas for full screen buffer
+  mapGridCanvas.setPsram(true);
+  mapGridCanvas.createSprite(DRAW_GRID_DIMENSION * TILE_SIZE, DRAW_GRID_DIMENSION * TILE_SIZE); // Initialize M5Canvas for the tile grid
+  zoomScratchCanvas.setPsram(true);
+  zoomScratchCanvas.createSprite(DRAW_GRID_DIMENSION * TILE_SIZE, DRAW_GRID_DIMENSION * TILE_SIZE);
+  zoomScratchCanvas.setPivot(0, 0); // rescaleGridForZoom places the grid by its top left corner
   gpsCanvas.createSprite(SCREEN_WIDTH / 4, 128);
   hikeButtonCanvas.createSprite(SCREEN_WIDTH / 4, 128);
   bikeButtonCanvas.createSprite(SCREEN_WIDTH / 4, 128);
@@ -327,80 +461,120 @@ void drawImageMatrixTask(void *pvParameters)
   initSoundButton();   // Initialize the sound button once - moved to main.cpp
   initHikeButton();    // Initialize the hike overlay button
   initBikeButton();    // Initialize the bike overlay button
+
+  // Stacking order of the widgets on the screen (the compositor itself is initialized in main.cpp)
+  mapLayer = compositorAddLayer(&screenBufferCanvas, (M5.Display.width() - screenBufferCanvas.width()) / 2,
+                                (M5.Display.height() - screenBufferCanvas.height()) / 2);
+  varioLayer = compositorAddLayer(&varioCanvas, 0, 0);
+  verticalSpeedLayer = compositorAddLayer(&verticalSpeedCanvas, SCREEN_WIDTH / 2, 0);
+  gpsLayer = compositorAddLayer(&gpsCanvas, 0, M5.Display.height() - gpsCanvas.height());
+  soundButtonLayer = compositorAddLayer(&soundButtonCanvas, soundButtonX, soundButtonY);
+  hikeButtonLayer = compositorAddLayer(&hikeButtonCanvas, SCREEN_WIDTH / 2, M5.Display.height() - hikeButtonCanvas.height());
+  bikeButtonLayer = compositorAddLayer(&bikeButtonCanvas, bikeButtonX, bikeButtonY);
   ESP_LOGI("drawImageMatrixTask", "Direction icon initialized.");
   // ESP_LOGI("drawImageMatrixTask", "Sound button initialized.");
 
+  int guiSubscriber = telemetrySubscribe("GUI", TOPIC_MASK(TOPIC_GPS_FIX) | TOPIC_MASK(TOPIC_VARIO) | TOPIC_MASK(TOPIC_UI_INPUT),
+                                         GUI_TELEMETRY_QUEUE_DEPTH);
+  bool firstPass = true;
+
   while (true)
   {
-    // Acquire GPS data for map calculation
-    if (xSemaphoreTake(xGPSMutex, portMAX_DELAY) == pdTRUE)
+    // Sleep until a message arrives. Messages queued while the previous pass was still rendering are drained
+    // together, so a burst (e.g. several vario updates during one tile decode) is handled by a single pass.
+    uint32_t redraw = 0;
+    TelemetryMessage message;
+    if (firstPass)
     {
-      currentLatitude = globalLatitude;
-      currentLongitude = globalLongitude;
-      currentSpeed = globalSpeed;
-      currentValid = globalValid;
-      currentTestdata = globalTestdata;
-      xSemaphoreGive(xGPSMutex);
+      redraw = REDRAW_ALL; // Draw everything once
+      firstPass = false;
     }
-
-    if (currentValid || (USE_TESTDATA && currentTestdata)) // Use Testdata if nothing else.
+    else if (telemetryReceive(guiSubscriber, &message, portMAX_DELAY)) // No polling, every redraw is caused by a message
     {
-        // Calculate tile coordinates
-        currentTileZ = globalTileZ; // Use global zoom level
-        latLngToTile(currentLatitude, currentLongitude, currentTileZ, &currentTileX, &currentTileY);
-
-        // Update global tile coordinates
-        if (xSemaphoreTake(xPositionMutex, portMAX_DELAY) == pdTRUE)
-        {
-            globalTileX = currentTileX;
-            globalTileY = currentTileY;
-            globalTileZ = currentTileZ;
-            ESP_LOGV("TileCalc", "Task Tile X: %d, Tile Y: %d, Zoom: %d", globalTileX, globalTileY, globalTileZ);
-            xSemaphoreGive(xPositionMutex);
-        }
-
-        // Only set map update event if the center tile has changed
-        if (currentTileX != prevTileX || currentTileY != prevTileY || currentTileZ != prevTileZ)
-        {
-            xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_MAP_DATA_READY); // Signal GUI task for map update
-            prevTileX = currentTileX;
-            prevTileY = currentTileY;
-            prevTileZ = currentTileZ;
-        }
+      redraw = redrawForMessage(message);
     }
-
-    // Wait for GUI update events
-    EventBits_t uxBits = xEventGroupWaitBits(
-        xGuiUpdateEventGroup,
-        GUI_EVENT_GPS_DATA_READY | GUI_EVENT_VARIO_DATA_READY | GUI_EVENT_MAP_DATA_READY | GUI_EVENT_SOUND_BUTTON_READY,
-        pdTRUE,           // Clear bits on exit
-        pdFALSE,          // Don't wait for all bits
-        pdMS_TO_TICKS(10) // Wait for a short period, then re-evaluate
-    );
-
-    if ((uxBits & GUI_EVENT_MAP_DATA_READY) != 0)
+    while (telemetryReceive(guiSubscriber, &message, 0))
     {
-      ESP_LOGD("drawImageMatrixTask", "updateTiles: %.6f, %.6f, Z:%d, X:%d, Y:%d, Dir:%.2f",
-               currentLatitude, currentLongitude, currentTileZ, currentTileX, currentTileY, globalDirection);
-      updateTiles(currentLatitude, currentLongitude, currentTileZ, currentTileX, currentTileY, globalDirection);
+      redraw |= redrawForMessage(message);
     }
 
-    if ((uxBits & GUI_EVENT_GPS_DATA_READY) != 0)
+    // Widgets: redraw only the one that changed
+    if ((redraw & REDRAW_GPS) != 0)
     {
       updateDisplayWithGPSTelemetry();
     }
-
-    if ((uxBits & GUI_EVENT_VARIO_DATA_READY) != 0)
+    if ((redraw & REDRAW_VARIO) != 0)
     {
       updateDisplayWithVarioTelemetry();
     }
+    if ((redraw & REDRAW_SOUND_BUTTON) != 0)
+    {
+      drawSoundButton();
+    }
+    if ((redraw & REDRAW_HIKE_BUTTON) != 0)
+    {
+      drawHikeOverlayButton();
+    }
+    if ((redraw & REDRAW_BIKE_BUTTON) != 0)
+    {
+      drawBikeButton();
+    }
 
-    if ((uxBits & GUI_EVENT_SOUND_BUTTON_READY) != 0)
+    // Map: new position, pan/zoom or overlay toggle
+    if ((redraw & (REDRAW_GPS | REDRAW_MAP | REDRAW_HIKE_BUTTON | REDRAW_BIKE_BUTTON)) != 0)
     {
-      drawSoundButton(); // Draw directly to the main display
+      GpsSnapshot fix = gpsState.read(); // Consistent copy, never waits for the GPS task
+      currentLatitude = fix.latitude;
+      currentLongitude = fix.longitude;
+      double currentDirection = fix.direction;
+      currentValid = fix.valid;
+      currentTestdata = fix.testdata;
+
+      if (currentValid || (USE_TESTDATA && currentTestdata) || (redraw & REDRAW_MAP) != 0) // Use Testdata if nothing else.
+      {
+        currentTileZ = globalTileZ; // Use global zoom level
+        projectLatLng(currentLatitude, currentLongitude, currentTileZ, &currentPosition);
+        const int currentTileX = currentPosition.tileX;
+        const int currentTileY = currentPosition.tileY;
+
+        bool tileChanged = currentTileX != prevTileX || currentTileY != prevTileY || currentTileZ != prevTileZ;
+        if (tileChanged && xSemaphoreTake(xPositionMutex, portMAX_DELAY) == pdTRUE)
+        {
+          globalTileX = currentTileX;
+          globalTileY = currentTileY;
+          globalTileZ = currentTileZ;
+          ESP_LOGV("TileCalc", "Task Tile X: %d, Tile Y: %d, Zoom: %d", globalTileX, globalTileY, globalTileZ);
+          xSemaphoreGive(xPositionMutex);
+        }
+
+        bool overlaysChanged = (redraw & (REDRAW_HIKE_BUTTON | REDRAW_BIKE_BUTTON)) != 0;
+        if (tileChanged || overlaysChanged || (redraw & REDRAW_MAP) != 0)
+        {
+          ESP_LOGD("drawImageMatrixTask", "updateTiles: %.6f, %.6f, Z:%d, X:%d, Y:%d, Dir:%.2f",
+                   currentLatitude, currentLongitude, currentTileZ, currentTileX, currentTileY, currentDirection);
+          updateTiles(&currentPosition, currentTileZ, currentDirection);
+        }
+        else if (MAP_SMOOTH_FOLLOW &&
+                 (currentLatitude != prevLatitude || currentLongitude != prevLongitude || currentDirection != prevDirection))
+        {
+          // Same tile, new position: re-blit the decoded grid at the new pixel offset, no SD or decode work
+          renderScaledMapViewport(&currentPosition, currentDirection, globalPinchScale, globalPinchAnchorX, globalPinchAnchorY);
+        }
+        prevTileX = currentTileX;
+        prevTileY = currentTileY;
+        prevTileZ = currentTileZ;
+        prevLatitude = currentLatitude;
+        prevLongitude = currentLongitude;
+        prevDirection = currentDirection;
+      }
+    }
+    else if ((redraw & REDRAW_ZOOM_PREVIEW) != 0)
+    {
+      // Pinch in progress: scale the decoded grid only
+      renderScaledMapViewport(&currentPosition, prevDirection, globalPinchScale, globalPinchAnchorX, globalPinchAnchorY);
     }
 
-    // vTaskDelay(pdMS_TO_TICKS(10)); // Small delay to prevent busy-waiting, now handled by xEventGroupWaitBits timeout
+    compositorFlush(); // Push everything that changed in this pass as one frame
   }
 }
 
@@ -408,24 +582,12 @@ void drawImageMatrixTask(void *pvParameters)
 void updateDisplayWithVarioTelemetry()
 {
   // ESP_LOGD("updateDisplayWithVarioTelemetry", "Task started.");
-  float currentPressure = 0;
-  float currentTemperature = 0;
-  float currentBaroAltitude = 0;
-  float currentVerticalSpeed = 0;
-
-  if (xSemaphoreTake(xSensorMutex, portMAX_DELAY) == pdTRUE)
-  {
-    currentPressure = globalPressure;
-    currentTemperature = globalTemperature;
-    xSemaphoreGive(xSensorMutex);
-  }
-
-  if (xSemaphoreTake(xVariometerMutex, portMAX_DELAY) == pdTRUE)
-  {
-    currentBaroAltitude = globalAltitude_m;
-    currentVerticalSpeed = globalVerticalSpeed_mps;
-    xSemaphoreGive(xVariometerMutex);
-  }
+  SensorSnapshot sensor = sensorState.read();
+  VarioSnapshot vario = varioState.read();
+  float currentPressure = sensor.pressure;
+  float currentTemperature = sensor.temperature;
+  float currentBaroAltitude = vario.altitude;
+  float currentVerticalSpeed = vario.verticalSpeed;
 
   varioCanvas.clear(TFT_DARKGRAY);
   varioCanvas.setFont(&fonts::Font2);
@@ -434,9 +596,9 @@ void updateDisplayWithVarioTelemetry()
   varioCanvas.setCursor(0, 0);
   varioCanvas.printf("Pressure: %.1f hPa\n", currentPressure);
   varioCanvas.printf("Temperature: %.1f C\n", currentTemperature);
-  varioCanvas.printf("Altitude: %.1f m\n", currentBaroAltitude);
+  varioCanvas.printf("Altitude: %.1f +/- %.1f m\n", currentBaroAltitude, sqrtf(vario.altitudeVariance));
   varioCanvas.printf("Vertical Speed: %.1f m/s\n", currentVerticalSpeed);
-  varioCanvas.pushSprite(0, 0);
+  compositorMarkDirty(varioLayer);
 
   // implement vertical speed display
   if (currentVerticalSpeed > 0.5)
@@ -468,7 +630,7 @@ void updateDisplayWithVarioTelemetry()
 
   verticalSpeedCanvas.setCursor(x, y);
   verticalSpeedCanvas.printf(speedText);
-  verticalSpeedCanvas.pushSprite(SCREEN_WIDTH/2, 0);
+  compositorMarkDirty(verticalSpeedLayer);
 
   return;
 }
@@ -477,32 +639,25 @@ void updateDisplayWithVarioTelemetry()
 void updateDisplayWithGPSTelemetry()
 {
   // ESP_LOGD("updateDisplayWithGPSTelemetry", "Task started.");
-  double currentLatitude = 0;
-  double currentLongitude = 0;
-  double currentSpeed = 0;
-  double currentAltitude = 0;
-
-  if (xSemaphoreTake(xGPSMutex, portMAX_DELAY) == pdTRUE)
-  {
-    currentLatitude = globalLatitude;
-    currentLongitude = globalLongitude;
-    currentSpeed = globalSpeed;
-    currentAltitude = globalAltitude;
-    xSemaphoreGive(xGPSMutex);
-  }
+  GpsSnapshot fix = gpsState.read();
+  double currentLatitude = fix.latitude;
+  double currentLongitude = fix.longitude;
+  double currentSpeed = fix.speed;
+  double currentAltitude = fix.altitude;
+  bool currentValid = fix.valid;
  
   gpsCanvas.setFont(&fonts::Font2);
   gpsCanvas.setTextSize(2);
   gpsCanvas.setTextColor(TFT_WHITE);
   gpsCanvas.setCursor(0, 0);
-  ESP_LOGD("updateDisplayWithGPSTelemetry", "GPS Valid: %s, ManualMapMode: %s", globalValid ? "true" : "false", globalManualMapMode ? "true" : "false");
-  if (globalManualMapMode && !globalValid)
+  ESP_LOGD("updateDisplayWithGPSTelemetry", "GPS Valid: %s, ManualMapMode: %s", currentValid ? "true" : "false", globalManualMapMode ? "true" : "false");
+  if (globalManualMapMode && !currentValid)
   {
     gpsCanvas.clear(TFT_ORANGE);
     gpsCanvas.printf("Manual Map Mode\n");
     gpsCanvas.printf("Waiting for GPS fix...\n");
   }
-  else if (globalValid && !globalManualMapMode)
+  else if (currentValid && !globalManualMapMode)
   {
     gpsCanvas.clear(TFT_DARKGREEN);
     gpsCanvas.printf("Lat: %.5f\n", currentLatitude);
@@ -510,7 +665,7 @@ void updateDisplayWithGPSTelemetry()
     gpsCanvas.printf("Alt: %.1f m\n", currentAltitude);
     gpsCanvas.printf("Speed: %.1f km/h\n", currentSpeed);
   }
-  else if (globalValid && globalManualMapMode)
+  else if (currentValid && globalManualMapMode)
   {
     gpsCanvas.clear(TFT_ORANGE);
     gpsCanvas.printf("Manual Map Mode\n");
@@ -523,11 +678,7 @@ void updateDisplayWithGPSTelemetry()
     gpsCanvas.clear(TFT_DARKGRAY);
     gpsCanvas.printf("Waiting for GPS fix...\n");
   }
-  // Adjusting the pushSprite coordinates to be visible on a typical M5Stack screen.
-  // Assuming screen height is M5.Display.height().
-  // Place gpsCanvas at the bottom of the screen.
-  int gpsCanvasY = M5.Display.height() - gpsCanvas.height();
-  gpsCanvas.pushSprite(0, gpsCanvasY);
+  compositorMarkDirty(gpsLayer); // Placed at the bottom of the screen
 
   return;
 }
@@ -542,7 +693,7 @@ void drawDirectionIcon(M5Canvas &canvas, int centerX, int centerY, double direct
     return;
   }
 
-  if (globalValid)
+  if (gpsState.read().valid)
   {
     dir_icon.setPaletteColor(dir_icon_palette_id_fg, DIR_ICON_COLOR_ACTIVE);
   }
@@ -556,7 +707,6 @@ void drawDirectionIcon(M5Canvas &canvas, int centerX, int centerY, double direct
 }
 
 // Sound button variables buttom second/4 left
-M5Canvas soundButtonCanvas(&M5.Display);
 int soundButtonX;
 int soundButtonY;
 int soundButtonWidth;
@@ -590,7 +740,7 @@ void drawSoundButton()
 
   soundButtonCanvas.setCursor(x, y);
   soundButtonCanvas.printf(text);
-  soundButtonCanvas.pushSprite(soundButtonX, soundButtonY); // Push directly to M5.Display
+  compositorMarkDirty(soundButtonLayer);
 }
 
 // Hike Overlay button variables
@@ -630,7 +780,7 @@ void drawHikeOverlayButton()
 
   hikeButtonCanvas.setCursor(x, y);
   hikeButtonCanvas.printf(text);
-  hikeButtonCanvas.pushSprite(SCREEN_WIDTH/2, (M5.Display.height()-128));
+  compositorMarkDirty(hikeButtonLayer);
 }
 
 
@@ -673,5 +823,5 @@ void drawBikeButton()
 
   bikeButtonCanvas.setCursor(x, y);
   bikeButtonCanvas.printf(text);
-  bikeButtonCanvas.pushSprite(bikeButtonX, bikeButtonY);
+  compositorMarkDirty(bikeButtonLayer);
 }
@@ -2,7 +2,6 @@
 #define GUI_H
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/event_groups.h> // Include for EventGroupHandle_t
 
 #ifdef __cplusplus
 // C++ specific includes
@@ -12,15 +11,17 @@
 #include <string>
 #include <freertos/semphr.h> // For SemaphoreHandle_t
 #include "config.h" // For TILE_PATH_MAX_LENGTH
+#include "tile_calculator.h" // For TileProjection
 
 extern bool globalTwoFingerGestureActive; // New: Flag for active two-finger gesture
 extern int globalManualZoomLevel; // New: Manually set zoom level
+extern float globalPinchScale;
+extern int globalPinchAnchorX;
+extern int globalPinchAnchorY;
 
 extern "C" {
 #endif
 
-extern EventGroupHandle_t xGuiUpdateEventGroup;
-
 extern int soundButtonX;
 extern int soundButtonY;
 extern int soundButtonWidth;
@@ -34,16 +35,6 @@ extern int bikeButtonY;
 extern int bikeButtonWidth;
 extern int bikeButtonHeight;
 
-// Event bits for GUI updates
-#define GUI_EVENT_GPS_DATA_READY    (1 << 0)
-#define GUI_EVENT_VARIO_DATA_READY  (1 << 1)
-#define GUI_EVENT_MAP_DATA_READY    (1 << 2)
-#define GUI_EVENT_SOUND_BUTTON_READY (1 << 3)
-#define GUI_EVENT_TOUCH_DATA_READY (1 << 4) // New: Event bit for touch data updates
-#define GUI_EVENT_HIKE_BUTTON_READY (1 << 5) // New: Event bit for hike button
-#define GUI_EVENT_BIKE_BUTTON_READY (1 << 6) // New: Event bit for bike button
-
-extern char globalLastDrawnTilePath[TILE_PATH_MAX_LENGTH];
 extern char globalCurrentCenterTilePath[TILE_PATH_MAX_LENGTH];
 extern char tilePaths[SCREEN_BUFFER_TILE_DIMENSION][SCREEN_BUFFER_TILE_DIMENSION][TILE_PATH_MAX_LENGTH]; // Declare global tilePaths
 
@@ -52,7 +43,10 @@ void drawImageMatrixTask(void *pvParameters);
 bool drawJpgFromSD(const char* filePath);
 void drawDirectionIcon(M5Canvas& canvas, int centerX, int centerY, double direction);
 void drawSoundButton(); // Modified to not take canvas parameter
-void updateTiles(double currentLatitude, double currentLongitude, int currentTileZ, int currentTileX, int currentTileY, double globalDirection); // New: Declare updateTiles function
+// The position is projected once per GUI pass at currentTileZ and shared by the map functions
+void updateTiles(const struct TileProjection *position, int currentTileZ, double globalDirection); // New: Declare updateTiles function
+void renderMapViewport(const struct TileProjection *position, double globalDirection);
+void renderScaledMapViewport(const struct TileProjection *position, double globalDirection, float scale, int anchorX, int anchorY);
 void initHikeButton();
 void drawHikeOverlayButton();
 void initBikeButton();
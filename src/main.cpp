@@ -11,36 +11,39 @@
 #include "tile_calculator.h" // Include the new tile calculator header
 #include "gui.h"             // Include the new GUI header
 #include "variometer_task.h" // Include the new variometer task header
+#include "vario_audio.h"     // PCM synthesis of the vario tone
 #include "touch_task.h"      // Include the new touch task header
+#include "tile_cache.h"      // PSRAM cache of decoded map tiles
+#include "tile_loader.h"     // Map tile loading from archives or loose files
+#include "tile_prefetch.h"   // Background tile prefetcher
+#include "compositor.h"      // Double-buffered frame composition of the GUI layers
+#include "telemetry.h"       // Seqlock snapshots of GPS, sensor and vario state
 #include "config.h"         // Include configuration constants
 
 // global variables (define variables to be used throughout the program)
-EventGroupHandle_t xGuiUpdateEventGroup; // Declare the event group handle
 bool globalSoundEnabled = true; // Define global sound enable flag
 bool globalBikeOverlayEnabled = false; // New: Define global bike overlay enable flag
 bool globalHikeOverlayEnabled = false; // New: Define global hike overlay enable flag
 int globalManualZoomLevel = 0; // Define global manual zoom level, initialized to 0
 bool globalTwoFingerGestureActive = false; // New: Flag for active two-finger gesture
+float globalPinchScale = 1.0f; // Map scale of the pinch in progress, 1 when no pinch is active
+int globalPinchAnchorX = 0; // Screen point the pinch scales around
+int globalPinchAnchorY = 0;
 bool globalManualMapMode = false; // New: Flag to indicate if map is in manual drag mode
-float globalPressure;
-float globalTemperature;
-SemaphoreHandle_t xSensorMutex;
-
-// Variometer global variables
-extern float globalAltitude_m;
-extern float globalVerticalSpeed_mps;
-extern SemaphoreHandle_t xVariometerMutex;
-
-// GPS global variables
-double globalLatitude = 46.947597;
-double globalLongitude = 7.440434;
-double globalAltitude = 542.5; // Initial altitude set to Bern, Switzerland
-bool globalTestdata = false; // Flag to indicate if test data is being used
-bool globalValid = false; // Indicates if a valid GPS fix is available
-double globalDirection;
-double globalSpeed; // Added for GPS speed in km/h
-uint32_t globalTime;
-SemaphoreHandle_t xGPSMutex;
+// Position and altitude shown until the first fix: Bern, Switzerland. Everything else starts cleared (no fix yet).
+static GpsSnapshot initialGpsSnapshot()
+{
+  GpsSnapshot snapshot = {};
+  snapshot.latitude = 46.947597;
+  snapshot.longitude = 7.440434;
+  snapshot.altitude = 542.5;
+  return snapshot;
+}
+
+// Telemetry snapshots, written by one task each and read lock-free by the others
+Seqlock<GpsSnapshot> gpsState(initialGpsSnapshot());
+Seqlock<SensorSnapshot> sensorState;
+Seqlock<VarioSnapshot> varioState;
 
 // Global variables for tile coordinates
 SemaphoreHandle_t xPositionMutex;
@@ -116,16 +119,15 @@ void setup()
   M5.begin(cfg);            // initialize M5 device
   M5.Ex_I2C.begin();        // Initialize I2C for MS5637 with SDA=GPIO53, SCL=GPIO54
 
+  initTileCalculator(); // Per-zoom scales of the map projection
   initSensorTask();     // Initialize the sensor task components
   initGPSTask();        // Initialize the GPS task components
   initVariometerTask(); // Initialize the variometer task components
+  initVarioAudio();     // Tone generator of the variometer
   initTouchMonitorTask(); // Initialize the touch monitor task components
   initSoundButton();     // Initialize the sound button components
 
-  xSensorMutex = xSemaphoreCreateMutex();     // Initialize the sensor mutex
-  xGPSMutex = xSemaphoreCreateMutex();        // Initialize the GPS mutex
   xPositionMutex = xSemaphoreCreateMutex();   // Initialize the position mutex
-  xGuiUpdateEventGroup = xEventGroupCreate(); // Initialize the GUI update event group
 
   M5.Display.setTextSize(3);              // change text size
   M5.Display.print("Hello World!!!");     // display Hello World! and one line is displayed on the screen
@@ -144,6 +146,11 @@ void setup()
     listDir(SD_MMC, "/", 0); // List directories at the root level
   }
 
+  initTileLoader();                     // Open packed tile archives if present
+  initTileCache(TILE_CACHE_SIZE_BYTES); // Decoded tiles are kept in PSRAM
+  initTilePrefetchTask();               // Initialize the tile prefetch components
+  initCompositor(&M5.Display);          // Frame buffers for the GUI, flushed by CompositorFlushTask
+
   // Create and start the sensor reading task
   xTaskCreatePinnedToCore(
       sensorReadTask,   // Task function
@@ -165,7 +172,7 @@ void setup()
       NULL,             // Task handle
       APP_CPU_NUM);     // Core where the task should run (APP_CPU_NUM or PRO_CPU_NUM)
 
-  // Create and start the variometer audio task
+  // Create and start the variometer task
   xTaskCreatePinnedToCore(
       variometerTask,   // Task function
       "VariometerTask", // Name of task
@@ -175,6 +182,16 @@ void setup()
       NULL,             // Task handle
       APP_CPU_NUM);     // Core where the task should run (APP_CPU_NUM or PRO_CPU_NUM)
 
+  // Create and start the vario audio task, above the other tasks on its core so the speaker never runs dry
+  xTaskCreatePinnedToCore(
+      varioAudioTask,   // Task function
+      "VarioAudioTask", // Name of task
+      VARIO_AUDIO_TASK_STACK_SIZE, // Stack size (bytes)
+      NULL,             // Parameter to pass to function
+      3,                // Task priority (0 to configMAX_PRIORITIES - 1)
+      NULL,             // Task handle
+      APP_CPU_NUM);     // Core where the task should run (APP_CPU_NUM or PRO_CPU_NUM)
+
   // Create and start the touch monitoring task
   xTaskCreatePinnedToCore(
       touchMonitorTask,   // Task function
@@ -185,6 +202,26 @@ void setup()
       NULL,             // Task handle
       APP_CPU_NUM);     // Core where the task should run (APP_CPU_NUM or PRO_CPU_NUM)
 
+  // Create and start the low priority tile prefetch task
+  xTaskCreatePinnedToCore(
+      tilePrefetchTask,   // Task function
+      "TilePrefetchTask", // Name of task
+      PREFETCH_TASK_STACK_SIZE,             // Stack size (bytes)
+      NULL,             // Parameter to pass to function
+      tskIDLE_PRIORITY, // Task priority (0 to configMAX_PRIORITIES - 1)
+      NULL,             // Task handle
+      PREFETCH_TASK_CORE); // Core where the task should run (APP_CPU_NUM or PRO_CPU_NUM)
+
+  // Create and start the display flush task, pushes composed frames while the GUI task prepares the next one
+  xTaskCreatePinnedToCore(
+      compositorFlushTask,   // Task function
+      "CompositorFlushTask", // Name of task
+      COMPOSITOR_FLUSH_TASK_STACK_SIZE, // Stack size (bytes)
+      NULL,             // Parameter to pass to function
+      2,                // Task priority (0 to configMAX_PRIORITIES - 1)
+      NULL,             // Task handle
+      COMPOSITOR_FLUSH_TASK_CORE); // Core where the task should run (APP_CPU_NUM or PRO_CPU_NUM)
+
   // Create and start the image drawing task
   xTaskCreatePinnedToCore(
       drawImageMatrixTask,   // Task function
@@ -0,0 +1,128 @@
+#include "ms5637.h"
+
+static const uint8_t MS5637_ADDRESS = 0x76;
+static const uint8_t MS5637_CMD_RESET = 0x1E;
+static const uint8_t MS5637_CMD_ADC_READ = 0x00;
+static const uint8_t MS5637_CMD_PROM_READ = 0xA0; // + 2 * word
+static const uint8_t MS5637_CMD_CONVERT_D1 = 0x40; // + 2 * osr
+static const uint8_t MS5637_CMD_CONVERT_D2 = 0x50; // + 2 * osr
+static const uint32_t MS5637_RESET_TIME_MS = 3;
+
+// CRC4 over the PROM as in TE application note AN520, with the CRC nibble of word 0 cleared
+static uint8_t promCrc4(const uint16_t prom[7])
+{
+  uint16_t words[8];
+  for (int i = 0; i < 7; ++i)
+  {
+    words[i] = prom[i];
+  }
+  words[0] &= 0x0FFF;
+  words[7] = 0;
+
+  uint16_t remainder = 0;
+  for (int count = 0; count < 16; ++count)
+  {
+    remainder ^= (count % 2 == 1) ? (words[count >> 1] & 0x00FF) : (words[count >> 1] >> 8);
+    for (int bit = 8; bit > 0; --bit)
+    {
+      remainder = (remainder & 0x8000) ? (remainder << 1) ^ 0x3000 : (remainder << 1);
+    }
+  }
+  return (remainder >> 12) & 0x000F;
+}
+
+bool Ms5637::command(uint8_t cmd)
+{
+  wire->beginTransmission(MS5637_ADDRESS);
+  wire->write(cmd);
+  return wire->endTransmission() == 0;
+}
+
+bool Ms5637::begin(TwoWire &port)
+{
+  wire = &port;
+  if (!command(MS5637_CMD_RESET))
+  {
+    return false;
+  }
+  delay(MS5637_RESET_TIME_MS); // PROM reload after reset, once at startup
+
+  for (int word = 0; word < 7; ++word)
+  {
+    if (!command(MS5637_CMD_PROM_READ + 2 * word) || wire->requestFrom(MS5637_ADDRESS, (size_t)2) != 2)
+    {
+      return false;
+    }
+    prom[word] = (uint16_t)(wire->read() << 8);
+    prom[word] |= (uint16_t)wire->read();
+  }
+
+  uint8_t crc = promCrc4(prom);
+  if (crc != (prom[0] >> 12))
+  {
+    ESP_LOGE("MS5637", "PROM CRC mismatch: 0x%x, expected 0x%x", crc, prom[0] >> 12);
+    return false;
+  }
+  return true;
+}
+
+bool Ms5637::startConversion(Ms5637Channel channel, Ms5637Osr osr)
+{
+  uint8_t base = channel == MS5637_PRESSURE ? MS5637_CMD_CONVERT_D1 : MS5637_CMD_CONVERT_D2;
+  return command(base + 2 * osr);
+}
+
+bool Ms5637::readAdc(uint32_t *raw)
+{
+  if (!command(MS5637_CMD_ADC_READ) || wire->requestFrom(MS5637_ADDRESS, (size_t)3) != 3)
+  {
+    return false;
+  }
+  uint32_t value = (uint32_t)wire->read() << 16;
+  value |= (uint32_t)wire->read() << 8;
+  value |= (uint32_t)wire->read();
+  *raw = value;
+  return value != 0; // Reads 0 if the conversion had not finished
+}
+
+void Ms5637::compensate(uint32_t rawPressure, uint32_t rawTemperature, float *pressureHpa, float *temperatureC) const
+{
+  // Datasheet integer arithmetic, TEMP in 0.01 C and P in 0.01 hPa
+  int32_t dT = (int32_t)rawTemperature - ((int32_t)prom[5] << 8);
+  int32_t temp = 2000 + (int32_t)(((int64_t)dT * prom[6]) >> 23);
+  int64_t off = ((int64_t)prom[2] << 17) + (((int64_t)prom[4] * dT) >> 6);
+  int64_t sens = ((int64_t)prom[1] << 16) + (((int64_t)prom[3] * dT) >> 7);
+
+  int64_t t2;
+  int64_t off2 = 0;
+  int64_t sens2 = 0;
+  if (temp < 2000)
+  {
+    int64_t low = (int64_t)(temp - 2000) * (temp - 2000);
+    t2 = (3 * (int64_t)dT * dT) >> 33;
+    off2 = (61 * low) >> 4;
+    sens2 = (29 * low) >> 4;
+    if (temp < -1500)
+    {
+      int64_t veryLow = (int64_t)(temp + 1500) * (temp + 1500);
+      off2 += 17 * veryLow;
+      sens2 += 9 * veryLow;
+    }
+  }
+  else
+  {
+    t2 = (5 * (int64_t)dT * dT) >> 38;
+  }
+  off -= off2;
+  sens -= sens2;
+
+  int64_t pressure = ((((int64_t)rawPressure * sens) >> 21) - off) >> 15;
+  *pressureHpa = pressure / 100.0f;
+  *temperatureC = (temp - t2) / 100.0f;
+}
+
+uint32_t Ms5637::conversionTimeUs(Ms5637Osr osr)
+{
+  static const uint32_t conversionTimes[] = {540, 1060, 2080, 4130, 8220, 16440};
+  return conversionTimes[osr];
+}
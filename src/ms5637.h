@@ -0,0 +1,48 @@
+#ifndef MS5637_H
+#define MS5637_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <stdint.h>
+
+// Minimal non-blocking driver for the TE MS5637 barometer. A measurement is split into startConversion() and
+// readAdc(); the caller sleeps for conversionTimeUs() in between instead of the driver busy-waiting, so pressure
+// and temperature conversions can be scheduled independently, each with its own oversampling ratio.
+
+enum Ms5637Osr
+{
+  MS5637_OSR_256 = 0,
+  MS5637_OSR_512,
+  MS5637_OSR_1024,
+  MS5637_OSR_2048,
+  MS5637_OSR_4096,
+  MS5637_OSR_8192
+};
+
+enum Ms5637Channel
+{
+  MS5637_PRESSURE = 0, // D1
+  MS5637_TEMPERATURE   // D2
+};
+
+class Ms5637
+{
+public:
+  // Reset the sensor and read the calibration PROM. Fails if the sensor does not answer or the PROM CRC is wrong.
+  bool begin(TwoWire &wire);
+  bool startConversion(Ms5637Channel channel, Ms5637Osr osr);
+  // Raw 24-bit result of the last conversion; false on an I2C error or if the conversion was not finished yet
+  bool readAdc(uint32_t *raw);
+  // First and second order compensation of a raw pressure (D1) and temperature (D2) pair
+  void compensate(uint32_t rawPressure, uint32_t rawTemperature, float *pressureHpa, float *temperatureC) const;
+  // Maximum conversion time from the datasheet
+  static uint32_t conversionTimeUs(Ms5637Osr osr);
+
+private:
+  bool command(uint8_t cmd);
+
+  TwoWire *wire = nullptr;
+  uint16_t prom[7] = {}; // prom[1..6] are the coefficients C1..C6
+};
+
+#endif // MS5637_H
@@ -0,0 +1,345 @@
+#include "nmea_parser.h"
+#include <string.h>
+
+// Parse "[-]123.456". Empty fields return false and leave value untouched.
+static bool parseDecimal(const char *field, double *value)
+{
+  bool negative = *field == '-';
+  if (negative || *field == '+')
+  {
+    field++;
+  }
+  if (*field == '\0')
+  {
+    return false;
+  }
+
+  uint64_t mantissa = 0;
+  double divisor = 1.0;
+  bool fraction = false;
+  for (; *field != '\0'; ++field)
+  {
+    if (*field == '.' && !fraction)
+    {
+      fraction = true;
+    }
+    else if (*field >= '0' && *field <= '9')
+    {
+      mantissa = mantissa * 10 + (*field - '0');
+      if (fraction)
+      {
+        divisor *= 10.0;
+      }
+    }
+    else
+    {
+      return false;
+    }
+  }
+  *value = (negative ? -(double)mantissa : (double)mantissa) / divisor;
+  return true;
+}
+
+static bool parseInteger(const char *field, uint32_t *value)
+{
+  if (*field < '0' || *field > '9')
+  {
+    return false;
+  }
+  uint32_t result = 0;
+  for (; *field >= '0' && *field <= '9'; ++field)
+  {
+    result = result * 10 + (*field - '0');
+  }
+  *value = result;
+  return true;
+}
+
+// "hhmmss.ss" -> hhmmsscc
+static void parseTime(const char *field, uint32_t *time)
+{
+  double value;
+  if (parseDecimal(field, &value))
+  {
+    *time = (uint32_t)(value * 100.0 + 0.5);
+  }
+}
+
+// "ddmm.mmmm" / "dddmm.mmmm" plus hemisphere -> signed degrees
+static bool parseCoordinate(const char *field, const char *hemisphere, double *degrees)
+{
+  double value;
+  if (!parseDecimal(field, &value))
+  {
+    return false;
+  }
+  int wholeDegrees = (int)(value / 100.0);
+  double result = wholeDegrees + (value - wholeDegrees * 100.0) / 60.0;
+  *degrees = (*hemisphere == 'S' || *hemisphere == 'W') ? -result : result;
+  return true;
+}
+
+static bool parsePosition(char *const *fields, int latitudeField, NmeaFix &fix)
+{
+  double latitude, longitude;
+  if (!parseCoordinate(fields[latitudeField], fields[latitudeField + 1], &latitude) ||
+      !parseCoordinate(fields[latitudeField + 2], fields[latitudeField + 3], &longitude))
+  {
+    return false;
+  }
+  fix.latitude = latitude;
+  fix.longitude = longitude;
+  return true;
+}
+
+static void parseFloat(const char *field, float *value)
+{
+  double parsed;
+  if (parseDecimal(field, &parsed))
+  {
+    *value = (float)parsed;
+  }
+}
+
+// $xxGGA,time,lat,N,lon,E,quality,satellites,hdop,altitude,M,...
+static void parseGga(char *const *fields, int count, NmeaFix &fix)
+{
+  (void)count;
+  uint32_t value;
+  parseTime(fields[1], &fix.time);
+  fix.quality = parseInteger(fields[6], &value) ? (uint8_t)value : 0;
+  if (parseInteger(fields[7], &value))
+  {
+    fix.satellites = (uint8_t)value;
+  }
+  parseFloat(fields[8], &fix.hdop);
+  if (parseDecimal(fields[9], &fix.altitude))
+  {
+    fix.altitudeCount++;
+  }
+  fix.locationValid = parsePosition(fields, 2, fix) && fix.quality > 0;
+}
+
+// $xxRMC,time,status,lat,N,lon,E,speed knots,course,date,...
+static void parseRmc(char *const *fields, int count, NmeaFix &fix)
+{
+  (void)count;
+  double knots;
+  parseTime(fields[1], &fix.time);
+  if (parseDecimal(fields[7], &knots))
+  {
+    fix.speedKmph = knots * 1.852;
+  }
+  parseDecimal(fields[8], &fix.courseDeg);
+  parseInteger(fields[9], &fix.date);
+  fix.locationValid = parsePosition(fields, 3, fix) && fields[2][0] == 'A';
+}
+
+// $xxVTG,course,T,course magnetic,M,speed knots,N,speed km/h,K,...
+static void parseVtg(char *const *fields, int count, NmeaFix &fix)
+{
+  (void)count;
+  parseDecimal(fields[1], &fix.courseDeg);
+  parseDecimal(fields[7], &fix.speedKmph);
+}
+
+// $xxGSA,mode,fix type,12 x satellite id,pdop,hdop,vdop[,system id]
+static void parseGsa(char *const *fields, int count, NmeaFix &fix)
+{
+  (void)count;
+  uint32_t value;
+  if (parseInteger(fields[2], &value))
+  {
+    fix.fixMode = (uint8_t)value;
+  }
+  parseFloat(fields[15], &fix.pdop);
+  parseFloat(fields[16], &fix.hdop);
+  parseFloat(fields[17], &fix.vdop);
+}
+
+struct NmeaSentenceHandler
+{
+  char id[4];    // Sentence formatter without the talker, e.g. "GGA"
+  int minFields; // Including the address field
+  void (*parse)(char *const *fields, int count, NmeaFix &fix);
+};
+
+// Indexed by NmeaSentenceType
+static const NmeaSentenceHandler sentenceHandlers[NMEA_SENTENCE_COUNT] = {
+    {"GGA", 10, parseGga},
+    {"RMC", 10, parseRmc},
+    {"VTG", 8, parseVtg},
+    {"GSA", 18, parseGsa},
+};
+
+static int hexDigit(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+static const uint8_t EPOCH_POSITION_SENTENCES = (1 << NMEA_GGA) | (1 << NMEA_RMC);
+
+NmeaParser::NmeaParser()
+    : lineLength(0), inSentence(false), overflow(false), currentFix(), parserStats(), epochTime(UINT32_MAX),
+      epochSentences(0), epochExpected(EPOCH_POSITION_SENTENCES), epochReported(false)
+{
+}
+
+bool NmeaParser::completesEpoch(NmeaSentenceType type)
+{
+  uint8_t bit = 1 << type;
+  // A new time starts an epoch; so does a repeated sentence type, e.g. while the receiver has no time yet
+  if (currentFix.time != epochTime || (epochSentences & bit) != 0)
+  {
+    if (epochSentences != 0 && !epochReported)
+    {
+      epochExpected = epochSentences; // The last epoch ended with fewer sentences, the receiver does not send the others
+    }
+    epochTime = currentFix.time;
+    epochSentences = 0;
+    epochReported = false;
+  }
+  epochSentences |= bit;
+
+  if (epochReported)
+  {
+    epochExpected |= bit; // More sentences than expected: wait for them from the next epoch on
+    return false;
+  }
+  if ((epochSentences & epochExpected) != epochExpected)
+  {
+    return false;
+  }
+  epochReported = true;
+  parserStats.epochs++;
+  return true;
+}
+
+void NmeaParser::parse(const char *data, size_t length, NmeaSentenceCallback callback, void *context)
+{
+  parserStats.bytes += length;
+  for (size_t i = 0; i < length; ++i)
+  {
+    char c = data[i];
+    if (c == '$')
+    {
+      if (inSentence)
+      {
+        parserStats.malformed++; // Previous sentence was cut off
+      }
+      inSentence = true;
+      overflow = false;
+      line[0] = c;
+      lineLength = 1;
+    }
+    else if (!inSentence)
+    {
+      continue; // Noise or binary replies between sentences
+    }
+    else if (c == '\r' || c == '\n')
+    {
+      inSentence = false;
+      if (overflow)
+      {
+        parserStats.malformed++;
+        continue;
+      }
+      line[lineLength] = '\0';
+      NmeaSentenceType type = processSentence();
+      if (type == NMEA_SENTENCE_COUNT)
+      {
+        continue;
+      }
+      bool epochComplete = (type == NMEA_GGA || type == NMEA_RMC) && completesEpoch(type);
+      if (callback != nullptr)
+      {
+        callback(type, currentFix, epochComplete, context);
+      }
+    }
+    else if (lineLength < (size_t)NMEA_MAX_SENTENCE_LENGTH)
+    {
+      line[lineLength++] = c;
+    }
+    else
+    {
+      overflow = true; // Keep consuming until the line end, then drop it
+    }
+  }
+}
+
+NmeaSentenceType NmeaParser::processSentence()
+{
+  char *star = (char *)memchr(line, '*', lineLength);
+  if (star == nullptr || star + 2 >= line + lineLength || hexDigit(star[1]) < 0 || hexDigit(star[2]) < 0)
+  {
+    parserStats.malformed++;
+    return NMEA_SENTENCE_COUNT;
+  }
+
+  // "$ttFFF,": the formatter follows the two talker characters
+  NmeaSentenceType type = NMEA_SENTENCE_COUNT;
+  if (star - line >= 7 && line[6] == ',')
+  {
+    for (int i = 0; i < NMEA_SENTENCE_COUNT; ++i)
+    {
+      if (memcmp(line + 3, sentenceHandlers[i].id, 3) == 0)
+      {
+        type = (NmeaSentenceType)i;
+        break;
+      }
+    }
+  }
+
+  uint8_t checksum = 0;
+  for (const char *c = line + 1; c < star; ++c)
+  {
+    checksum ^= (uint8_t)*c;
+  }
+  if (checksum != ((hexDigit(star[1]) << 4) | hexDigit(star[2])))
+  {
+    parserStats.checksumErrors++;
+    if (type != NMEA_SENTENCE_COUNT)
+    {
+      parserStats.sentences[type].checksumErrors++;
+    }
+    return NMEA_SENTENCE_COUNT;
+  }
+  if (type == NMEA_SENTENCE_COUNT)
+  {
+    parserStats.unsupported++;
+    return NMEA_SENTENCE_COUNT;
+  }
+
+  // Split in place; empty fields become empty strings
+  *star = '\0';
+  char *fields[NMEA_MAX_FIELDS];
+  int count = 0;
+  char *field = line + 1;
+  while (count < NMEA_MAX_FIELDS)
+  {
+    fields[count++] = field;
+    char *comma = strchr(field, ',');
+    if (comma == nullptr)
+    {
+      break;
+    }
+    *comma = '\0';
+    field = comma + 1;
+  }
+
+  const NmeaSentenceHandler &handler = sentenceHandlers[type];
+  if (count < handler.minFields)
+  {
+    parserStats.malformed++;
+    return NMEA_SENTENCE_COUNT;
+  }
+  handler.parse(fields, count, currentFix);
+  parserStats.sentences[type].parsed++;
+  return type;
+}
@@ -0,0 +1,91 @@
+#ifndef NMEA_PARSER_H
+#define NMEA_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Allocation-free NMEA 0183 parser for GGA, RMC, VTG and GSA from any talker (GP, GN, GL, BD, ...).
+// Buffers of any size are fed with parse(); sentences are assembled in a fixed line buffer, checksum validated,
+// split into fields in place and handed to the handler of their type from a table. Every accepted sentence is
+// reported through a callback together with the updated fix.
+// A receiver sends several position sentences per navigation epoch (GGA and RMC with the same UTC time). The
+// callback flags the sentence that completes an epoch, so a consumer can take one fix per epoch. Which sentences
+// make up an epoch is learned: a receiver that only sends RMC completes its epochs with every RMC.
+
+const int NMEA_MAX_SENTENCE_LENGTH = 96; // 82 by the standard, some receivers exceed it slightly
+const int NMEA_MAX_FIELDS = 24;
+
+enum NmeaSentenceType
+{
+  NMEA_GGA = 0, // Time, position, fix quality, satellites, HDOP, altitude
+  NMEA_RMC,     // Time, date, status, position, speed, course
+  NMEA_VTG,     // Course and speed
+  NMEA_GSA,     // Fix mode and DOPs
+  NMEA_SENTENCE_COUNT
+};
+
+struct NmeaFix
+{
+  double latitude;   // deg, south negative
+  double longitude;  // deg, west negative
+  double altitude;   // m above mean sea level
+  uint32_t altitudeCount; // GGA sentences that carried an altitude, tells a new altitude from a repeated one
+  double speedKmph;
+  double courseDeg;  // Course over ground, true
+  uint32_t time;     // UTC hhmmsscc, as TinyGPSPlus reports it
+  uint32_t date;     // ddmmyy
+  uint8_t quality;   // GGA fix quality, 0 = no fix
+  uint8_t satellites;
+  uint8_t fixMode;   // GSA: 1 = no fix, 2 = 2D, 3 = 3D
+  float hdop;
+  float pdop;
+  float vdop;
+  bool locationValid; // Last GGA or RMC carried a valid position
+};
+
+struct NmeaSentenceStats
+{
+  uint32_t parsed;         // Sentences with a valid checksum
+  uint32_t checksumErrors; // Sentences rejected by the checksum
+};
+
+struct NmeaParserStats
+{
+  NmeaSentenceStats sentences[NMEA_SENTENCE_COUNT];
+  uint32_t checksumErrors; // All sentence types, also the unsupported ones
+  uint32_t unsupported;    // Valid sentences of other types, e.g. GSV or proprietary replies
+  uint32_t malformed;      // Too long, missing checksum or too few fields
+  uint32_t bytes;
+  uint32_t epochs;         // Completed navigation epochs
+};
+
+typedef void (*NmeaSentenceCallback)(NmeaSentenceType type, const NmeaFix &fix, bool epochComplete, void *context);
+
+class NmeaParser
+{
+public:
+  NmeaParser();
+  // Feed received bytes. callback is called for every accepted GGA/RMC/VTG/GSA sentence, in order.
+  void parse(const char *data, size_t length, NmeaSentenceCallback callback = nullptr, void *context = nullptr);
+  const NmeaFix &fix() const { return currentFix; }
+  const NmeaParserStats &stats() const { return parserStats; }
+
+private:
+  // Returns the type of the completed sentence, or NMEA_SENTENCE_COUNT if it was rejected
+  NmeaSentenceType processSentence();
+  // Account a GGA or RMC to its epoch; true if it completes the epoch
+  bool completesEpoch(NmeaSentenceType type);
+
+  char line[NMEA_MAX_SENTENCE_LENGTH + 1];
+  size_t lineLength;
+  bool inSentence;
+  bool overflow;
+  NmeaFix currentFix;
+  NmeaParserStats parserStats;
+  uint32_t epochTime;     // UTC time of the current epoch
+  uint8_t epochSentences; // Bit per NmeaSentenceType received in the current epoch
+  uint8_t epochExpected;  // Sentences that complete an epoch
+  bool epochReported;
+};
+
+#endif // NMEA_PARSER_H
@@ -0,0 +1,65 @@
+#include "pressure_altitude.h"
+#include <M5Unified.h>
+#include <math.h>
+#include "config.h"
+
+// Segment [p0, p0 + step) holds h(p0 + t * step) = c[0] + t * (c[1] + t * (c[2] + t * c[3])), t in [0, 1)
+static float segments[PRESSURE_ALTITUDE_SEGMENTS][4];
+static float qnhHpa = STANDARD_SEA_LEVEL_PRESSURE_HPA;
+static float qnhScale = 1.0f;  // (1013.25 / QNH)^(1/B)
+static float qnhOffset = 0.0f; // A * (1 - qnhScale)
+
+static const float PRESSURE_ALTITUDE_MAX_HPA = PRESSURE_ALTITUDE_MIN_HPA + PRESSURE_ALTITUDE_SEGMENTS * PRESSURE_ALTITUDE_STEP_HPA;
+
+float pressureToAltitudeExact(float pressureHpa, float qnhHpa)
+{
+  return ALTITUDE_CONSTANT_A * (1.0 - pow(pressureHpa / qnhHpa, 1.0 / ALTITUDE_CONSTANT_B));
+}
+
+void initPressureAltitude()
+{
+  const double exponent = 1.0 / ALTITUDE_CONSTANT_B;
+  for (int i = 0; i < PRESSURE_ALTITUDE_SEGMENTS; ++i)
+  {
+    double p0 = PRESSURE_ALTITUDE_MIN_HPA + i * PRESSURE_ALTITUDE_STEP_HPA;
+    double p1 = p0 + PRESSURE_ALTITUDE_STEP_HPA;
+    double ratio0 = pow(p0 / STANDARD_SEA_LEVEL_PRESSURE_HPA, exponent);
+    double ratio1 = pow(p1 / STANDARD_SEA_LEVEL_PRESSURE_HPA, exponent);
+    double h0 = ALTITUDE_CONSTANT_A * (1.0 - ratio0);
+    double h1 = ALTITUDE_CONSTANT_A * (1.0 - ratio1);
+    // Slopes dh/dt at both ends, t = (p - p0) / step
+    double d0 = -ALTITUDE_CONSTANT_A * exponent * ratio0 / p0 * PRESSURE_ALTITUDE_STEP_HPA;
+    double d1 = -ALTITUDE_CONSTANT_A * exponent * ratio1 / p1 * PRESSURE_ALTITUDE_STEP_HPA;
+    segments[i][0] = h0;
+    segments[i][1] = d0;
+    segments[i][2] = 3.0 * (h1 - h0) - 2.0 * d0 - d1;
+    segments[i][3] = 2.0 * (h0 - h1) + d0 + d1;
+  }
+  setPressureAltitudeQnh(VARIO_QNH_HPA);
+}
+
+void setPressureAltitudeQnh(float newQnhHpa)
+{
+  qnhHpa = newQnhHpa;
+  qnhScale = pow(STANDARD_SEA_LEVEL_PRESSURE_HPA / newQnhHpa, 1.0 / ALTITUDE_CONSTANT_B);
+  qnhOffset = ALTITUDE_CONSTANT_A * (1.0f - qnhScale);
+}
+
+float getPressureAltitudeQnh()
+{
+  return qnhHpa;
+}
+
+float pressureToAltitude(float pressureHpa)
+{
+  if (!(pressureHpa >= PRESSURE_ALTITUDE_MIN_HPA && pressureHpa < PRESSURE_ALTITUDE_MAX_HPA))
+  {
+    return pressureToAltitudeExact(pressureHpa, qnhHpa); // Also passes NaN through
+  }
+  float position = (pressureHpa - PRESSURE_ALTITUDE_MIN_HPA) * (1.0f / PRESSURE_ALTITUDE_STEP_HPA);
+  int i = (int)position;
+  float t = position - i;
+  const float *c = segments[i];
+  float standardAltitude = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+  return standardAltitude * qnhScale + qnhOffset;
+}
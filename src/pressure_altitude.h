@@ -0,0 +1,19 @@
+#ifndef PRESSURE_ALTITUDE_H
+#define PRESSURE_ALTITUDE_H
+
+// Barometric altitude of the standard atmosphere, h = A * (1 - (p / QNH)^(1/B)), without pow() per sample.
+// The standard pressure altitude (QNH 1013.25 hPa) is tabulated as piecewise cubic Hermite polynomials over the
+// flyable pressure range. Another QNH only scales and shifts it:
+//   h(p, QNH) = A + (h(p, 1013.25) - A) * (1013.25 / QNH)^(1/B)
+// so changing the QNH costs one pow() and the table stays valid. Outside the table the exact formula is used.
+
+// Build the table and set the QNH to VARIO_QNH_HPA
+void initPressureAltitude();
+// Not synchronized, call before the variometer task starts or from it
+void setPressureAltitudeQnh(float qnhHpa);
+float getPressureAltitudeQnh();
+float pressureToAltitude(float pressureHpa);
+// Previous double precision pow() formula, used outside the table and as the reference of the host test
+float pressureToAltitudeExact(float pressureHpa, float qnhHpa);
+
+#endif // PRESSURE_ALTITUDE_H
@@ -1,17 +1,28 @@
 #include "sensor_task.h"
 #include <M5Unified.h>
-#include <SparkFun_MS5637_Arduino_Library.h>
-#include <freertos/semphr.h> // Required for mutex
+#include <algorithm> // For std::max
+#include "ms5637.h"
+#include "telemetry.h"
+#include "telemetry_bus.h"
+#include "config.h"
 
-// Declare extern global variables and mutex from main.cpp
-extern float globalPressure;
-extern float globalTemperature;
-extern SemaphoreHandle_t xSensorMutex;
-
-MS5637 barometricSensor;
+static Ms5637 barometricSensor;
 static uint32_t sensor_count = 0;
+static uint32_t sensor_errors = 0;
+
+// Acquisition cycle: one temperature conversion every BARO_TEMPERATURE_DECIMATION pressure conversions
+enum SensorState
+{
+    SENSOR_START_TEMPERATURE,
+    SENSOR_READ_TEMPERATURE,
+    SENSOR_START_PRESSURE,
+    SENSOR_READ_PRESSURE
+};
 
 void initSensorTask() {
+    Wire.begin(M5.Ex_I2C.getSDA(), M5.Ex_I2C.getSCL()); // Reconfigure default Wire to use M5.Ex_I2C pins
+    Wire.setClock(400000); // Set I2C frequency to 400kHz for MS5637
+
     if (barometricSensor.begin(Wire) == false)
     {
         ESP_LOGE("Climb", "MS5637 sensor did not respond. Please check wiring and I2C address.");
@@ -22,25 +33,88 @@ void initSensorTask() {
     }
 }
 
+// Sleep at least us microseconds; the task blocks, the CPU is free during the conversion.
+// vTaskDelay(n) ends at the n-th tick interrupt, the first one can follow right away, so one tick is added.
+static void sleepUs(uint32_t us) {
+    TickType_t ticks = (TickType_t)(((uint64_t)us * configTICK_RATE_HZ + 999999) / 1000000);
+    vTaskDelay(ticks + 1);
+}
+
 void sensorReadTask(void *pvParameters) {
     (void) pvParameters; // Suppress unused parameter warning
 
-    Wire.begin(M5.Ex_I2C.getSDA(), M5.Ex_I2C.getSCL()); // Reconfigure default Wire to use M5.Ex_I2C pins
-    Wire.setClock(400000); // Set I2C frequency to 400kHz for MS5637
+    const Ms5637Osr pressureOsr = (Ms5637Osr)BARO_PRESSURE_OSR;
+    const Ms5637Osr temperatureOsr = (Ms5637Osr)BARO_TEMPERATURE_OSR;
+    const TickType_t pressurePeriod = std::max<TickType_t>(pdMS_TO_TICKS(1000 / BARO_PRESSURE_RATE_HZ), 1);
+
+    SensorState state = SENSOR_START_TEMPERATURE; // Pressure compensation needs a temperature first
+    uint32_t rawTemperature = 0;
+    int pressureSamplesSinceTemperature = 0;
+    uint32_t conversionStartUs = 0;
+    TickType_t lastPressureTick = xTaskGetTickCount();
+    unsigned long lastStatsLogTime = millis();
+    uint32_t lastStatsCount = 0;
 
     for (;;) {
-        float pressure = barometricSensor.getPressure();
-        float temperature = barometricSensor.getTemperature();
-        
-        if (xSemaphoreTake(xSensorMutex, (TickType_t)10) == pdTRUE) { // Attempt to take mutex with a timeout
-            globalPressure = pressure;
-            globalTemperature = temperature;
-            xSemaphoreGive(xSensorMutex);
-        } else {
-            ESP_LOGE("Climb", "SensorReadTask: Could not take sensor mutex.");
+        switch (state) {
+        case SENSOR_START_TEMPERATURE:
+            if (barometricSensor.startConversion(MS5637_TEMPERATURE, temperatureOsr)) {
+                sleepUs(Ms5637::conversionTimeUs(temperatureOsr));
+                state = SENSOR_READ_TEMPERATURE;
+            } else {
+                sensor_errors++;
+                sleepUs(Ms5637::conversionTimeUs(temperatureOsr)); // Bus busy or sensor absent, try again later
+            }
+            break;
+
+        case SENSOR_READ_TEMPERATURE:
+            if (barometricSensor.readAdc(&rawTemperature)) {
+                pressureSamplesSinceTemperature = 0;
+                state = SENSOR_START_PRESSURE;
+            } else {
+                sensor_errors++;
+                state = SENSOR_START_TEMPERATURE;
+            }
+            break;
+
+        case SENSOR_START_PRESSURE:
+            vTaskDelayUntil(&lastPressureTick, pressurePeriod); // Fixed sample rate, the wait replaces busy polling
+            conversionStartUs = micros();
+            if (barometricSensor.startConversion(MS5637_PRESSURE, pressureOsr)) {
+                sleepUs(Ms5637::conversionTimeUs(pressureOsr));
+                state = SENSOR_READ_PRESSURE;
+            } else {
+                sensor_errors++;
+            }
+            break;
+
+        case SENSOR_READ_PRESSURE:
+        {
+            uint32_t rawPressure;
+            if (barometricSensor.readAdc(&rawPressure)) {
+                float pressure;
+                float temperature;
+                barometricSensor.compensate(rawPressure, rawTemperature, &pressure, &temperature);
+                // Timestamp the middle of the conversion, when the sample was effectively taken
+                uint32_t sampleUs = conversionStartUs + Ms5637::conversionTimeUs(pressureOsr) / 2;
+                SensorSnapshot sample = {pressure, temperature, (uint32_t)millis(), sampleUs};
+                sensorState.write(sample); // Never blocks on readers
+                telemetryPublish(sample);
+                sensor_count++;
+                pressureSamplesSinceTemperature++;
+            } else {
+                sensor_errors++;
+            }
+            state = pressureSamplesSinceTemperature >= BARO_TEMPERATURE_DECIMATION ? SENSOR_START_TEMPERATURE : SENSOR_START_PRESSURE;
+            break;
+        }
         }
 
-        sensor_count++;
-        vTaskDelay(pdMS_TO_TICKS(200)); // Wait 0.2 second
+        if (millis() - lastStatsLogTime >= BARO_STATS_LOG_INTERVAL_MS) {
+            float seconds = (millis() - lastStatsLogTime) / 1000.0f;
+            ESP_LOGI("Climb", "Barometer: %.1f samples/s, %lu errors", (sensor_count - lastStatsCount) / seconds, sensor_errors);
+            lastStatsLogTime = millis();
+            lastStatsCount = sensor_count;
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,121 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <atomic>
+#include <string.h>
+#include <type_traits>
+
+// Single-writer-at-a-time, many-reader snapshot of a small trivially copyable struct.
+// Writers are serialized by a spinlock and never wait for readers. Readers never take a lock: they copy the value
+// and retry if a write overlapped the copy, so a reader cannot delay or invert the priority of a writer.
+template <typename T>
+class Seqlock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock values are copied with memcpy");
+
+public:
+  explicit Seqlock(const T &initial = T()) : value(initial)
+  {
+    portMUX_INITIALIZE(&writerMux);
+  }
+
+  // Consistent copy of the latest value
+  T read() const
+  {
+    T copy;
+    for (;;)
+    {
+      uint32_t before = sequence.load(std::memory_order_acquire);
+      if ((before & 1) == 0) // Even: no write in progress
+      {
+        memcpy(&copy, (const void *)&value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before)
+        {
+          return copy;
+        }
+      }
+      // A write is running on the other core with interrupts off; it takes well below a microsecond
+    }
+  }
+
+  void write(const T &newValue)
+  {
+    portENTER_CRITICAL(&writerMux);
+    beginWrite();
+    memcpy((void *)&value, &newValue, sizeof(T));
+    endWrite();
+    portEXIT_CRITICAL(&writerMux);
+  }
+
+  // Read-modify-write of some fields, e.g. a map pan changing the position but not the rest of the fix.
+  // update runs inside the writer critical section and must be short.
+  template <typename F>
+  void modify(F update)
+  {
+    portENTER_CRITICAL(&writerMux);
+    beginWrite();
+    update(value);
+    endWrite();
+    portEXIT_CRITICAL(&writerMux);
+  }
+
+private:
+  void beginWrite()
+  {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void endWrite()
+  {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  T value;
+  std::atomic<uint32_t> sequence{0}; // Odd while a write is in progress
+  portMUX_TYPE writerMux;
+};
+
+// Latest GPS fix, or the map position set by panning
+struct GpsSnapshot
+{
+  double latitude;
+  double longitude;
+  double altitude;  // m
+  uint32_t altitudeCount; // Changes with every new GPS altitude measurement (NmeaFix::altitudeCount)
+  double direction; // Course over ground, deg
+  double speed;     // km/h
+  uint32_t time;    // hhmmsscc
+  bool valid;       // A real fix is available
+  bool testdata;    // Position comes from gpsTestData.h
+  uint32_t updateMs; // millis() of the last update
+};
+
+// Latest barometer sample
+struct SensorSnapshot
+{
+  float pressure;    // hPa
+  float temperature; // C
+  uint32_t updateMs;
+  uint32_t sampleUs; // micros() in the middle of the pressure conversion
+};
+
+// Latest variometer output
+struct VarioSnapshot
+{
+  float altitude;      // m, fused barometer and GPS
+  float verticalSpeed; // m/s
+  uint32_t updateMs;
+  float altitudeVariance;      // m^2, estimate uncertainty of the fusion filter
+  float verticalSpeedVariance; // (m/s)^2
+};
+
+// Defined in main.cpp
+extern Seqlock<GpsSnapshot> gpsState;
+extern Seqlock<SensorSnapshot> sensorState;
+extern Seqlock<VarioSnapshot> varioState;
+
+#endif // TELEMETRY_H
@@ -0,0 +1,187 @@
+#include "telemetry_bus.h"
+#include <M5Unified.h>
+#include <freertos/queue.h>
+#include <atomic>
+#include <algorithm> // For std::max
+#include "config.h"
+
+struct TelemetrySubscriber
+{
+  const char *name;
+  uint32_t topicMask;
+  QueueHandle_t queue;
+  std::atomic<uint32_t> pendingUiEvents; // UI_INPUT_MASK bits not yet received
+  TelemetrySubscriberStats stats;
+};
+
+static TelemetrySubscriber subscribers[TELEMETRY_MAX_SUBSCRIBERS];
+// Slots below this count are fully set up; publishers read it without a lock
+static std::atomic<int> subscriberCount{0};
+static portMUX_TYPE subscribeMux = portMUX_INITIALIZER_UNLOCKED;
+static portMUX_TYPE telemetryStatsMux = portMUX_INITIALIZER_UNLOCKED;
+
+int telemetrySubscribe(const char *name, uint32_t topicMask, int queueDepth)
+{
+  QueueHandle_t queue = xQueueCreate(queueDepth, sizeof(TelemetryMessage));
+  if (queue == nullptr)
+  {
+    ESP_LOGE("Telemetry", "Failed to create the queue of subscriber %s.", name);
+    return -1;
+  }
+
+  int subscriber = -1;
+  portENTER_CRITICAL(&subscribeMux);
+  int count = subscriberCount.load(std::memory_order_relaxed);
+  if (count < TELEMETRY_MAX_SUBSCRIBERS)
+  {
+    TelemetrySubscriber &slot = subscribers[count];
+    slot.name = name;
+    slot.topicMask = topicMask;
+    slot.queue = queue;
+    slot.pendingUiEvents.store(0, std::memory_order_relaxed);
+    slot.stats = {};
+    subscriberCount.store(count + 1, std::memory_order_release);
+    subscriber = count;
+  }
+  portEXIT_CRITICAL(&subscribeMux);
+
+  if (subscriber < 0)
+  {
+    vQueueDelete(queue);
+    ESP_LOGE("Telemetry", "Too many subscribers, increase TELEMETRY_MAX_SUBSCRIBERS.");
+    return -1;
+  }
+  ESP_LOGI("Telemetry", "Subscriber %s: topics 0x%lx, queue depth %d", name, (unsigned long)topicMask, queueDepth);
+  return subscriber;
+}
+
+static void publish(TelemetryMessage &message)
+{
+  message.publishUs = micros();
+  int count = subscriberCount.load(std::memory_order_acquire);
+  for (int i = 0; i < count; ++i)
+  {
+    TelemetrySubscriber &subscriber = subscribers[i];
+    if ((subscriber.topicMask & TOPIC_MASK(message.topic)) == 0)
+    {
+      continue;
+    }
+    if (xQueueSend(subscriber.queue, &message, 0) == pdTRUE)
+    {
+      continue;
+    }
+    // Full: make room by dropping the oldest message, the newest state matters most. Another publisher can take
+    // the freed slot first, so try twice and count the new message as dropped if it still does not fit.
+    uint32_t dropped = 0;
+    bool sent = false;
+    for (int attempt = 0; attempt < 2 && !sent; ++attempt)
+    {
+      TelemetryMessage oldest;
+      if (xQueueReceive(subscriber.queue, &oldest, 0) == pdTRUE)
+      {
+        dropped++;
+      }
+      sent = xQueueSend(subscriber.queue, &message, 0) == pdTRUE;
+    }
+    portENTER_CRITICAL(&telemetryStatsMux);
+    subscriber.stats.dropped += dropped + (sent ? 0 : 1);
+    portEXIT_CRITICAL(&telemetryStatsMux);
+  }
+}
+
+void telemetryPublish(const GpsSnapshot &fix)
+{
+  TelemetryMessage message;
+  message.topic = TOPIC_GPS_FIX;
+  message.gps = fix;
+  publish(message);
+}
+
+void telemetryPublish(const SensorSnapshot &sample)
+{
+  TelemetryMessage message;
+  message.topic = TOPIC_BARO;
+  message.baro = sample;
+  publish(message);
+}
+
+void telemetryPublish(const VarioSnapshot &vario)
+{
+  TelemetryMessage message;
+  message.topic = TOPIC_VARIO;
+  message.vario = vario;
+  publish(message);
+}
+
+void telemetryPublish(UiInputEvent event)
+{
+  TelemetryMessage wakeUp;
+  wakeUp.topic = TOPIC_UI_INPUT;
+  wakeUp.publishUs = micros();
+  wakeUp.ui.events = 0; // The events travel in the bitmask
+  int count = subscriberCount.load(std::memory_order_acquire);
+  for (int i = 0; i < count; ++i)
+  {
+    TelemetrySubscriber &subscriber = subscribers[i];
+    if ((subscriber.topicMask & TOPIC_MASK(TOPIC_UI_INPUT)) == 0)
+    {
+      continue;
+    }
+    // Only the first pending event needs a wake-up. If the queue is full the subscriber is not blocked and
+    // collects the bits with its next receive anyway.
+    if (subscriber.pendingUiEvents.fetch_or(UI_INPUT_MASK(event), std::memory_order_acq_rel) == 0)
+    {
+      xQueueSend(subscriber.queue, &wakeUp, 0);
+    }
+  }
+}
+
+bool telemetryReceive(int subscriber, TelemetryMessage *message, TickType_t timeout)
+{
+  if (subscriber < 0)
+  {
+    return false;
+  }
+  TelemetrySubscriber &source = subscribers[subscriber];
+  for (;;)
+  {
+    // Pending UI input first: it is rare and the user is waiting for it
+    uint32_t uiEvents = source.pendingUiEvents.exchange(0, std::memory_order_acq_rel);
+    if (uiEvents != 0)
+    {
+      message->topic = TOPIC_UI_INPUT;
+      message->publishUs = micros();
+      message->ui.events = uiEvents;
+      break;
+    }
+    if (xQueueReceive(source.queue, message, timeout) != pdTRUE)
+    {
+      return false;
+    }
+    if (message->topic != TOPIC_UI_INPUT)
+    {
+      break;
+    }
+    // A wake-up whose events an earlier receive already collected; wait for the next message
+  }
+
+  uint32_t latencyUs = micros() - message->publishUs;
+  portENTER_CRITICAL(&telemetryStatsMux);
+  TelemetrySubscriberStats &stats = source.stats;
+  stats.received++;
+  stats.maxLatencyUs = std::max(stats.maxLatencyUs, latencyUs);
+  portEXIT_CRITICAL(&telemetryStatsMux);
+  return true;
+}
+
+void telemetryGetStats(int subscriber, TelemetrySubscriberStats *stats)
+{
+  if (subscriber < 0)
+  {
+    *stats = {};
+    return;
+  }
+  portENTER_CRITICAL(&telemetryStatsMux);
+  *stats = subscribers[subscriber].stats;
+  portEXIT_CRITICAL(&telemetryStatsMux);
+}
@@ -0,0 +1,74 @@
+#ifndef TELEMETRY_BUS_H
+#define TELEMETRY_BUS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <stdint.h>
+#include "telemetry.h"
+
+// Publish/subscribe bus for telemetry and UI input. Every subscriber owns a bounded queue and picks the topics it
+// wants; a publisher copies the message into each matching queue without waiting. When a queue is full its oldest
+// message is dropped, so a slow consumer only loses its own backlog and never stalls a producer.
+// UI input is not queued: every subscriber collects the events in a bitmask that only a receive clears, so a
+// burst of telemetry can delay a button press or a pan but never drop it. A queued message wakes the subscriber.
+// The latest value of every telemetry topic is still kept in its snapshot (telemetry.h) for readers that only poll.
+
+enum TelemetryTopic
+{
+  TOPIC_GPS_FIX = 0, // GpsSnapshot, new fix or fix lost
+  TOPIC_BARO,        // SensorSnapshot, new barometer sample
+  TOPIC_VARIO,       // VarioSnapshot, new variometer output
+  TOPIC_UI_INPUT,    // UiInput, touch gestures and buttons
+  TOPIC_COUNT
+};
+
+#define TOPIC_MASK(topic) (1UL << (topic))
+
+enum UiInputEvent
+{
+  UI_INPUT_MAP_MOVED = 0,    // Pan or zoom level change, the map center is in gpsState
+  UI_INPUT_MAP_ZOOM_PREVIEW, // Pinch in progress, globalPinchScale changed
+  UI_INPUT_SOUND_BUTTON,
+  UI_INPUT_HIKE_BUTTON,
+  UI_INPUT_BIKE_BUTTON
+};
+
+#define UI_INPUT_MASK(event) (1UL << (event))
+
+struct UiInput
+{
+  uint32_t events; // UI_INPUT_MASK bits of all events since the last receive
+};
+
+struct TelemetryMessage
+{
+  TelemetryTopic topic;
+  uint32_t publishUs; // micros() when the message was published
+  union
+  {
+    GpsSnapshot gps;
+    SensorSnapshot baro;
+    VarioSnapshot vario;
+    UiInput ui;
+  };
+};
+
+struct TelemetrySubscriberStats
+{
+  uint32_t received;     // Messages taken from the queue
+  uint32_t dropped;      // Messages discarded because the queue was full
+  uint32_t maxLatencyUs; // Longest time between publishing and receiving a message
+};
+
+// Register a consumer for the topics in topicMask (TOPIC_MASK bits). Returns the subscriber id, -1 if
+// TELEMETRY_MAX_SUBSCRIBERS is reached. Subscribers stay registered for the lifetime of the program.
+int telemetrySubscribe(const char *name, uint32_t topicMask, int queueDepth);
+// Take the next message of a subscriber; false if none arrived within timeout.
+bool telemetryReceive(int subscriber, TelemetryMessage *message, TickType_t timeout);
+void telemetryPublish(const GpsSnapshot &fix);
+void telemetryPublish(const SensorSnapshot &sample);
+void telemetryPublish(const VarioSnapshot &vario);
+void telemetryPublish(UiInputEvent event);
+void telemetryGetStats(int subscriber, TelemetrySubscriberStats *stats);
+
+#endif // TELEMETRY_BUS_H
@@ -0,0 +1,126 @@
+#include "tile_archive.h"
+#include "FS.h"     // SD Card ESP32
+#include "SD_MMC.h" // SD Card ESP32
+#include <esp_heap_caps.h> // For heap_caps_malloc
+#include <freertos/semphr.h>
+#include <algorithm> // For std::lower_bound
+
+struct TileArchive
+{
+  File file;
+  TileArchiveEntry *index; // Sorted index, held in PSRAM
+  size_t entryCount;
+  TileArchiveFormat format;
+  SemaphoreHandle_t mutex; // Serializes seek + read on the shared file handle
+};
+
+TileArchive *openTileArchive(const char *filePath)
+{
+  File file = SD_MMC.open(filePath);
+  if (!file)
+  {
+    ESP_LOGD("TileArchive", "No archive at %s", filePath);
+    return nullptr;
+  }
+
+  TileArchiveHeader header;
+  if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, TILE_ARCHIVE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != TILE_ARCHIVE_VERSION ||
+      header.entrySize != sizeof(TileArchiveEntry))
+  {
+    ESP_LOGE("TileArchive", "Invalid archive header: %s", filePath);
+    file.close();
+    return nullptr;
+  }
+
+  size_t indexBytes = (size_t)header.entryCount * sizeof(TileArchiveEntry);
+  TileArchiveEntry *index = (TileArchiveEntry *)heap_caps_malloc(indexBytes, MALLOC_CAP_SPIRAM);
+  if (index == nullptr)
+  {
+    ESP_LOGE("TileArchive", "Failed to allocate %u bytes for the index of %s", (unsigned)indexBytes, filePath);
+    file.close();
+    return nullptr;
+  }
+  if (!file.seek(header.indexOffset) || file.read((uint8_t *)index, indexBytes) != indexBytes)
+  {
+    ESP_LOGE("TileArchive", "Failed to read the index of %s", filePath);
+    heap_caps_free(index);
+    file.close();
+    return nullptr;
+  }
+
+  TileArchive *archive = new TileArchive();
+  archive->file = file;
+  archive->index = index;
+  archive->entryCount = header.entryCount;
+  archive->format = (TileArchiveFormat)header.format;
+  archive->mutex = xSemaphoreCreateMutex();
+  ESP_LOGI("TileArchive", "Opened %s: %u tiles, index %u bytes", filePath, (unsigned)archive->entryCount, (unsigned)indexBytes);
+  return archive;
+}
+
+TileArchiveFormat tileArchiveFormat(const TileArchive *archive)
+{
+  return archive->format;
+}
+
+size_t tileArchiveEntryCount(const TileArchive *archive)
+{
+  return archive->entryCount;
+}
+
+const TileArchiveEntry *tileArchiveEntries(const TileArchive *archive)
+{
+  return archive->index;
+}
+
+static const TileArchiveEntry *findEntry(const TileArchive *archive, int z, int x, int y)
+{
+  uint64_t key = tileArchiveKey(z, x, y);
+  const TileArchiveEntry *begin = archive->index;
+  const TileArchiveEntry *end = begin + archive->entryCount;
+  const TileArchiveEntry *entry = std::lower_bound(begin, end, key,
+                                                   [](const TileArchiveEntry &e, uint64_t k) { return e.key < k; });
+  if (entry == end || entry->key != key)
+  {
+    return nullptr;
+  }
+  return entry;
+}
+
+size_t tileArchiveFind(const TileArchive *archive, int z, int x, int y)
+{
+  const TileArchiveEntry *entry = findEntry(archive, z, x, y);
+  return entry != nullptr ? entry->length : 0;
+}
+
+size_t tileArchiveRead(TileArchive *archive, int z, int x, int y, uint8_t *buffer, size_t bufferSize)
+{
+  const TileArchiveEntry *entry = findEntry(archive, z, x, y);
+  if (entry == nullptr)
+  {
+    return 0;
+  }
+  if (entry->length > bufferSize)
+  {
+    ESP_LOGE("TileArchive", "Tile %d/%d/%d is %u bytes, buffer holds %u", z, x, y, (unsigned)entry->length, (unsigned)bufferSize);
+    return 0;
+  }
+
+  size_t bytesRead = 0;
+  if (xSemaphoreTake(archive->mutex, portMAX_DELAY) == pdTRUE)
+  {
+    if (archive->file.seek(entry->offset))
+    {
+      bytesRead = archive->file.read(buffer, entry->length);
+    }
+    xSemaphoreGive(archive->mutex);
+  }
+  if (bytesRead != entry->length)
+  {
+    ESP_LOGE("TileArchive", "Short read of tile %d/%d/%d: %u of %u bytes", z, x, y, (unsigned)bytesRead, (unsigned)entry->length);
+    return 0;
+  }
+  return bytesRead;
+}
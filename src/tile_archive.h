@@ -0,0 +1,64 @@
+#ifndef TILE_ARCHIVE_H
+#define TILE_ARCHIVE_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Packed tile archive (*.fhta), written by tools/pack_tiles.py.
+// All integers are little endian.
+//
+//   TileArchiveHeader                          32 bytes
+//   TileArchiveEntry[entryCount]               sorted by key, i.e. by (z, x, y)
+//   tile blobs                                 contiguous, in index order
+//
+// A tile is read with one seek and one read once the index has been loaded into PSRAM.
+
+const char TILE_ARCHIVE_MAGIC[4] = {'F', 'H', 'T', 'A'};
+const uint16_t TILE_ARCHIVE_VERSION = 1;
+
+enum TileArchiveFormat : uint8_t
+{
+  TILE_ARCHIVE_FORMAT_JPEG = 0,
+  TILE_ARCHIVE_FORMAT_PNG = 1,
+};
+
+struct __attribute__((packed)) TileArchiveHeader
+{
+  char magic[4];        // "FHTA"
+  uint16_t version;     // TILE_ARCHIVE_VERSION
+  uint16_t entrySize;   // sizeof(TileArchiveEntry)
+  uint32_t entryCount;  // Number of tiles
+  uint32_t indexOffset; // File offset of the first TileArchiveEntry
+  uint32_t dataOffset;  // File offset of the first blob
+  uint8_t format;       // TileArchiveFormat of all blobs
+  uint8_t reserved[11];
+};
+
+struct __attribute__((packed)) TileArchiveEntry
+{
+  uint64_t key;    // tileArchiveKey(z, x, y)
+  uint32_t offset; // Absolute file offset of the blob
+  uint32_t length; // Blob length in bytes
+};
+
+// Sort key of a tile: zoom in the top bits, then x, then y (x and y below 2^24, i.e. zoom <= 24)
+inline uint64_t tileArchiveKey(int z, int x, int y)
+{
+  return ((uint64_t)z << 48) | ((uint64_t)(uint32_t)x << 24) | (uint64_t)(uint32_t)y;
+}
+
+struct TileArchive;
+
+// Open an archive and load its index into PSRAM. Returns nullptr if the file is missing or invalid.
+TileArchive *openTileArchive(const char *filePath);
+TileArchiveFormat tileArchiveFormat(const TileArchive *archive);
+size_t tileArchiveEntryCount(const TileArchive *archive);
+// The sorted in-memory index, tileArchiveEntryCount() entries
+const TileArchiveEntry *tileArchiveEntries(const TileArchive *archive);
+// Look up a tile in the in-memory index; returns its blob length or 0 if the archive does not contain it.
+size_t tileArchiveFind(const TileArchive *archive, int z, int x, int y);
+// Read a tile blob into buffer. Returns the blob length, or 0 if it is missing or larger than bufferSize.
+size_t tileArchiveRead(TileArchive *archive, int z, int x, int y, uint8_t *buffer, size_t bufferSize);
+
+#endif // TILE_ARCHIVE_H
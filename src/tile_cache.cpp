@@ -0,0 +1,195 @@
+#include "tile_cache.h"
+#include <esp_heap_caps.h> // For heap_caps_malloc
+#include <freertos/semphr.h>
+#include <list>
+#include <map>
+#include <vector>
+
+// One cached tile: the slot index in slotMemory and its position in the LRU list
+struct TileCacheEntry
+{
+  size_t slot;
+  std::list<TileKey>::iterator lruPosition;
+  bool prefetched; // Stored by the prefetch task and not drawn yet
+};
+
+static uint8_t *slotMemory = nullptr;                 // PSRAM block holding all decoded tiles
+static size_t slotCount = 0;                          // Number of tiles fitting into the budget
+static std::map<TileKey, TileCacheEntry> cacheIndex; // Key -> slot lookup
+static std::list<TileKey> lruList;                    // Front = most recently used
+static std::vector<size_t> freeSlots;
+static TileCacheStats cacheStats = {};
+static SemaphoreHandle_t xTileCacheMutex = NULL;
+
+bool initTileCache(size_t budgetBytes)
+{
+  slotCount = budgetBytes / TILE_CACHE_TILE_BYTES;
+  if (slotCount == 0)
+  {
+    ESP_LOGE("TileCache", "Budget of %u bytes is smaller than one tile.", (unsigned)budgetBytes);
+    return false;
+  }
+
+  slotMemory = (uint8_t *)heap_caps_malloc(slotCount * TILE_CACHE_TILE_BYTES, MALLOC_CAP_SPIRAM);
+  if (slotMemory == nullptr)
+  {
+    ESP_LOGE("TileCache", "Failed to allocate %u bytes in PSRAM.", (unsigned)(slotCount * TILE_CACHE_TILE_BYTES));
+    slotCount = 0;
+    return false;
+  }
+
+  xTileCacheMutex = xSemaphoreCreateMutex();
+  freeSlots.reserve(slotCount);
+  tileCacheClear();
+  cacheStats.capacity = slotCount;
+  ESP_LOGI("TileCache", "Tile cache initialized: %u tiles, %u bytes in PSRAM.",
+           (unsigned)slotCount, (unsigned)(slotCount * TILE_CACHE_TILE_BYTES));
+  return true;
+}
+
+bool tileCacheGet(const TileKey &key, void *dst, bool countStats)
+{
+  if (xTileCacheMutex == NULL || xSemaphoreTake(xTileCacheMutex, portMAX_DELAY) != pdTRUE)
+  {
+    return false;
+  }
+
+  auto it = cacheIndex.find(key);
+  if (it == cacheIndex.end())
+  {
+    if (countStats)
+    {
+      cacheStats.misses++;
+    }
+    xSemaphoreGive(xTileCacheMutex);
+    return false;
+  }
+
+  // Move the tile to the front of the LRU list
+  lruList.splice(lruList.begin(), lruList, it->second.lruPosition);
+  memcpy(dst, slotMemory + it->second.slot * TILE_CACHE_TILE_BYTES, TILE_CACHE_TILE_BYTES);
+  if (countStats)
+  {
+    cacheStats.hits++;
+  }
+  if (it->second.prefetched)
+  {
+    cacheStats.prefetchHits++;
+    it->second.prefetched = false;
+  }
+  xSemaphoreGive(xTileCacheMutex);
+  return true;
+}
+
+bool tileCacheGetUpscaled(const TileKey &key, int levels, int quadrantX, int quadrantY, void *dst)
+{
+  if (xTileCacheMutex == NULL || xSemaphoreTake(xTileCacheMutex, portMAX_DELAY) != pdTRUE)
+  {
+    return false;
+  }
+
+  auto it = cacheIndex.find(key);
+  if (it == cacheIndex.end())
+  {
+    xSemaphoreGive(xTileCacheMutex);
+    return false;
+  }
+
+  lruList.splice(lruList.begin(), lruList, it->second.lruPosition);
+  int squareSize = TILE_SIZE >> levels;
+  const uint16_t *src = (const uint16_t *)(slotMemory + it->second.slot * TILE_CACHE_TILE_BYTES) +
+                        quadrantY * squareSize * TILE_SIZE + quadrantX * squareSize;
+  uint16_t *out = (uint16_t *)dst;
+  for (int y = 0; y < TILE_SIZE; ++y)
+  {
+    const uint16_t *srcRow = src + (y >> levels) * TILE_SIZE;
+    for (int x = 0; x < TILE_SIZE; ++x)
+    {
+      *out++ = srcRow[x >> levels];
+    }
+  }
+  xSemaphoreGive(xTileCacheMutex);
+  return true;
+}
+
+bool tileCacheContains(const TileKey &key)
+{
+  if (xTileCacheMutex == NULL || xSemaphoreTake(xTileCacheMutex, portMAX_DELAY) != pdTRUE)
+  {
+    return false;
+  }
+  bool found = cacheIndex.find(key) != cacheIndex.end();
+  xSemaphoreGive(xTileCacheMutex);
+  return found;
+}
+
+void tileCachePut(const TileKey &key, const void *src, bool prefetched)
+{
+  if (xTileCacheMutex == NULL || xSemaphoreTake(xTileCacheMutex, portMAX_DELAY) != pdTRUE)
+  {
+    return; // Cache not initialized
+  }
+
+  size_t slot;
+  auto it = cacheIndex.find(key);
+  if (it != cacheIndex.end())
+  {
+    // Refresh an existing entry
+    slot = it->second.slot;
+    it->second.prefetched = it->second.prefetched && prefetched;
+    lruList.splice(lruList.begin(), lruList, it->second.lruPosition);
+  }
+  else
+  {
+    if (freeSlots.empty())
+    {
+      // Evict the least recently used tile and reuse its slot
+      const TileKey &victim = lruList.back();
+      auto victimIt = cacheIndex.find(victim);
+      if (victimIt->second.prefetched)
+      {
+        cacheStats.prefetchWasted++;
+      }
+      freeSlots.push_back(victimIt->second.slot);
+      cacheIndex.erase(victimIt);
+      lruList.pop_back();
+      cacheStats.evictions++;
+    }
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+    lruList.push_front(key);
+    cacheIndex[key] = TileCacheEntry{slot, lruList.begin(), prefetched};
+  }
+
+  memcpy(slotMemory + slot * TILE_CACHE_TILE_BYTES, src, TILE_CACHE_TILE_BYTES);
+  cacheStats.entries = cacheIndex.size();
+  xSemaphoreGive(xTileCacheMutex);
+}
+
+void tileCacheClear()
+{
+  if (xTileCacheMutex == NULL || xSemaphoreTake(xTileCacheMutex, portMAX_DELAY) != pdTRUE)
+  {
+    return;
+  }
+  cacheIndex.clear();
+  lruList.clear();
+  freeSlots.clear();
+  for (size_t i = 0; i < slotCount; ++i)
+  {
+    freeSlots.push_back(slotCount - 1 - i); // Hand out slot 0 first
+  }
+  cacheStats.entries = 0;
+  xSemaphoreGive(xTileCacheMutex);
+}
+
+void tileCacheGetStats(TileCacheStats *stats)
+{
+  if (xTileCacheMutex == NULL || xSemaphoreTake(xTileCacheMutex, portMAX_DELAY) != pdTRUE)
+  {
+    *stats = cacheStats;
+    return;
+  }
+  *stats = cacheStats;
+  xSemaphoreGive(xTileCacheMutex);
+}
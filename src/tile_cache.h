@@ -0,0 +1,63 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <Arduino.h>
+#include <stddef.h> // For size_t
+#include <stdint.h>
+#include <M5Unified.h>
+#include "config.h" // For TILE_CACHE_TILE_BYTES
+
+// Overlay bits of a composited tile
+const uint8_t TILE_OVERLAY_HIKE = 1 << 0;
+const uint8_t TILE_OVERLAY_BIKE = 1 << 1;
+
+// Key of a decoded tile in the cache. The same tile is cached once per overlay combination.
+struct TileKey
+{
+  int z;
+  int x;
+  int y;
+  uint8_t overlays; // TILE_OVERLAY_* bits composited onto the base map, 0 = base map only
+
+  bool operator<(const TileKey &other) const
+  {
+    if (z != other.z) return z < other.z;
+    if (x != other.x) return x < other.x;
+    if (y != other.y) return y < other.y;
+    return overlays < other.overlays;
+  }
+};
+
+// Counters reported by the tile cache
+struct TileCacheStats
+{
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint32_t entries;  // Tiles currently held
+  uint32_t capacity; // Tiles that fit into the byte budget
+  uint32_t prefetchHits;   // Prefetched tiles that were later drawn
+  uint32_t prefetchWasted; // Prefetched tiles evicted without ever being drawn
+};
+
+// All functions are thread-safe; the GUI and the prefetch task share the cache.
+
+// Allocate the cache slots in PSRAM. The number of slots is budgetBytes / TILE_CACHE_TILE_BYTES.
+bool initTileCache(size_t budgetBytes);
+// Copy a cached tile into dst (TILE_CACHE_TILE_BYTES). Returns false on a miss.
+// Internal lookups that follow a counted miss pass countStats = false so one request counts once, as that miss.
+// A prefetched tile found by them still counts as a prefetch hit, it was drawn.
+bool tileCacheGet(const TileKey &key, void *dst, bool countStats = true);
+// Store a decoded tile, evicting the least recently used one if the cache is full.
+// Tiles stored by the prefetcher are flagged so their hits and waste can be counted.
+void tileCachePut(const TileKey &key, const void *src, bool prefetched = false);
+// Upscale one (1 << levels)-th square of a cached tile to full tile size into dst (nearest neighbour).
+// quadrantX/Y select the square, 0 .. (1 << levels) - 1. Returns false if the tile is not cached.
+bool tileCacheGetUpscaled(const TileKey &key, int levels, int quadrantX, int quadrantY, void *dst);
+// Check for a tile without copying it, touching the LRU order or counting a hit/miss
+bool tileCacheContains(const TileKey &key);
+// Drop every cached tile (counters are kept)
+void tileCacheClear();
+void tileCacheGetStats(TileCacheStats *stats);
+
+#endif // TILE_CACHE_H
@@ -3,38 +3,87 @@
 #include <M5Unified.h> // For M5.Display.width() and M5.Display.height()
 #include "config.h" // Include configuration constants
 
-void initTileCalculator() {
-    // No specific initialization needed for now, but can be extended later.
+// Per-zoom scale of the projection, filled once by initTileCalculator()
+struct ZoomScale {
+    double worldPixels;         // TILE_SIZE * 2^zoom
+    double pixelsPerDegree;     // Longitude
+    double pixelsPerMercator;   // Per unit of atanh(sin(lat)), the Mercator y in radians
+};
+static ZoomScale zoomScales[MAX_ZOOM_LEVEL + 1];
+static bool zoomScalesReady = false;
+
+static ZoomScale computeZoomScale(int zoom) {
+    ZoomScale scale;
+    scale.worldPixels = ldexp((double)TILE_SIZE, zoom);
+    scale.pixelsPerDegree = scale.worldPixels / 360.0;
+    scale.pixelsPerMercator = scale.worldPixels / (2.0 * M_PI);
+    return scale;
 }
 
-// Function to convert latitude and longitude to Web Mercator tile X and Y coordinates
-void latLngToTile(double lat, double lng, int zoom, int* tileX, int* tileY) {
-    double lat_rad = lat * M_PI / 180.0;
-    double n = pow(2.0, zoom);
+static ZoomScale getZoomScale(int zoom) {
+    if (zoomScalesReady && zoom >= 0 && zoom <= MAX_ZOOM_LEVEL) {
+        return zoomScales[zoom];
+    }
+    return computeZoomScale(zoom);
+}
 
-    *tileX = (int)floor((lng + 180.0) / 360.0 * n);
-    *tileY = (int)floor((1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * n);
+void initTileCalculator() {
+    for (int zoom = 0; zoom <= MAX_ZOOM_LEVEL; ++zoom) {
+        zoomScales[zoom] = computeZoomScale(zoom);
+    }
+    zoomScalesReady = true;
 }
 
-// Function to calculate pixel offset within a tile
-extern const int TILE_SIZE; // Assuming TILE_SIZE is globally available
+// log(tan(lat) + 1 / cos(lat)) equals atanh(sin(lat)) = 0.5 * log((1 + s) / (1 - s)): one sin() and one log()
+// instead of tan(), cos() and log()
+static inline void projectWithScale(double lat, double lng, const ZoomScale& scale, TileProjection* projection) {
+    double s = sin(lat * M_PI / 180.0);
+    double x = (lng + 180.0) * scale.pixelsPerDegree;
+    double y = scale.worldPixels * 0.5 - 0.5 * log((1.0 + s) / (1.0 - s)) * scale.pixelsPerMercator;
 
-void latLngToPixelOffset(double lat, double lng, int zoom, int* pixelX, int* pixelY) {
-    double lat_rad = lat * M_PI / 180.0;
-    double n = pow(2.0, zoom);
+    long pixelX = (long)floor(x);
+    long pixelY = (long)floor(y);
+    // Floor division, also right for points beyond the edge of the map
+    int tileX = (int)(pixelX >= 0 ? pixelX / TILE_SIZE : (pixelX - TILE_SIZE + 1) / TILE_SIZE);
+    int tileY = (int)(pixelY >= 0 ? pixelY / TILE_SIZE : (pixelY - TILE_SIZE + 1) / TILE_SIZE);
 
-    double tileX_double = (lng + 180.0) / 360.0 * n;
-    double tileY_double = (1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * n;
+    projection->globalPixelX = pixelX;
+    projection->globalPixelY = pixelY;
+    projection->tileX = tileX;
+    projection->tileY = tileY;
+    projection->pixelOffsetX = (int)(pixelX - (long)tileX * TILE_SIZE);
+    projection->pixelOffsetY = (int)(pixelY - (long)tileY * TILE_SIZE);
+}
 
-    int tileX_int = (int)floor(tileX_double);
-    int tileY_int = (int)floor(tileY_double);
+void projectLatLng(double lat, double lng, int zoom, TileProjection* projection) {
+    projectWithScale(lat, lng, getZoomScale(zoom), projection);
+}
 
-    *pixelX = (int)((tileX_double - tileX_int) * TILE_SIZE);
-    *pixelY = (int)((tileY_double - tileY_int) * TILE_SIZE);
+void projectLatLngBatch(const double* lat, const double* lng, int count, int zoom, TileProjection* projections) {
+    const ZoomScale scale = getZoomScale(zoom);
+    for (int i = 0; i < count; ++i) {
+        projectWithScale(lat[i], lng[i], scale, &projections[i]);
+    }
+}
+
+// Function to convert latitude and longitude to Web Mercator tile X and Y coordinates
+void latLngToTile(double lat, double lng, int zoom, int* tileX, int* tileY) {
+    TileProjection projection;
+    projectLatLng(lat, lng, zoom, &projection);
+    *tileX = projection.tileX;
+    *tileY = projection.tileY;
+}
+
+// Function to calculate pixel offset within a tile
+void latLngToPixelOffset(double lat, double lng, int zoom, int* pixelX, int* pixelY) {
+    TileProjection projection;
+    projectLatLng(lat, lng, zoom, &projection);
+    *pixelX = projection.pixelOffsetX;
+    *pixelY = projection.pixelOffsetY;
 }
 
 void pixelToLatLng(int pixelX, int pixelY, int zoom, double* lat, double* lng) {
-    double n = pow(2.0, zoom);
+    double n = getZoomScale(zoom).worldPixels / TILE_SIZE;
     double lng_deg = (pixelX / (double)TILE_SIZE / n * 360.0) - 180.0;
     double lat_rad = atan(sinh(M_PI * (1 - 2 * pixelY / (double)TILE_SIZE / n)));
     double lat_deg = lat_rad * 180.0 / M_PI;
@@ -44,9 +93,8 @@ void pixelToLatLng(int pixelX, int pixelY, int zoom, double* lat, double* lng) {
 
 // Function to convert latitude and longitude to global pixel coordinates
 void latLngToGlobalPixel(double lat, double lng, int zoom, long* pixelX, long* pixelY) {
-    double lat_rad = lat * M_PI / 180.0;
-    double n = pow(2.0, zoom);
-
-    *pixelX = (long)floor(((lng + 180.0) / 360.0 * n) * TILE_SIZE);
-    *pixelY = (long)floor(((1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * n) * TILE_SIZE);
+    TileProjection projection;
+    projectLatLng(lat, lng, zoom, &projection);
+    *pixelX = projection.globalPixelX;
+    *pixelY = projection.globalPixelY;
 }
@@ -12,9 +12,23 @@ extern int globalTileX;
 extern int globalTileY;
 extern int globalTileZ;
 
+// Web Mercator position of one point at one zoom level
+struct TileProjection {
+    long globalPixelX;  // Pixel in the whole zoom level
+    long globalPixelY;
+    int tileX;          // Tile containing the point
+    int tileY;
+    int pixelOffsetX;   // Pixel inside that tile
+    int pixelOffsetY;
+};
+
 // Function declarations
 void initTileCalculator();
 int calculateZoomLevel(double speed_kmph, int display_width, int display_height);
+// Tile, offset and global pixel in one pass: one sin() and one log() per point, the zoom scale comes from a table
+void projectLatLng(double lat, double lng, int zoom, struct TileProjection* projection);
+// Same for arrays of points, e.g. a track or an airspace outline
+void projectLatLngBatch(const double* lat, const double* lng, int count, int zoom, struct TileProjection* projections);
 void latLngToTile(double lat, double lng, int zoom, int* tileX, int* tileY);
 void latLngToPixelOffset(double lat, double lng, int zoom, int* pixelX, int* pixelY);
 void latLngToGlobalPixel(double lat, double lng, int zoom, long* pixelX, long* pixelY);
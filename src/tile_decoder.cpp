@@ -0,0 +1,192 @@
+#include "tile_decoder.h"
+#include <esp_heap_caps.h> // For heap_caps_malloc
+#include <freertos/semphr.h>
+#include "config.h"
+#include "baseline_jpeg.h"
+
+#if __has_include(<driver/jpeg_decode.h>)
+#include <driver/jpeg_decode.h>
+#define TILE_DECODER_HAS_HW_JPEG 1
+#else
+#define TILE_DECODER_HAS_HW_JPEG 0
+#endif
+
+static bool m5gfxInit()
+{
+  return true;
+}
+
+static bool m5gfxDecodeJpeg(M5Canvas &canvas, const uint8_t *data, size_t length)
+{
+  return canvas.drawJpg(data, length, 0, 0);
+}
+
+static bool m5gfxDecodePng(M5Canvas &canvas, const uint8_t *data, size_t length)
+{
+  return canvas.drawPng(data, length, 0, 0);
+}
+
+#if TILE_DECODER_HAS_HW_JPEG
+static jpeg_decoder_handle_t hwJpegEngine = nullptr;
+static uint8_t *hwJpegOutput = nullptr; // DMA target, shared by the GUI and prefetch tasks
+static size_t hwJpegOutputSize = 0;
+static SemaphoreHandle_t hwJpegMutex = nullptr;
+
+static bool hwJpegInit()
+{
+  jpeg_decode_engine_cfg_t engineConfig = {};
+  engineConfig.intr_priority = 0;
+  engineConfig.timeout_ms = TILE_DECODER_HW_TIMEOUT_MS;
+  if (jpeg_new_decoder_engine(&engineConfig, &hwJpegEngine) != ESP_OK)
+  {
+    ESP_LOGE("TileDecoder", "Failed to create the JPEG decoder engine.");
+    return false;
+  }
+
+  jpeg_decode_memory_alloc_cfg_t memoryConfig = {};
+  memoryConfig.buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER;
+  hwJpegOutput = (uint8_t *)jpeg_alloc_decoder_mem(TILE_CACHE_TILE_BYTES, &memoryConfig, &hwJpegOutputSize);
+  if (hwJpegOutput == nullptr)
+  {
+    ESP_LOGE("TileDecoder", "Failed to allocate the JPEG decoder output buffer.");
+    jpeg_del_decoder_engine(hwJpegEngine);
+    hwJpegEngine = nullptr;
+    return false;
+  }
+  hwJpegMutex = xSemaphoreCreateMutex();
+  if (hwJpegMutex == nullptr)
+  {
+    ESP_LOGE("TileDecoder", "Failed to create the JPEG decoder mutex.");
+    free(hwJpegOutput); // jpeg_alloc_decoder_mem() memory is released with free()
+    hwJpegOutput = nullptr;
+    hwJpegOutputSize = 0;
+    jpeg_del_decoder_engine(hwJpegEngine);
+    hwJpegEngine = nullptr;
+    return false;
+  }
+  return true;
+}
+
+static bool hwJpegDecode(M5Canvas &canvas, const uint8_t *data, size_t length)
+{
+  // The engine only writes whole frames, so only tiles exactly covering a 16-bit canvas qualify
+  jpeg_decode_picture_info_t info;
+  if (jpeg_decoder_get_info(data, length, &info) != ESP_OK ||
+      (int32_t)info.width != canvas.width() || (int32_t)info.height != canvas.height() ||
+      canvas.getColorDepth() != 16 || (size_t)info.width * info.height * 2 > hwJpegOutputSize)
+  {
+    return false;
+  }
+  uint16_t *pixels = (uint16_t *)canvas.getBuffer();
+  if (pixels == nullptr)
+  {
+    return false;
+  }
+
+  jpeg_decode_cfg_t decodeConfig = {};
+  decodeConfig.output_format = JPEG_DECODE_OUT_FORMAT_RGB565;
+  decodeConfig.rgb_order = JPEG_DEC_RGB_ELEMENT_ORDER_BGR; // Native RGB565 word order
+  decodeConfig.conv_std = JPEG_YUV_RGB_CONV_STD_BT601;
+
+  bool decoded = false;
+  if (xSemaphoreTake(hwJpegMutex, portMAX_DELAY) == pdTRUE)
+  {
+    uint32_t outputLength = 0;
+    if (jpeg_decoder_process(hwJpegEngine, &decodeConfig, data, length, hwJpegOutput, hwJpegOutputSize, &outputLength) == ESP_OK)
+    {
+      // Sprites hold byte-swapped RGB565 (lgfx::swap565_t)
+      const uint16_t *source = (const uint16_t *)hwJpegOutput;
+      size_t pixelCount = (size_t)info.width * info.height;
+      for (size_t i = 0; i < pixelCount; ++i)
+      {
+        pixels[i] = __builtin_bswap16(source[i]);
+      }
+      decoded = true;
+    }
+    xSemaphoreGive(hwJpegMutex);
+  }
+  return decoded;
+}
+#endif
+
+static bool swJpegInit()
+{
+  return true;
+}
+
+static bool swJpegDecode(M5Canvas &canvas, const uint8_t *data, size_t length)
+{
+  // Writes the canvas buffer directly, so only tiles exactly covering a 16-bit canvas qualify
+  BaselineJpegInfo info;
+  if (!baselineJpegInfo(data, length, &info) || info.width != canvas.width() || info.height != canvas.height() ||
+      canvas.getColorDepth() != 16)
+  {
+    return false;
+  }
+  uint16_t *pixels = (uint16_t *)canvas.getBuffer();
+  return pixels != nullptr && baselineJpegDecode(data, length, pixels, info.width, info.height);
+}
+
+static const TileDecoder tileDecoders[TILE_DECODER_COUNT] = {
+    {"M5GFX", m5gfxInit, m5gfxDecodeJpeg, m5gfxDecodePng},
+#if TILE_DECODER_HAS_HW_JPEG
+    {"HW JPEG", hwJpegInit, hwJpegDecode, nullptr},
+#else
+    {"HW JPEG", nullptr, nullptr, nullptr},
+#endif
+    {"SW JPEG", swJpegInit, swJpegDecode, nullptr},
+};
+
+static bool tileDecoderReady[TILE_DECODER_COUNT] = {};
+static const TileDecoder *activeDecoder = &tileDecoders[TILE_DECODER_M5GFX];
+
+void initTileDecoder()
+{
+  for (int backend = 0; backend < TILE_DECODER_COUNT; ++backend)
+  {
+    tileDecoderReady[backend] = tileDecoders[backend].init != nullptr && tileDecoders[backend].init();
+  }
+
+  if (tileDecoderReady[TILE_DECODER_BACKEND])
+  {
+    activeDecoder = &tileDecoders[TILE_DECODER_BACKEND];
+  }
+  else
+  {
+    ESP_LOGW("TileDecoder", "Decoder %s unavailable, using M5GFX.", tileDecoders[TILE_DECODER_BACKEND].name);
+  }
+  ESP_LOGI("TileDecoder", "Tile decoder: %s", activeDecoder->name);
+}
+
+bool decodeTileJpeg(M5Canvas &canvas, const uint8_t *data, size_t length)
+{
+  if (activeDecoder->decodeJpeg != m5gfxDecodeJpeg && activeDecoder->decodeJpeg(canvas, data, length))
+  {
+    return true;
+  }
+  return m5gfxDecodeJpeg(canvas, data, length); // Progressive JPEGs and odd sizes
+}
+
+bool decodeTilePng(M5Canvas &canvas, const uint8_t *data, size_t length)
+{
+  if (activeDecoder->decodePng != nullptr && activeDecoder->decodePng != m5gfxDecodePng && activeDecoder->decodePng(canvas, data, length))
+  {
+    return true;
+  }
+  return m5gfxDecodePng(canvas, data, length);
+}
+
+uint8_t *allocTileDecoderInputBuffer(size_t size)
+{
+#if TILE_DECODER_HAS_HW_JPEG
+  jpeg_decode_memory_alloc_cfg_t memoryConfig = {};
+  memoryConfig.buffer_direction = JPEG_DEC_ALLOC_INPUT_BUFFER;
+  size_t allocated = 0;
+  uint8_t *buffer = (uint8_t *)jpeg_alloc_decoder_mem(size, &memoryConfig, &allocated);
+  if (buffer != nullptr)
+  {
+    return buffer;
+  }
+#endif
+  return (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+}
@@ -0,0 +1,36 @@
+#ifndef TILE_DECODER_H
+#define TILE_DECODER_H
+
+#include <Arduino.h>
+#include <M5Unified.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A tile decoder backend. Each function decodes one compressed tile held in memory onto canvas at (0,0)
+// and returns false if it cannot handle the data; the caller then falls back to the M5GFX backend.
+// A backend without PNG support leaves decodePng at nullptr.
+struct TileDecoder
+{
+  const char *name;
+  bool (*init)();
+  bool (*decodeJpeg)(M5Canvas &canvas, const uint8_t *data, size_t length);
+  bool (*decodePng)(M5Canvas &canvas, const uint8_t *data, size_t length);
+};
+
+enum TileDecoderBackend
+{
+  TILE_DECODER_M5GFX = 0, // Software decoders of M5GFX (TJpgDec, pngle), always available
+  TILE_DECODER_HW_JPEG,   // ESP32-P4 JPEG codec, baseline JPEG only, decodes into a DMA buffer copied to the canvas
+  TILE_DECODER_SW_JPEG,   // baseline_jpeg.cpp, baseline JPEG only, RGB565 straight into the canvas buffer
+  TILE_DECODER_COUNT
+};
+
+// Initialize the backends and select the configured one (TILE_DECODER_BACKEND), falling back to M5GFX.
+void initTileDecoder();
+// Decode with the selected backend; formats it does not support, or data it rejects, go to M5GFX.
+bool decodeTileJpeg(M5Canvas &canvas, const uint8_t *data, size_t length);
+bool decodeTilePng(M5Canvas &canvas, const uint8_t *data, size_t length);
+// Compressed tile buffers must satisfy the DMA alignment of the hardware decoder
+uint8_t *allocTileDecoderInputBuffer(size_t size);
+
+#endif // TILE_DECODER_H
@@ -0,0 +1,185 @@
+#include "tile_exists.h"
+#include "FS.h"     // SD Card ESP32
+#include "SD_MMC.h" // SD Card ESP32
+#include <esp_heap_caps.h> // For heap_caps_malloc
+#include <algorithm>       // For std::min, std::max
+#include <M5Unified.h>
+#include "config.h"
+
+struct TileZoomBitmap
+{
+  uint32_t minX;
+  uint32_t minY;
+  uint32_t width;
+  uint32_t height;
+  uint8_t *bits;  // nullptr = no tiles at this zoom, unless unknown is set
+  bool unknown;   // The zoom has tiles but its bitmap could not be loaded
+};
+
+struct TileExistenceIndex
+{
+  TileZoomBitmap zooms[TILE_EXISTENCE_MAX_ZOOM + 1];
+};
+
+static size_t bitmapBytes(uint32_t width, uint32_t height)
+{
+  return ((size_t)width * height + 7) / 8;
+}
+
+// Allocate a zeroed bitmap in PSRAM, refusing zooms that would exceed TILE_EXISTENCE_MAX_BITMAP_BYTES
+static uint8_t *allocBitmap(int z, uint32_t width, uint32_t height)
+{
+  size_t bytes = bitmapBytes(width, height);
+  if (bytes > TILE_EXISTENCE_MAX_BITMAP_BYTES)
+  {
+    ESP_LOGW("TileExists", "Zoom %d bitmap would need %u bytes, skipping it.", z, (unsigned)bytes);
+    return nullptr;
+  }
+  uint8_t *bits = (uint8_t *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+  if (bits != nullptr)
+  {
+    memset(bits, 0, bytes);
+  }
+  return bits;
+}
+
+TileExistenceIndex *buildTileExistenceIndex(const TileArchive *archive)
+{
+  TileExistenceIndex *index = new TileExistenceIndex();
+  const TileArchiveEntry *entries = tileArchiveEntries(archive);
+  size_t entryCount = tileArchiveEntryCount(archive);
+
+  // First pass: bounding box per zoom
+  uint32_t maxX[TILE_EXISTENCE_MAX_ZOOM + 1] = {};
+  uint32_t maxY[TILE_EXISTENCE_MAX_ZOOM + 1] = {};
+  bool seen[TILE_EXISTENCE_MAX_ZOOM + 1] = {};
+  for (size_t i = 0; i < entryCount; ++i)
+  {
+    uint64_t key = entries[i].key;
+    int z = (int)(key >> 48);
+    uint32_t x = (key >> 24) & 0xFFFFFF;
+    uint32_t y = key & 0xFFFFFF;
+    if (z > TILE_EXISTENCE_MAX_ZOOM) continue;
+    TileZoomBitmap &zoom = index->zooms[z];
+    if (!seen[z])
+    {
+      zoom.minX = maxX[z] = x;
+      zoom.minY = maxY[z] = y;
+      seen[z] = true;
+    }
+    zoom.minX = std::min(zoom.minX, x);
+    zoom.minY = std::min(zoom.minY, y);
+    maxX[z] = std::max(maxX[z], x);
+    maxY[z] = std::max(maxY[z], y);
+  }
+  for (int z = 0; z <= TILE_EXISTENCE_MAX_ZOOM; ++z)
+  {
+    if (!seen[z]) continue;
+    TileZoomBitmap &zoom = index->zooms[z];
+    zoom.width = maxX[z] - zoom.minX + 1;
+    zoom.height = maxY[z] - zoom.minY + 1;
+    zoom.bits = allocBitmap(z, zoom.width, zoom.height);
+    zoom.unknown = zoom.bits == nullptr;
+  }
+
+  // Second pass: set a bit for every tile
+  for (size_t i = 0; i < entryCount; ++i)
+  {
+    uint64_t key = entries[i].key;
+    int z = (int)(key >> 48);
+    if (z > TILE_EXISTENCE_MAX_ZOOM || index->zooms[z].bits == nullptr) continue;
+    TileZoomBitmap &zoom = index->zooms[z];
+    size_t bit = (size_t)(((key & 0xFFFFFF) - zoom.minY)) * zoom.width + (((key >> 24) & 0xFFFFFF) - zoom.minX);
+    zoom.bits[bit / 8] |= 1 << (bit % 8);
+  }
+  return index;
+}
+
+TileExistenceIndex *loadTileExistenceIndex(const char *filePath)
+{
+  File file = SD_MMC.open(filePath);
+  if (!file)
+  {
+    return nullptr;
+  }
+
+  TileExistenceHeader header;
+  if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, TILE_EXISTENCE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != TILE_EXISTENCE_VERSION)
+  {
+    ESP_LOGE("TileExists", "Invalid existence index: %s", filePath);
+    file.close();
+    return nullptr;
+  }
+
+  TileExistenceIndex *index = new TileExistenceIndex();
+  bool truncated = false;
+  for (int i = 0; i < header.zoomCount; ++i)
+  {
+    TileExistenceZoomHeader zoomHeader;
+    if (file.read((uint8_t *)&zoomHeader, sizeof(zoomHeader)) != sizeof(zoomHeader))
+    {
+      ESP_LOGE("TileExists", "Truncated existence index: %s", filePath);
+      truncated = true;
+      break;
+    }
+    size_t bytes = bitmapBytes(zoomHeader.width, zoomHeader.height);
+    uint8_t *bits = zoomHeader.z <= TILE_EXISTENCE_MAX_ZOOM ? allocBitmap(zoomHeader.z, zoomHeader.width, zoomHeader.height) : nullptr;
+    if (bits == nullptr)
+    {
+      if (zoomHeader.z <= TILE_EXISTENCE_MAX_ZOOM)
+      {
+        index->zooms[zoomHeader.z].unknown = true; // Lookups at this zoom report TILE_EXISTS_UNKNOWN
+      }
+      file.seek(file.position() + bytes);
+      continue;
+    }
+    if (file.read(bits, bytes) != bytes)
+    {
+      ESP_LOGE("TileExists", "Truncated bitmap for zoom %d: %s", zoomHeader.z, filePath);
+      heap_caps_free(bits);
+      truncated = true;
+      break;
+    }
+    TileZoomBitmap &zoom = index->zooms[zoomHeader.z];
+    zoom.minX = zoomHeader.minX;
+    zoom.minY = zoomHeader.minY;
+    zoom.width = zoomHeader.width;
+    zoom.height = zoomHeader.height;
+    zoom.bits = bits;
+  }
+  file.close();
+  if (truncated)
+  {
+    // The zooms after the cut are not known to be empty
+    for (int z = 0; z <= TILE_EXISTENCE_MAX_ZOOM; ++z)
+    {
+      index->zooms[z].unknown = index->zooms[z].bits == nullptr;
+    }
+  }
+  ESP_LOGI("TileExists", "Loaded existence index %s", filePath);
+  return index;
+}
+
+TileExistence tileExistenceLookup(const TileExistenceIndex *index, int z, int x, int y)
+{
+  if (index == nullptr || z < 0 || z > TILE_EXISTENCE_MAX_ZOOM || index->zooms[z].unknown)
+  {
+    return TILE_EXISTS_UNKNOWN;
+  }
+  const TileZoomBitmap &zoom = index->zooms[z];
+  if (zoom.bits == nullptr)
+  {
+    return TILE_EXISTS_NO; // The layer has no tiles at this zoom, e.g. an overlay below its minimum zoom
+  }
+  // Unsigned arithmetic turns coordinates left/above the bounding box into huge values
+  uint32_t column = (uint32_t)x - zoom.minX;
+  uint32_t row = (uint32_t)y - zoom.minY;
+  if (column >= zoom.width || row >= zoom.height)
+  {
+    return TILE_EXISTS_NO;
+  }
+  size_t bit = (size_t)row * zoom.width + column;
+  return (zoom.bits[bit / 8] & (1 << (bit % 8))) != 0 ? TILE_EXISTS_YES : TILE_EXISTS_NO;
+}
@@ -0,0 +1,53 @@
+#ifndef TILE_EXISTS_H
+#define TILE_EXISTS_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "tile_archive.h"
+
+// Per-zoom existence bitmaps of one map layer. Each zoom covers the bounding box of its tiles,
+// bit (y - minY) * width + (x - minX), least significant bit first.
+//
+// Shipped as /maps/<layer>.fhtx for loose tile directories (tools/pack_tiles.py --exists):
+//   TileExistenceHeader
+//   per zoom: TileExistenceZoomHeader followed by (width * height + 7) / 8 bitmap bytes
+
+const char TILE_EXISTENCE_MAGIC[4] = {'F', 'H', 'T', 'X'};
+const uint16_t TILE_EXISTENCE_VERSION = 1;
+const int TILE_EXISTENCE_MAX_ZOOM = 24; // Same limit as the archive key
+
+struct __attribute__((packed)) TileExistenceHeader
+{
+  char magic[4];     // "FHTX"
+  uint16_t version;  // TILE_EXISTENCE_VERSION
+  uint16_t zoomCount;
+};
+
+struct __attribute__((packed)) TileExistenceZoomHeader
+{
+  uint8_t z;
+  uint8_t reserved[3];
+  uint32_t minX;
+  uint32_t minY;
+  uint32_t width;
+  uint32_t height;
+};
+
+enum TileExistence
+{
+  TILE_EXISTS_NO = 0,
+  TILE_EXISTS_YES,
+  TILE_EXISTS_UNKNOWN, // No index for the layer, or the bitmap of this zoom could not be loaded
+};
+
+struct TileExistenceIndex;
+
+// Build the bitmaps from the index of an opened archive
+TileExistenceIndex *buildTileExistenceIndex(const TileArchive *archive);
+// Load the bitmaps shipped next to a loose tile directory. Returns nullptr if the file is missing or invalid.
+TileExistenceIndex *loadTileExistenceIndex(const char *filePath);
+// O(1) lookup. Zooms the index does not contain have no tiles at all.
+TileExistence tileExistenceLookup(const TileExistenceIndex *index, int z, int x, int y);
+
+#endif // TILE_EXISTS_H
@@ -0,0 +1,326 @@
+#include "tile_loader.h"
+#include "FS.h"     // SD Card ESP32
+#include "SD_MMC.h" // SD Card ESP32
+#include <esp_heap_caps.h> // For heap_caps_free
+#include <algorithm>       // For std::min, std::max
+#include "config.h"
+#include "tile_archive.h"
+#include "tile_cache.h"
+#include "tile_decoder.h"
+#include "tile_exists.h"
+
+// Declare extern global variables from main.cpp
+extern bool globalHikeOverlayEnabled;
+extern bool globalBikeOverlayEnabled;
+
+struct TileLayerInfo
+{
+  const char *name;      // Directory below /maps and archive file name
+  const char *extension; // Extension of loose tile files
+  bool isPng;
+};
+
+static const TileLayerInfo tileLayers[TILE_LAYER_COUNT] = {
+    {"pixelkarte-farbe", "jpeg", false},
+    {"hike", "png", true},
+    {"bike", "png", true},
+    {"pixelkarte-farbe+hike", "jpeg", false},
+    {"pixelkarte-farbe+bike", "jpeg", false},
+    {"pixelkarte-farbe+hike+bike", "jpeg", false},
+};
+
+// Pre-merged layer for each overlay combination, indexed by TILE_OVERLAY_* bits
+static const TileLayer mergedTileLayers[] = {
+    TILE_LAYER_BASE,
+    TILE_LAYER_BASE_HIKE,
+    TILE_LAYER_BASE_BIKE,
+    TILE_LAYER_BASE_HIKE_BIKE,
+};
+
+static TileArchive *tileArchives[TILE_LAYER_COUNT] = {};
+static TileLoadStats loadStats = {};
+static portMUX_TYPE loadStatsMux = portMUX_INITIALIZER_UNLOCKED;
+static TileExistenceIndex *tileExistence[TILE_LAYER_COUNT] = {};
+
+// Recently missing loose tiles of layers without existence bitmap, so each missing file is opened only once
+static uint64_t missingTileKeys[TILE_LAYER_COUNT][TILE_MISSING_CACHE_SIZE];
+static int missingTileCount[TILE_LAYER_COUNT] = {};
+static int missingTileNext[TILE_LAYER_COUNT] = {};
+static portMUX_TYPE missingTileMux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool isKnownMissing(TileLayer layer, uint64_t key)
+{
+  bool found = false;
+  portENTER_CRITICAL(&missingTileMux);
+  for (int i = 0; i < missingTileCount[layer] && !found; ++i)
+  {
+    found = missingTileKeys[layer][i] == key;
+  }
+  portEXIT_CRITICAL(&missingTileMux);
+  return found;
+}
+
+static void rememberMissing(TileLayer layer, uint64_t key)
+{
+  portENTER_CRITICAL(&missingTileMux);
+  missingTileKeys[layer][missingTileNext[layer]] = key;
+  missingTileNext[layer] = (missingTileNext[layer] + 1) % TILE_MISSING_CACHE_SIZE;
+  if (missingTileCount[layer] < TILE_MISSING_CACHE_SIZE)
+  {
+    missingTileCount[layer]++;
+  }
+  portEXIT_CRITICAL(&missingTileMux);
+}
+
+// Existence answer without touching the file system, TILE_EXISTS_UNKNOWN if only an SD lookup can tell
+static TileExistence lookupTileExistence(TileLayer layer, int zoom, int tileX, int tileY)
+{
+  TileExistence existence = tileExistenceLookup(tileExistence[layer], zoom, tileX, tileY);
+  if (existence != TILE_EXISTS_UNKNOWN)
+  {
+    return existence;
+  }
+  if (tileArchives[layer] != nullptr)
+  {
+    return tileArchiveFind(tileArchives[layer], zoom, tileX, tileY) > 0 ? TILE_EXISTS_YES : TILE_EXISTS_NO;
+  }
+  if (layer >= TILE_LAYER_BASE_HIKE)
+  {
+    return TILE_EXISTS_NO; // Pre-merged layers only exist as archives
+  }
+  return isKnownMissing(layer, tileArchiveKey(zoom, tileX, tileY)) ? TILE_EXISTS_NO : TILE_EXISTS_UNKNOWN;
+}
+
+void initTileLoader()
+{
+  initTileDecoder();
+
+  char archivePath[TILE_PATH_MAX_LENGTH];
+  for (int layer = 0; layer < TILE_LAYER_COUNT; ++layer)
+  {
+    snprintf(archivePath, sizeof(archivePath), "/maps/%s.fhta", tileLayers[layer].name);
+    tileArchives[layer] = openTileArchive(archivePath);
+    if (tileArchives[layer] != nullptr)
+    {
+      tileExistence[layer] = buildTileExistenceIndex(tileArchives[layer]);
+    }
+    else if (layer >= TILE_LAYER_BASE_HIKE)
+    {
+      continue; // Pre-merged layers are optional and only exist as archives
+    }
+    else
+    {
+      // Existence bitmaps shipped next to a loose tile directory
+      snprintf(archivePath, sizeof(archivePath), "/maps/%s.fhtx", tileLayers[layer].name);
+      tileExistence[layer] = loadTileExistenceIndex(archivePath);
+    }
+    ESP_LOGI("TileLoader", "Layer %s: %s, %s", tileLayers[layer].name,
+             tileArchives[layer] ? "packed archive" : "loose files",
+             tileExistence[layer] ? "existence bitmap" : "negative lookup cache");
+  }
+}
+
+void formatTileLayerPath(char *filePath, TileLayer layer, int zoom, int tileX, int tileY)
+{
+  snprintf(filePath, TILE_PATH_MAX_LENGTH, "/maps/%s/%d/%d/%d.%s",
+           tileLayers[layer].name, zoom, tileX, tileY, tileLayers[layer].extension);
+}
+
+uint8_t *allocTileBlobBuffer()
+{
+  uint8_t *buffer = allocTileDecoderInputBuffer(TILE_BLOB_MAX_BYTES);
+  if (buffer == nullptr)
+  {
+    ESP_LOGE("TileLoader", "Failed to allocate tile blob buffer.");
+  }
+  return buffer;
+}
+
+bool tileLayerExists(TileLayer layer, int zoom, int tileX, int tileY)
+{
+  TileExistence existence = lookupTileExistence(layer, zoom, tileX, tileY);
+  if (existence != TILE_EXISTS_UNKNOWN)
+  {
+    return existence == TILE_EXISTS_YES;
+  }
+  char filePath[TILE_PATH_MAX_LENGTH];
+  formatTileLayerPath(filePath, layer, zoom, tileX, tileY);
+  if (!SD_MMC.exists(filePath))
+  {
+    rememberMissing(layer, tileArchiveKey(zoom, tileX, tileY));
+    return false;
+  }
+  return true;
+}
+
+static void recordLoadTiming(uint32_t openUs, uint32_t readUs, uint32_t decodeUs, size_t bytes)
+{
+  portENTER_CRITICAL(&loadStatsMux);
+  loadStats.tiles++;
+  loadStats.bytes += bytes;
+  loadStats.openUs += openUs;
+  loadStats.readUs += readUs;
+  loadStats.decodeUs += decodeUs;
+  loadStats.maxOpenUs = std::max(loadStats.maxOpenUs, openUs);
+  loadStats.maxReadUs = std::max(loadStats.maxReadUs, readUs);
+  loadStats.maxDecodeUs = std::max(loadStats.maxDecodeUs, decodeUs);
+  portEXIT_CRITICAL(&loadStatsMux);
+}
+
+void tileLoaderGetStats(TileLoadStats *stats)
+{
+  portENTER_CRITICAL(&loadStatsMux);
+  *stats = loadStats;
+  portEXIT_CRITICAL(&loadStatsMux);
+}
+
+bool drawTileLayer(M5Canvas &canvas, TileLayer layer, int zoom, int tileX, int tileY, uint8_t *blobBuffer)
+{
+  if (lookupTileExistence(layer, zoom, tileX, tileY) == TILE_EXISTS_NO)
+  {
+    return false; // Outside the covered area, no file system access
+  }
+  if (blobBuffer == nullptr)
+  {
+    return false;
+  }
+
+  uint32_t startUs = micros();
+  uint32_t openUs = 0;
+  size_t length = 0;
+  bool isPng = tileLayers[layer].isPng;
+  TileArchive *archive = tileArchives[layer];
+  if (archive != nullptr)
+  {
+    // One seek and one read from the already open archive
+    length = tileArchiveRead(archive, zoom, tileX, tileY, blobBuffer, TILE_BLOB_MAX_BYTES);
+    isPng = tileArchiveFormat(archive) == TILE_ARCHIVE_FORMAT_PNG;
+  }
+  else
+  {
+    // Open the loose file once and read it whole with one sized read
+    char filePath[TILE_PATH_MAX_LENGTH];
+    formatTileLayerPath(filePath, layer, zoom, tileX, tileY);
+    File file = SD_MMC.open(filePath);
+    openUs = micros() - startUs;
+    if (!file)
+    {
+      ESP_LOGE("SD_CARD", "Failed to open file for reading: %s", filePath);
+      rememberMissing(layer, tileArchiveKey(zoom, tileX, tileY));
+      return false;
+    }
+    size_t fileSize = file.size();
+    if (fileSize > TILE_BLOB_MAX_BYTES)
+    {
+      ESP_LOGE("SD_CARD", "Tile %s is %u bytes, buffer holds %u", filePath, (unsigned)fileSize, (unsigned)TILE_BLOB_MAX_BYTES);
+    }
+    else if (file.read(blobBuffer, fileSize) == fileSize)
+    {
+      length = fileSize;
+    }
+    file.close();
+  }
+  if (length == 0)
+  {
+    return false;
+  }
+
+  // Decode from memory
+  uint32_t readDoneUs = micros();
+  bool decoded = isPng ? decodeTilePng(canvas, blobBuffer, length) : decodeTileJpeg(canvas, blobBuffer, length);
+  uint32_t decodeUs = micros() - readDoneUs;
+  recordLoadTiming(openUs, readDoneUs - startUs - openUs, decodeUs, length);
+  return decoded;
+}
+
+uint8_t activeTileOverlays()
+{
+  return (globalHikeOverlayEnabled ? TILE_OVERLAY_HIKE : 0) | (globalBikeOverlayEnabled ? TILE_OVERLAY_BIKE : 0);
+}
+
+bool drawCompositedTile(M5Canvas &canvas, int zoom, int tileX, int tileY, uint8_t overlays, uint8_t *blobBuffer, bool prefetched)
+{
+  // Revisits cost one copy out of the cache
+  TileKey key = {zoom, tileX, tileY, overlays};
+  if (tileCacheGet(key, canvas.getBuffer()))
+  {
+    return true;
+  }
+
+  bool drawn = false;
+  TileLayer mergedLayer = mergedTileLayers[overlays];
+  if (overlays != 0 && tileArchives[mergedLayer] != nullptr)
+  {
+    // The packer already composited the overlays into a JPEG
+    drawn = drawTileLayer(canvas, mergedLayer, zoom, tileX, tileY, blobBuffer);
+  }
+
+  bool cacheable = true;
+  if (!drawn)
+  {
+    TileKey baseKey = {zoom, tileX, tileY, 0};
+    if (overlays != 0 && tileCacheGet(baseKey, canvas.getBuffer(), false)) // Counted once, as the miss of key
+    {
+      drawn = true;
+    }
+    else if (drawTileLayer(canvas, TILE_LAYER_BASE, zoom, tileX, tileY, blobBuffer))
+    {
+      drawn = true;
+      if (overlays != 0)
+      {
+        tileCachePut(baseKey, canvas.getBuffer(), prefetched); // Keep the base for other overlay combinations
+      }
+    }
+    else if (overlays != 0)
+    {
+      // No base map: draw the overlays onto an empty tile instead of whatever the canvas held before, and keep the
+      // result out of the cache so the tile is composited again once the base can be read
+      canvas.fillSprite(TFT_DARKCYAN);
+      cacheable = false;
+    }
+    if ((overlays & TILE_OVERLAY_HIKE) != 0)
+    {
+      drawn |= drawTileLayer(canvas, TILE_LAYER_HIKE, zoom, tileX, tileY, blobBuffer);
+    }
+    if ((overlays & TILE_OVERLAY_BIKE) != 0)
+    {
+      drawn |= drawTileLayer(canvas, TILE_LAYER_BIKE, zoom, tileX, tileY, blobBuffer);
+    }
+  }
+
+  if (drawn && cacheable)
+  {
+    tileCachePut(key, canvas.getBuffer(), prefetched);
+  }
+  return drawn;
+}
+
+bool drawTileFallback(M5Canvas &canvas, int zoom, int tileX, int tileY, uint8_t overlays, uint8_t *blobBuffer, bool allowDecode)
+{
+  for (int levels = 1; levels <= TILE_FALLBACK_MAX_LEVELS && levels <= zoom && (TILE_SIZE >> levels) > 0; ++levels)
+  {
+    int ancestorX = tileX >> levels;
+    int ancestorY = tileY >> levels;
+    int quadrantX = tileX - (ancestorX << levels);
+    int quadrantY = tileY - (ancestorY << levels);
+    TileKey ancestorKey = {zoom - levels, ancestorX, ancestorY, overlays};
+    TileKey ancestorBaseKey = {zoom - levels, ancestorX, ancestorY, 0};
+
+    if (tileCacheGetUpscaled(ancestorKey, levels, quadrantX, quadrantY, canvas.getBuffer()) ||
+        (overlays != 0 && tileCacheGetUpscaled(ancestorBaseKey, levels, quadrantX, quadrantY, canvas.getBuffer())))
+    {
+      ESP_LOGD("TileLoader", "Tile %d/%d/%d upscaled from zoom %d", zoom, tileX, tileY, zoom - levels);
+      return true;
+    }
+
+    if (allowDecode && drawCompositedTile(canvas, zoom - levels, ancestorX, ancestorY, overlays, blobBuffer) &&
+        tileCacheGetUpscaled(ancestorKey, levels, quadrantX, quadrantY, canvas.getBuffer()))
+    {
+      // The tile does not exist at this zoom: keep the upscaled version so overzoomed redraws are one copy
+      tileCachePut({zoom, tileX, tileY, overlays}, canvas.getBuffer());
+      ESP_LOGD("TileLoader", "Tile %d/%d/%d overzoomed from zoom %d", zoom, tileX, tileY, zoom - levels);
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,53 @@
+#ifndef TILE_LOADER_H
+#define TILE_LOADER_H
+
+#include <Arduino.h>
+#include <M5Unified.h>
+#include <stdint.h>
+
+// Map layers stored on the SD card, either as /maps/<name>.fhta archive or as /maps/<name>/z/x/y.<ext> files
+enum TileLayer
+{
+  TILE_LAYER_BASE = 0, // pixelkarte-farbe, JPEG
+  TILE_LAYER_HIKE,     // Hiking trail overlay, PNG
+  TILE_LAYER_BIKE,     // Bike route overlay, PNG
+  // Base map with overlays pre-merged by tools/pack_tiles.py --overlay, archive only
+  TILE_LAYER_BASE_HIKE,
+  TILE_LAYER_BASE_BIKE,
+  TILE_LAYER_BASE_HIKE_BIKE,
+  TILE_LAYER_COUNT
+};
+
+// Accumulated per-stage timing of tile loads (open is 0 for archive reads)
+struct TileLoadStats
+{
+  uint32_t tiles;
+  uint64_t bytes;
+  uint64_t openUs;
+  uint64_t readUs;
+  uint64_t decodeUs;
+  uint32_t maxOpenUs;
+  uint32_t maxReadUs;
+  uint32_t maxDecodeUs;
+};
+
+// Open the packed archives that exist on the SD card; layers without archive fall back to loose files.
+void initTileLoader();
+void formatTileLayerPath(char *filePath, TileLayer layer, int zoom, int tileX, int tileY);
+// Allocate a PSRAM buffer of TILE_BLOB_MAX_BYTES for compressed tile data. Each task needs its own.
+uint8_t *allocTileBlobBuffer();
+bool tileLayerExists(TileLayer layer, int zoom, int tileX, int tileY);
+// Read one layer of a tile into blobBuffer with a single read and decode it from memory onto canvas at (0,0).
+// Returns false if the tile is missing or fails to decode.
+bool drawTileLayer(M5Canvas &canvas, TileLayer layer, int zoom, int tileX, int tileY, uint8_t *blobBuffer);
+void tileLoaderGetStats(TileLoadStats *stats);
+// TILE_OVERLAY_* bits of the overlays currently enabled by the user
+uint8_t activeTileOverlays();
+// Draw a base tile with the given overlays composited on top. The composited result is served from and
+// stored into the tile cache; pre-merged archives skip the PNG decoding. Returns false if nothing was drawn.
+bool drawCompositedTile(M5Canvas &canvas, int zoom, int tileX, int tileY, uint8_t overlays, uint8_t *blobBuffer, bool prefetched = false);
+// Fill canvas with the matching square of the nearest ancestor tile (z-1, z-2, ...), upscaled. Used while a
+// tile is still loading (cached ancestors only) and for tiles missing on the SD card (allowDecode, overzoom).
+bool drawTileFallback(M5Canvas &canvas, int zoom, int tileX, int tileY, uint8_t overlays, uint8_t *blobBuffer, bool allowDecode);
+
+#endif // TILE_LOADER_H
@@ -0,0 +1,127 @@
+#include "tile_prefetch.h"
+#include <M5Unified.h>
+#include <cmath>
+#include "config.h"
+#include "tile_cache.h"
+#include "tile_loader.h"
+#include "tile_calculator.h"
+#include "telemetry_bus.h"
+
+// Declare extern global variables from main.cpp
+extern int globalTileZ;
+
+// Separate decode target so the prefetcher never touches the GUI canvases
+static M5Canvas prefetchCanvas;
+static uint8_t *prefetchBlobBuffer = nullptr;
+static int prefetchSubscriber = -1;
+
+void initTilePrefetchTask()
+{
+  prefetchCanvas.setPsram(true);
+  prefetchCanvas.createSprite(TILE_SIZE, TILE_SIZE);
+  prefetchBlobBuffer = allocTileBlobBuffer();
+  prefetchSubscriber = telemetrySubscribe("Prefetch", TOPIC_MASK(TOPIC_GPS_FIX), PREFETCH_TELEMETRY_QUEUE_DEPTH);
+  ESP_LOGI("Prefetch", "Tile prefetch task initialized.");
+}
+
+// Decode a tile with the active overlays into the cache unless it is already there. Returns true if a tile was decoded.
+static bool prefetchTile(int zoom, int tileX, int tileY, uint8_t overlays)
+{
+  TileKey key = {zoom, tileX, tileY, overlays};
+  if (tileCacheContains(key))
+  {
+    return false;
+  }
+
+  if (!tileLayerExists(TILE_LAYER_BASE, zoom, tileX, tileY))
+  {
+    return false;
+  }
+  prefetchCanvas.clear(TFT_DARKCYAN);
+  if (!drawCompositedTile(prefetchCanvas, zoom, tileX, tileY, overlays, prefetchBlobBuffer, true))
+  {
+    ESP_LOGW("Prefetch", "Failed to decode tile %d/%d/%d", zoom, tileX, tileY);
+    return false;
+  }
+  ESP_LOGD("Prefetch", "Prefetched tile %d/%d/%d", zoom, tileX, tileY);
+  return true;
+}
+
+void tilePrefetchTask(void *pvParameters)
+{
+  (void)pvParameters; // Suppress unused parameter warning
+
+  for (;;)
+  {
+    // Predict from the newest fix only; fixes that arrived during the last cycle are stale
+    TelemetryMessage message;
+    if (!telemetryReceive(prefetchSubscriber, &message, portMAX_DELAY))
+    {
+      continue;
+    }
+    while (telemetryReceive(prefetchSubscriber, &message, 0))
+    {
+    }
+
+    const GpsSnapshot &fix = message.gps;
+    double latitude = fix.latitude;
+    double longitude = fix.longitude;
+    double direction = fix.direction;
+    double speed = fix.speed;
+    bool valid = fix.valid;
+    int zoom = globalTileZ;
+    uint8_t overlays = activeTileOverlays();
+
+    if (!valid || speed < PREFETCH_MIN_SPEED_KMPH)
+    {
+      continue; // Standing still: the visible grid is all we need
+    }
+
+    // Distance covered within the lookahead window, converted to pixels at the current zoom
+    double metersPerPixel = EARTH_CIRCUMFERENCE_M * cos(latitude * M_PI / 180.0) / (TILE_SIZE * pow(2.0, zoom));
+    double lookaheadPixels = (speed / 3.6) * PREFETCH_LOOKAHEAD_S / metersPerPixel;
+    if (lookaheadPixels > PREFETCH_MAX_LOOKAHEAD_TILES * TILE_SIZE)
+    {
+      lookaheadPixels = PREFETCH_MAX_LOOKAHEAD_TILES * TILE_SIZE;
+    }
+
+    // Course over ground: 0 deg = north, clockwise; screen y grows southwards
+    double directionRad = direction * M_PI / 180.0;
+    double stepX = sin(directionRad);
+    double stepY = -cos(directionRad);
+
+    long pixelX = 0;
+    long pixelY = 0;
+    latLngToGlobalPixel(latitude, longitude, zoom, &pixelX, &pixelY);
+
+    // Walk along the predicted track in half-tile steps and fetch the grid around each point, nearest first
+    // Stop the whole walk once the budget is used or the zoom changed, the predictions are stale then
+    int decoded = 0;
+    bool searching = true;
+    for (double distance = TILE_SIZE / 2; searching && distance <= lookaheadPixels; distance += TILE_SIZE / 2)
+    {
+      int centerTileX = (int)floor((pixelX + stepX * distance) / TILE_SIZE);
+      int centerTileY = (int)floor((pixelY + stepY * distance) / TILE_SIZE);
+      for (int yOffset = -DRAW_GRID_CENTER_OFFSET; searching && yOffset <= DRAW_GRID_CENTER_OFFSET; ++yOffset)
+      {
+        for (int xOffset = -DRAW_GRID_CENTER_OFFSET; searching && xOffset <= DRAW_GRID_CENTER_OFFSET; ++xOffset)
+        {
+          if (prefetchTile(zoom, centerTileX + xOffset, centerTileY + yOffset, overlays))
+          {
+            decoded++;
+          }
+          searching = decoded < PREFETCH_MAX_TILES_PER_CYCLE && zoom == globalTileZ;
+        }
+      }
+    }
+
+    if (decoded > 0)
+    {
+      TileCacheStats stats;
+      tileCacheGetStats(&stats);
+      ESP_LOGI("Prefetch", "Prefetched %d tiles (Speed %.1f km/h, Dir %.0f deg). Prefetch hits: %lu, wasted: %lu",
+               decoded, speed, direction, stats.prefetchHits, stats.prefetchWasted);
+    }
+    vTaskDelay(pdMS_TO_TICKS(PREFETCH_TASK_DELAY_MS)); // Bound the prediction rate at high GPS update rates
+  }
+}
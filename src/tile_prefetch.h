@@ -0,0 +1,17 @@
+#ifndef TILE_PREFETCH_H
+#define TILE_PREFETCH_H
+
+#include <Arduino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void initTilePrefetchTask();
+void tilePrefetchTask(void *pvParameters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TILE_PREFETCH_H
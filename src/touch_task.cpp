@@ -1,25 +1,27 @@
 #include <M5Unified.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/event_groups.h>
-#include <cmath> // For sqrt, pow
+#include <cmath> // For sqrt, pow, ldexp, lround, log2f
+#include <algorithm> // For std::min, std::max
 #include "touch_task.h"
 #include "config.h"
-#include "gui.h"      // For xGuiUpdateEventGroup, GUI_EVENT_MAP_DATA_READY, and handleSoundButtonPress
+#include "gui.h"      // For handleSoundButtonPress
 #include "gps_task.h" // For globalTileZ
 #include "tile_calculator.h" // For pixelToLatLng
-#include "gui.h" // For GUI_EVENT_HIKE_BUTTON_READY, GUI_EVENT_BIKE_BUTTON_READY, GUI_EVENT_SOUND_BUTTON_READY
+#include "telemetry.h" // For gpsState
+#include "telemetry_bus.h" // For UI input messages
+#include "vario_audio.h" // For varioAudioSoundChanged
 
 // Global variables declared in main.cpp
 extern int globalTileZ;
 
 // Global variables declared in config.h and gui.h
-extern EventGroupHandle_t xGuiUpdateEventGroup;
 extern bool globalTwoFingerGestureActive;
+extern float globalPinchScale;
+extern int globalPinchAnchorX;
+extern int globalPinchAnchorY;
 extern int globalManualZoomLevel;
 extern bool globalManualMapMode;
-extern double globalLatitude;
-extern double globalLongitude;
 extern bool globalHikeOverlayEnabled;
 extern bool globalBikeOverlayEnabled;
 extern bool globalSoundEnabled;
@@ -39,6 +41,7 @@ extern M5Canvas gpsCanvas; // For gpsCanvas.height()
 
 // Internal variables for touch gesture
 static int initialTouchDistance = 0;
+static int pinchStartDistance = 0;   // Finger distance when the pinch left the ZOOM_THRESHOLD dead band, 0 = still inside
 static int lastTouchX = 0;
 static int lastTouchY = 0;
 static unsigned long lastTapTime = 0; // For double-tap detection
@@ -59,6 +62,68 @@ void initTouchMonitorTask()
     ESP_LOGI("initTouchMonitorTask", "Touch monitor task initialized.");
 }
  
+// Move the map center; the rest of the fix stays untouched. Goes through the seqlock so readers never see a torn position.
+static void setMapPosition(double latitude, double longitude)
+{
+    gpsState.modify([latitude, longitude](GpsSnapshot &fix) {
+        fix.latitude = latitude;
+        fix.longitude = longitude;
+    });
+}
+
+// Switch to a new zoom level. In manual map mode the map point between the fingers stays in place, so the
+// GUI can rescale the current map around it; while following the GPS the zoom is centered on the position.
+static void applyPinchZoom(int newZoom, int anchorX, int anchorY)
+{
+    int oldZoom = globalTileZ;
+    if (newZoom == oldZoom)
+    {
+        return; // Already at the zoom limit
+    }
+
+    if (globalManualMapMode)
+    {
+        GpsSnapshot position = gpsState.read();
+        long centerX, centerY;
+        latLngToGlobalPixel(position.latitude, position.longitude, oldZoom, &centerX, &centerY);
+        long anchorOffsetX = anchorX - M5.Display.width() / 2;
+        long anchorOffsetY = anchorY - M5.Display.height() / 2;
+        double scale = ldexp(1.0, newZoom - oldZoom);
+        long newCenterX = lround((centerX + anchorOffsetX) * scale) - anchorOffsetX;
+        long newCenterY = lround((centerY + anchorOffsetY) * scale) - anchorOffsetY;
+        double newLat, newLng;
+        pixelToLatLng(newCenterX, newCenterY, newZoom, &newLat, &newLng);
+        setMapPosition(newLat, newLng);
+    }
+    globalTileZ = newZoom;
+    telemetryPublish(UI_INPUT_MAP_MOVED);
+}
+
+// End of a pinch: snap the fractional scale to the nearest zoom level and load it with one decode pass
+static void finishPinchZoom()
+{
+    globalTwoFingerGestureActive = false;
+    float scale = globalPinchScale;
+    if (scale == 1.0f)
+    {
+        return;
+    }
+
+    int newZoom = globalTileZ + (int)lroundf(log2f(scale));
+    newZoom = std::max(MIN_ZOOM_LEVEL, std::min(MAX_ZOOM_LEVEL, newZoom));
+    globalManualZoomLevel = newZoom;
+    globalPinchScale = 1.0f;
+    if (newZoom == globalTileZ)
+    {
+        telemetryPublish(UI_INPUT_MAP_ZOOM_PREVIEW); // Snap back to the unscaled map
+    }
+    else
+    {
+        applyPinchZoom(newZoom, globalPinchAnchorX, globalPinchAnchorY);
+    }
+    ESP_LOGI("touchMonitorTask", "Pinch scale %.2f, new zoom level: %d", scale, newZoom);
+}
+
 void touchMonitorTask(void *pvParameters)
 {
     ESP_LOGI("touchMonitorTask", "Task started.");
@@ -87,46 +152,34 @@ void touchMonitorTask(void *pvParameters)
                 // Start of a new two-finger gesture
                 globalTwoFingerGestureActive = true;
                 initialTouchDistance = currentTouchDistance;
+                pinchStartDistance = 0;
                 ESP_LOGD("touchMonitorTask", "Two-finger gesture started. Initial distance: %d", initialTouchDistance);
             }
             else
             {
-                // Gesture in progress
+                // Gesture in progress: scale the map continuously, the zoom level is only changed on release
+                // The scale starts at 1 where the dead band is left, so the map does not jump by the threshold
                 int distanceChange = currentTouchDistance - initialTouchDistance;
- 
-                if (distanceChange > ZOOM_THRESHOLD)
+                if (pinchStartDistance == 0 && abs(distanceChange) > ZOOM_THRESHOLD && currentTouchDistance > 0)
                 {
-                    // Spread gesture (zoom in)
-                    if (globalManualZoomLevel == 0)
-                    { // If no manual zoom set, use globalTileZ as base
-                        globalManualZoomLevel = globalTileZ;
-                    }
-                    globalManualZoomLevel++;
-                    if (globalManualZoomLevel > MAX_ZOOM_LEVEL)
-                    {
-                        globalManualZoomLevel = MAX_ZOOM_LEVEL;
-                    }
-                    globalTileZ = globalManualZoomLevel;
-                    initialTouchDistance = currentTouchDistance; // Reset initial distance for continuous zooming
-                    xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_MAP_DATA_READY);
-                    ESP_LOGI("touchMonitorTask", "Zoom In. New zoom level: %d", globalManualZoomLevel);
+                    pinchStartDistance = currentTouchDistance;
                 }
-                else if (distanceChange < -ZOOM_THRESHOLD)
+                float scale = 1.0f;
+                if (pinchStartDistance > 0)
                 {
-                    // Pinch gesture (zoom out)
-                    if (globalManualZoomLevel == 0)
-                    { // If no manual zoom set, use globalTileZ as base
-                        globalManualZoomLevel = globalTileZ;
-                    }
-                    globalManualZoomLevel--;
-                    if (globalManualZoomLevel < MIN_ZOOM_LEVEL)
-                    {
-                        globalManualZoomLevel = MIN_ZOOM_LEVEL;
-                    }
-                    globalTileZ = globalManualZoomLevel;
-                    initialTouchDistance = currentTouchDistance; // Reset initial distance for continuous zooming
-                    xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_MAP_DATA_READY);
-                    ESP_LOGI("touchMonitorTask", "Zoom Out. New zoom level: %d", globalManualZoomLevel);
+                    scale = (float)currentTouchDistance / pinchStartDistance;
+                }
+                // Do not scale beyond the zoom limits
+                scale = std::min(scale, ldexpf(1.0f, MAX_ZOOM_LEVEL - globalTileZ));
+                scale = std::max(scale, ldexpf(1.0f, MIN_ZOOM_LEVEL - globalTileZ));
+
+                if (scale != globalPinchScale)
+                {
+                    // Follow mode zooms around the position, manual mode around the fingers
+                    globalPinchAnchorX = globalManualMapMode ? (x1 + x2) / 2 : M5.Display.width() / 2;
+                    globalPinchAnchorY = globalManualMapMode ? (y1 + y2) / 2 : M5.Display.height() / 2;
+                    globalPinchScale = scale;
+                    telemetryPublish(UI_INPUT_MAP_ZOOM_PREVIEW);
                 }
             }
         }
@@ -134,7 +187,10 @@ void touchMonitorTask(void *pvParameters)
         {
             int x1 = touchPoint[0].x;
             int y1 = touchPoint[0].y;
-            globalTwoFingerGestureActive = false;
+            if (globalTwoFingerGestureActive)
+            {
+                finishPinchZoom(); // One finger lifted
+            }
             unsigned long currentTime = M5.millis();
  
             if (!isTouched) // Only process as a new tap if not already touched
@@ -196,8 +252,9 @@ void touchMonitorTask(void *pvParameters)
                     int deltaY = y1 - singleTouchY;
  
                     // Convert pixel offset to lat/lon change
-                    double currentLat = globalLatitude;
-                    double currentLng = globalLongitude;
+                    GpsSnapshot position = gpsState.read();
+                    double currentLat = position.latitude;
+                    double currentLng = position.longitude;
                     int currentZoom = globalTileZ;
                     ESP_LOGD("touchMonitorTask", "Current Lat/Lng before pan - Lat: %.6f, Lng: %.6f", currentLat, currentLng);
  
@@ -215,18 +272,20 @@ void touchMonitorTask(void *pvParameters)
                     double newLat, newLng;
                     pixelToLatLng(newGlobalPixelX, newGlobalPixelY, currentZoom, &newLat, &newLng);
                     ESP_LOGD("touchMonitorTask", "New Lat/Lng after pan - Lat: %.6f, Lng: %.6f", newLat, newLng);
-                    globalLatitude = newLat;
-                    globalLongitude = newLng;
+                    setMapPosition(newLat, newLng);
  
-                    xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_MAP_DATA_READY);
-                    ESP_LOGD("touchMonitorTask", "Map panned to new Lat: %.6f, Lng: %.6f", globalLatitude, globalLongitude);
+                    telemetryPublish(UI_INPUT_MAP_MOVED);
+                    ESP_LOGD("touchMonitorTask", "Map panned to new Lat: %.6f, Lng: %.6f", newLat, newLng);
                 }
             }
  
             singleTouchX = -1;
             singleTouchY = -1;
             isTouched = false; // Reset touch active flag
-            globalTwoFingerGestureActive = false;
+            if (globalTwoFingerGestureActive)
+            {
+                finishPinchZoom();
+            }
  
             // If no touch, and we were in manual map mode, reset tapCount if enough time has passed
             if (globalManualMapMode && tapCount > 0)
@@ -251,7 +310,7 @@ void handleHikeButtonPress(int x, int y)
   {
     ESP_LOGE("HikeOverlayButton", "Hike Overlay button pressed.");
       globalHikeOverlayEnabled = !globalHikeOverlayEnabled;
-    xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_HIKE_BUTTON_READY); // Signal GUI task
+    telemetryPublish(UI_INPUT_HIKE_BUTTON); // Signal GUI task
   }
   else
   {
@@ -268,7 +327,7 @@ void handleBikeButtonPress(int x, int y)
   {
     ESP_LOGE("BikeOverlayButton", "Bike Overlay button pressed.");
     globalBikeOverlayEnabled = !globalBikeOverlayEnabled;
-    xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_BIKE_BUTTON_READY); // Signal GUI task
+    telemetryPublish(UI_INPUT_BIKE_BUTTON); // Signal GUI task
   }
   else
   {
@@ -282,8 +341,9 @@ void handleSoundButtonPress(int x, int y)
       y >= soundButtonY && y <= (soundButtonY + soundButtonHeight))
   {
     globalSoundEnabled = !globalSoundEnabled;
+    varioAudioSoundChanged(); // Wake the audio task if it sleeps while muted
     ESP_LOGE("SoundButton", "Sound button pressed. globalSoundEnabled: %s", globalSoundEnabled ? "true" : "false");
-    xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_SOUND_BUTTON_READY); // Signal GUI task
+    telemetryPublish(UI_INPUT_SOUND_BUTTON); // Signal GUI task
   }
   else
   {
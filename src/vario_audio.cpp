@@ -0,0 +1,98 @@
+#include "vario_audio.h"
+#include <M5Unified.h>
+#include <atomic>
+#include "vario_tone.h"
+#include "config.h"
+
+static VarioToneGenerator generator;
+static std::atomic<float> targetVerticalSpeed(0.0f);
+// The speaker reads a block while it is queued or playing, so one more buffer than its two slots is rendered into
+static int16_t audioBuffers[VARIO_AUDIO_BUFFER_COUNT][VARIO_AUDIO_BLOCK_SAMPLES];
+static TaskHandle_t audioTaskHandle = NULL;
+
+static bool soundEnabled()
+{
+  return SPEAKER_ENABLED && globalSoundEnabled;
+}
+
+void initVarioAudio()
+{
+  VarioToneProfile profile;
+  profile.climbThreshold = ALTITUDE_CHANGE_THRESHOLD_MPS;
+  profile.climbExitThreshold = ALTITUDE_CHANGE_THRESHOLD_MPS - VARIO_TONE_HYSTERESIS_MPS;
+  profile.climbBaseHz = RISING_TONE_BASE_FREQ_HZ;
+  profile.climbHzPerMps = RISING_TONE_MULTIPLIER_HZ_PER_MPS;
+  profile.climbPeriodMs = VARIO_CLIMB_PERIOD_MS;
+  profile.climbPeriodMsPerMps = VARIO_CLIMB_PERIOD_MS_PER_MPS;
+  profile.climbMinPeriodMs = VARIO_CLIMB_MIN_PERIOD_MS;
+  profile.climbDuty = VARIO_CLIMB_DUTY;
+  profile.sinkThreshold = ALTITUDE_CHANGE_THRESHOLD_MPS;
+  profile.sinkExitThreshold = ALTITUDE_CHANGE_THRESHOLD_MPS - VARIO_TONE_HYSTERESIS_MPS;
+  profile.sinkBaseHz = SINKING_TONE_BASE_FREQ_HZ;
+  profile.sinkHzPerMps = SINKING_TONE_MULTIPLIER_HZ_PER_MPS;
+  profile.minHz = MIN_TONE_FREQ_HZ;
+  profile.sinkAlarmThreshold = VARIO_SINK_ALARM_THRESHOLD_MPS;
+  profile.sinkAlarmExitThreshold = VARIO_SINK_ALARM_THRESHOLD_MPS + VARIO_TONE_HYSTERESIS_MPS;
+  profile.sinkAlarmHighHz = VARIO_SINK_ALARM_HIGH_HZ;
+  profile.sinkAlarmLowHz = VARIO_SINK_ALARM_LOW_HZ;
+  profile.sinkAlarmPeriodMs = VARIO_SINK_ALARM_PERIOD_MS;
+  profile.glideMs = VARIO_TONE_GLIDE_MS;
+  profile.rampMs = VARIO_TONE_RAMP_MS;
+  profile.amplitude = VARIO_TONE_AMPLITUDE;
+  generator.begin(profile, VARIO_AUDIO_SAMPLE_RATE);
+}
+
+void varioAudioSetVerticalSpeed(float verticalSpeed)
+{
+  targetVerticalSpeed.store(verticalSpeed, std::memory_order_relaxed);
+}
+
+void varioAudioSoundChanged()
+{
+  if (audioTaskHandle != NULL)
+  {
+    xTaskNotifyGive(audioTaskHandle);
+  }
+}
+
+void varioAudioTask(void *pvParameters)
+{
+  (void)pvParameters;
+  audioTaskHandle = xTaskGetCurrentTaskHandle();
+
+  // isPlaying() is 2 while a block plays and another one is queued; the buffer after them is free again once the
+  // playing block ends, within one block. Checking every half block leaves the other half to render the next one
+  // before the queued block runs out.
+  const uint32_t blockMs = VARIO_AUDIO_BLOCK_SAMPLES * 1000 / VARIO_AUDIO_SAMPLE_RATE;
+  const TickType_t waitTicks = pdMS_TO_TICKS(blockMs / 2) > 0 ? pdMS_TO_TICKS(blockMs / 2) : 1;
+
+  int next = 0;
+  for (;;)
+  {
+    while (M5.Speaker.isPlaying(VARIO_AUDIO_CHANNEL) == 2)
+    {
+      vTaskDelay(waitTicks);
+    }
+
+    bool enabled = soundEnabled();
+    generator.setEnabled(enabled);
+    generator.setVerticalSpeed(targetVerticalSpeed.load(std::memory_order_relaxed));
+    generator.render(audioBuffers[next], VARIO_AUDIO_BLOCK_SAMPLES);
+    M5.Speaker.playRaw(audioBuffers[next], VARIO_AUDIO_BLOCK_SAMPLES, VARIO_AUDIO_SAMPLE_RATE, false, 1, VARIO_AUDIO_CHANNEL, false);
+    next = (next + 1) % VARIO_AUDIO_BUFFER_COUNT;
+
+    if (!enabled)
+    {
+      // The block just queued fades the tone out. Let it play, then sleep instead of streaming silence until
+      // varioAudioSoundChanged() reports the sound switched on again.
+      while (M5.Speaker.isPlaying(VARIO_AUDIO_CHANNEL))
+      {
+        vTaskDelay(waitTicks);
+      }
+      while (!soundEnabled())
+      {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      }
+    }
+  }
+}
@@ -0,0 +1,21 @@
+#ifndef VARIO_AUDIO_H
+#define VARIO_AUDIO_H
+
+#include <Arduino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void initVarioAudio();
+void varioAudioTask(void *pvParameters);
+// Takes effect with the next rendered block, at most VARIO_AUDIO_BLOCK_SAMPLES * VARIO_AUDIO_BUFFER_COUNT samples later
+void varioAudioSetVerticalSpeed(float verticalSpeed);
+// Call after changing globalSoundEnabled. While muted the task renders nothing and waits for this call.
+void varioAudioSoundChanged();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VARIO_AUDIO_H
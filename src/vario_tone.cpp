@@ -0,0 +1,131 @@
+#include "vario_tone.h"
+#include <math.h>
+
+static const int SINE_TABLE_BITS = 8;
+static int16_t sineTable[1 << SINE_TABLE_BITS];
+
+static uint32_t msToSamples(float ms, uint32_t sampleRate)
+{
+  uint32_t samples = (uint32_t)(ms * sampleRate / 1000.0f);
+  return samples > 0 ? samples : 1;
+}
+
+void VarioToneGenerator::begin(const VarioToneProfile &newProfile, uint32_t newSampleRate)
+{
+  profile = newProfile;
+  sampleRate = newSampleRate;
+  for (int i = 0; i < (1 << SINE_TABLE_BITS); ++i)
+  {
+    sineTable[i] = (int16_t)lroundf(32767.0f * sinf(2.0f * (float)M_PI * i / (1 << SINE_TABLE_BITS)));
+  }
+  glideAlpha = profile.glideMs > 0.0f ? 1.0f - expf(-1000.0f / (profile.glideMs * sampleRate)) : 1.0f;
+  gainStep = profile.rampMs > 0.0f ? 1000.0f / (profile.rampMs * sampleRate) : 1.0f;
+  phaseScale = 4294967296.0f / sampleRate;
+  frequency = targetFrequency = profile.climbBaseHz;
+  gain = 0.0f;
+  mode = MODE_QUIET;
+  cadencePosition = 0;
+  cadenceLength = msToSamples(profile.climbPeriodMs, sampleRate);
+}
+
+void VarioToneGenerator::setVerticalSpeed(float newVerticalSpeed)
+{
+  verticalSpeed = newVerticalSpeed;
+}
+
+void VarioToneGenerator::setEnabled(bool newEnabled)
+{
+  enabled = newEnabled;
+}
+
+void VarioToneGenerator::updateTarget()
+{
+  // The current profile holds until its exit threshold
+  float climbThreshold = mode == MODE_CLIMB ? profile.climbExitThreshold : profile.climbThreshold;
+  float sinkAlarmThreshold = mode == MODE_SINK_ALARM ? profile.sinkAlarmExitThreshold : profile.sinkAlarmThreshold;
+  float sinkThreshold = (mode == MODE_SINK || mode == MODE_SINK_ALARM) ? profile.sinkExitThreshold : profile.sinkThreshold;
+
+  Mode newMode = MODE_QUIET;
+  if (!enabled)
+  {
+    newMode = MODE_QUIET;
+  }
+  else if (verticalSpeed > climbThreshold)
+  {
+    newMode = MODE_CLIMB;
+  }
+  else if (verticalSpeed < sinkAlarmThreshold)
+  {
+    newMode = MODE_SINK_ALARM;
+  }
+  else if (verticalSpeed < -sinkThreshold)
+  {
+    newMode = MODE_SINK;
+  }
+  if (newMode != mode)
+  {
+    mode = newMode;
+    cadencePosition = 0; // Start a new beep at once instead of finishing the old period
+  }
+
+  if (cadencePosition == 0)
+  {
+    // The period is fixed for a whole cycle, so a changing climb rate cannot cut a beep short
+    float periodMs = profile.climbPeriodMs;
+    if (mode == MODE_CLIMB)
+    {
+      periodMs -= fmaxf(0.0f, verticalSpeed - profile.climbThreshold) * profile.climbPeriodMsPerMps;
+      periodMs = periodMs > profile.climbMinPeriodMs ? periodMs : profile.climbMinPeriodMs;
+    }
+    else if (mode == MODE_SINK_ALARM)
+    {
+      periodMs = profile.sinkAlarmPeriodMs;
+    }
+    cadenceLength = msToSamples(periodMs, sampleRate);
+  }
+
+  switch (mode)
+  {
+  case MODE_CLIMB:
+    targetFrequency = profile.climbBaseHz + verticalSpeed * profile.climbHzPerMps;
+    gateOpen = cadencePosition < cadenceLength * profile.climbDuty;
+    break;
+  case MODE_SINK:
+    targetFrequency = profile.sinkBaseHz + verticalSpeed * profile.sinkHzPerMps; // verticalSpeed < 0
+    targetFrequency = targetFrequency > profile.minHz ? targetFrequency : profile.minHz;
+    gateOpen = true;
+    break;
+  case MODE_SINK_ALARM:
+    targetFrequency = cadencePosition < cadenceLength / 2 ? profile.sinkAlarmHighHz : profile.sinkAlarmLowHz;
+    gateOpen = true;
+    break;
+  default:
+    gateOpen = false;
+    break;
+  }
+}
+
+void VarioToneGenerator::render(int16_t *samples, size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    updateTarget();
+    if (++cadencePosition >= cadenceLength)
+    {
+      cadencePosition = 0;
+    }
+
+    if (gain <= 0.0f)
+    {
+      frequency = targetFrequency; // A new tone starts at its pitch, only running tones glide
+    }
+    else
+    {
+      frequency += (targetFrequency - frequency) * glideAlpha;
+    }
+    gain = gateOpen ? fminf(1.0f, gain + gainStep) : fmaxf(0.0f, gain - gainStep);
+
+    phase += (uint32_t)(frequency * phaseScale);
+    samples[i] = (int16_t)(sineTable[phase >> (32 - SINE_TABLE_BITS)] * gain * profile.amplitude / 32767.0f);
+  }
+}
@@ -0,0 +1,82 @@
+#ifndef VARIO_TONE_H
+#define VARIO_TONE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// PCM generator of the variometer tone. Plain C++ without Arduino or FreeRTOS dependencies, so the output can be
+// rendered and inspected on a host. render() fills blocks of mono 16-bit samples; between blocks the vertical
+// speed can be changed and the pitch glides to the new frequency instead of stepping.
+//
+// Profiles:
+//   climb  (v >  climbThreshold): beeps, pitch and cadence rise with the climb rate
+//   quiet  (between the thresholds)
+//   sink   (v < -sinkThreshold): continuous tone, pitch falls with the sink rate
+//   alarm  (v <  sinkAlarmThreshold): two-tone siren that cannot be mistaken for the sink tone
+// A profile is left only past its exit threshold, a little inside the enter threshold, so noise around a threshold
+// cannot switch the tone on and off and restart the beep with every block.
+
+struct VarioToneProfile
+{
+  float climbThreshold;      // m/s
+  float climbExitThreshold;  // m/s, below climbThreshold
+  float climbBaseHz;
+  float climbHzPerMps;
+  float climbPeriodMs;       // Beep period at the threshold
+  float climbPeriodMsPerMps; // Period shortening per m/s of climb
+  float climbMinPeriodMs;
+  float climbDuty;           // Fraction of the period the beep is on
+  float sinkThreshold;       // m/s, positive
+  float sinkExitThreshold;   // m/s, positive, below sinkThreshold
+  float sinkBaseHz;
+  float sinkHzPerMps;
+  float minHz;
+  float sinkAlarmThreshold;  // m/s, negative
+  float sinkAlarmExitThreshold; // m/s, above sinkAlarmThreshold
+  float sinkAlarmHighHz;
+  float sinkAlarmLowHz;
+  float sinkAlarmPeriodMs;   // One high plus one low half
+  float glideMs;             // Time constant of the pitch glide
+  float rampMs;              // Fade in/out of every beep, avoids clicks
+  int16_t amplitude;
+};
+
+class VarioToneGenerator
+{
+public:
+  void begin(const VarioToneProfile &profile, uint32_t sampleRate);
+  void setVerticalSpeed(float verticalSpeed);
+  void setEnabled(bool enabled);
+  void render(int16_t *samples, size_t count);
+
+private:
+  // Pitch and gate of the current profile at the current position in the cadence
+  void updateTarget();
+
+  enum Mode
+  {
+    MODE_QUIET,
+    MODE_CLIMB,
+    MODE_SINK,
+    MODE_SINK_ALARM
+  };
+
+  VarioToneProfile profile;
+  uint32_t sampleRate = 16000;
+  float verticalSpeed = 0.0f;
+  bool enabled = true;
+  Mode mode = MODE_QUIET;
+
+  float frequency = 0.0f;       // Current, gliding
+  float targetFrequency = 0.0f;
+  float glideAlpha = 1.0f;      // Per-sample smoothing factor of the glide
+  float phaseScale = 0.0f;      // Phase increment per Hz
+  uint32_t phase = 0;           // Sine phase, full circle = 2^32
+  float gain = 0.0f;            // Envelope 0..1
+  float gainStep = 1.0f;        // Per-sample change of the envelope
+  bool gateOpen = false;
+  uint32_t cadencePosition = 0; // Samples into the current beep or siren period
+  uint32_t cadenceLength = 1;   // Samples of the current period, fixed until it ends
+};
+
+#endif // VARIO_TONE_H
@@ -1,45 +1,16 @@
 #include "variometer_task.h"
 #include <M5Unified.h>
-#include "sensor_task.h"     // For globalPressure and xSensorMutex
-#include "gui.h"             // For M5.Display functions and event group
-#include <freertos/semphr.h>
-#include <math.h> // For pow()
-#include <vector> // For std::vector
+#include "sensor_task.h"
+#include "telemetry.h"       // For sensorState and varioState
+#include "telemetry_bus.h"
+#include <math.h>
+#include "altitude_filter.h"
+#include "pressure_altitude.h"
+#include "vario_audio.h"
 #include "config.h" // Include configuration constants
 
-// Declare extern global variables from main.cpp
-extern float globalPressure;
-extern float globalTemperature; // Added for global temperature
-extern SemaphoreHandle_t xSensorMutex;
-extern bool globalSoundEnabled; // Declare global sound enable flag
-
-// Moving average filter variables
-static std::vector<float> altitudeBuffer;
-static size_t bufferIndex = 0;
-static bool bufferFull = false;
-
-
-// Global variables for variometer
-float globalAltitude_m = 0.0; // Current altitude in meters
-float globalVerticalSpeed_mps = 0.0; // Vertical speed in meters per second
-SemaphoreHandle_t xVariometerMutex;
-
-// Constants for altitude calculation (standard atmosphere)
-// P0 is now defined in config.h as STANDARD_SEA_LEVEL_PRESSURE_HPA
-// Function to convert pressure (hPa) to altitude (meters)
-float pressureToAltitude(float pressure_hPa) {
-    return ALTITUDE_CONSTANT_A * (1.0 - pow(pressure_hPa / STANDARD_SEA_LEVEL_PRESSURE_HPA, 1.0 / ALTITUDE_CONSTANT_B));
-}
-
 void initVariometerTask() {
-    xVariometerMutex = xSemaphoreCreateMutex();
-    if (xVariometerMutex == NULL) {
-        ESP_LOGE("Variometer", "Failed to create variometer mutex");
-    }
-    altitudeBuffer.reserve(ALTITUDE_FILTER_SIZE); // Pre-allocate memory
-    for (int i = 0; i < ALTITUDE_FILTER_SIZE; ++i) {
-        altitudeBuffer.push_back(0.0); // Initialize with zeros
-    }
+    initPressureAltitude(); // Table of the pressure to altitude kernel, QNH from config
     M5.Speaker.begin(); // Initialize the speaker
     M5.Speaker.setVolume(SPEAKER_DEFAULT_VOLUME); // Set a default volume (0-255)
     ESP_LOGI("Variometer", "Variometer task initialized. Speaker enabled.");
@@ -48,83 +19,58 @@ void initVariometerTask() {
 void variometerTask(void *pvParameters) {
     (void) pvParameters;
 
-    float previousAltitude = 0.0;
-    unsigned long previousMillis = millis();
-    const unsigned long updateIntervalMs = VARIOMETER_UPDATE_INTERVAL_MS; // Update every VARIOMETER_UPDATE_INTERVAL_MS
-    const float altitudeChangeThreshold_mps = ALTITUDE_CHANGE_THRESHOLD_MPS; // meters per second for tone trigger
-
-    // Initial altitude reading
-    // Initial altitude reading and fill buffer
-    if (xSemaphoreTake(xSensorMutex, portMAX_DELAY) == pdTRUE) {
-        float initialPressure = globalPressure;
-        xSemaphoreGive(xSensorMutex);
-        float initialAltitude = pressureToAltitude(initialPressure);
-        for (int i = 0; i < ALTITUDE_FILTER_SIZE; ++i) {
-            altitudeBuffer[i] = initialAltitude;
-        }
-        previousAltitude = initialAltitude; // Use initial altitude for the first comparison
-    }
+    // Every barometer sample advances the filter, GPS fixes correct altitude and barometer offset in between
+    int subscriber = telemetrySubscribe("Variometer", TOPIC_MASK(TOPIC_BARO) | TOPIC_MASK(TOPIC_GPS_FIX), VARIO_TELEMETRY_QUEUE_DEPTH);
+    AltitudeFilter filter;
+    bool initialized = false;
+    uint32_t filterUs = 0; // Time of the filter state: sample time of the last barometer sample or GPS fix applied
+    uint32_t lastOutputMs = 0;
+    uint32_t gpsAltitudeCount = 0; // altitudeCount of the last GPS altitude applied
 
     for (;;) {
-        unsigned long currentMillis = millis();
-        if (currentMillis - previousMillis >= updateIntervalMs) {
-            float currentPressure = 0;
-            if (xSemaphoreTake(xSensorMutex, portMAX_DELAY) == pdTRUE) {
-                currentPressure = globalPressure;
-                xSemaphoreGive(xSensorMutex);
-            }
-
-            float rawAltitude = pressureToAltitude(currentPressure);
-
-            // Add raw altitude to buffer
-            altitudeBuffer[bufferIndex] = rawAltitude;
-            bufferIndex = (bufferIndex + 1) % ALTITUDE_FILTER_SIZE;
-            if (bufferIndex == 0) { // Buffer has wrapped around at least once
-                bufferFull = true;
-            }
-
-            // Calculate averaged altitude
-            float averagedAltitude = 0.0;
-            int count = bufferFull ? ALTITUDE_FILTER_SIZE : bufferIndex;
-            for (int i = 0; i < count; ++i) {
-                averagedAltitude += altitudeBuffer[i];
-            }
-            averagedAltitude /= count;
-
-            float altitudeChange = averagedAltitude - previousAltitude;
-            float timeDeltaSeconds = (float)(currentMillis - previousMillis) / 1000.0;
-            float verticalSpeed = altitudeChange / timeDeltaSeconds; // meters per second
-
-            if (xSemaphoreTake(xVariometerMutex, portMAX_DELAY) == pdTRUE) {
-                globalAltitude_m = averagedAltitude;
-                globalVerticalSpeed_mps = verticalSpeed;
-                xSemaphoreGive(xVariometerMutex);
-                xEventGroupSetBits(xGuiUpdateEventGroup, GUI_EVENT_VARIO_DATA_READY); // Signal GUI task
-            }
+        TelemetryMessage message;
+        if (!telemetryReceive(subscriber, &message, portMAX_DELAY)) {
+            continue;
+        }
 
-            // Tone generation logic
-            if (SPEAKER_ENABLED && globalSoundEnabled) {
-                if (verticalSpeed > altitudeChangeThreshold_mps) {
-                    // Rising tone: higher frequency, frequency increases with climb rate
-                    int frequency = RISING_TONE_BASE_FREQ_HZ + (int)(verticalSpeed * RISING_TONE_MULTIPLIER_HZ_PER_MPS);
-                    M5.Speaker.tone(frequency, TONE_DURATION_MS); // Short tone
-                } else if (verticalSpeed < -altitudeChangeThreshold_mps) {
-                    // Sinking tone: lower frequency, frequency decreases with sink rate
-                    int frequency = SINKING_TONE_BASE_FREQ_HZ - (int)(fabs(verticalSpeed) * SINKING_TONE_MULTIPLIER_HZ_PER_MPS);
-                    if (frequency < MIN_TONE_FREQ_HZ) frequency = MIN_TONE_FREQ_HZ; // Minimum frequency
-                    M5.Speaker.tone(frequency, TONE_DURATION_MS); // Short tone
-                } else {
-                    // Stable or minor changes, no tone
-                    M5.Speaker.stop();
+        if (message.topic == TOPIC_GPS_FIX) {
+            // Only a new GGA measures the altitude; applying a repeated one would make the filter overconfident
+            if (initialized && message.gps.valid && !message.gps.testdata && message.gps.altitudeCount != gpsAltitudeCount) {
+                gpsAltitudeCount = message.gps.altitudeCount;
+                int32_t dtUs = (int32_t)(message.publishUs - filterUs); // Negative if the other core published first
+                if (dtUs > 0) {
+                    filter.predict(dtUs / 1000000.0f);
+                    filterUs = message.publishUs; // Filter time never moves backwards
                 }
-            } else {
-                M5.Speaker.stop(); // Ensure speaker is off if sound is disabled
+                filter.updateGps(message.gps.altitude);
             }
+            continue;
+        }
 
-            previousAltitude = averagedAltitude; // Update previous altitude with the averaged value
-            previousMillis = currentMillis;
+        float baroAltitude = pressureToAltitude(message.baro.pressure);
+        if (!initialized) {
+            filter.reset(baroAltitude);
+            filterUs = message.baro.sampleUs;
+            initialized = true;
+            continue;
+        }
+        // A GPS fix published during the conversion already moved the filter past the sample start
+        int32_t dtUs = (int32_t)(message.baro.sampleUs - filterUs);
+        if (dtUs > 0) {
+            filter.predict(dtUs / 1000000.0f);
+            filterUs = message.baro.sampleUs;
         }
+        filter.updateBaro(baroAltitude);
+        varioAudioSetVerticalSpeed(filter.verticalSpeed()); // Every sample, the tone reacts within one audio block
 
-        vTaskDelay(pdMS_TO_TICKS(VARIOMETER_TASK_DELAY_MS)); // Check more frequently than updateIntervalMs
+        // The barometer runs at up to 100 Hz; the display only needs a few updates per second
+        if (message.baro.updateMs - lastOutputMs < VARIOMETER_UPDATE_INTERVAL_MS) {
+            continue;
+        }
+        lastOutputMs = message.baro.updateMs;
+        VarioSnapshot vario = {filter.altitude(), filter.verticalSpeed(), message.baro.updateMs,
+                               filter.altitudeVariance(), filter.verticalSpeedVariance()};
+        varioState.write(vario);
+        telemetryPublish(vario);
     }
 }
@@ -0,0 +1,43 @@
+#ifndef TEST_SUPPORT_ARDUINO_H
+#define TEST_SUPPORT_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino core and ESP-IDF logging used by the natively built sources and
+// libraries (TinyGPSPlus)
+
+#include <chrono>
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#ifndef TWO_PI
+#define TWO_PI 6.283185307179586476925286766559
+#endif
+#define radians(deg) ((deg) * (TWO_PI / 360.0))
+#define degrees(rad) ((rad) * (360.0 / TWO_PI))
+#define sq(x) ((x) * (x))
+
+#define SERIAL_8N1 0x800001c
+
+#define ESP_LOGE(tag, format, ...) printf("E (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) printf("W (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) printf("I (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ((void)0)
+#define ESP_LOGV(tag, format, ...) ((void)0)
+
+inline unsigned long micros()
+{
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline unsigned long millis()
+{
+  return micros() / 1000;
+}
+
+#endif // TEST_SUPPORT_ARDUINO_H
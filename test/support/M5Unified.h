@@ -0,0 +1,14 @@
+#ifndef TEST_SUPPORT_M5UNIFIED_H
+#define TEST_SUPPORT_M5UNIFIED_H
+
+// Host stand-in for M5Unified: only what config.h and the natively built sources use, no display or speaker
+
+#include "Arduino.h"
+
+// RGB565 values of M5GFX
+#define TFT_WHITE 0xFFFF
+#define TFT_DARKGREY 0x7BEF
+#define TFT_DARKGREEN 0x03E0
+#define TFT_TRANSPARENT 0x0120
+
+#endif // TEST_SUPPORT_M5UNIFIED_H
@@ -0,0 +1,2 @@
+// Pre-1.0 Arduino name of Arduino.h, included by libraries built without ARDUINO defined
+#include "Arduino.h"
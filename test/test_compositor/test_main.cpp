@@ -0,0 +1,196 @@
+#include <unity.h>
+#include <stdio.h>
+#include <vector>
+#include "compositor_regions.h"
+
+// Region merging and composition of the compositor against memory buffers. The frame sequence replays what
+// compositor.cpp does: layers mark their area dirty before and after a move, frames alternate between two buffers,
+// and every composed buffer must equal a full redraw of the scene.
+
+static const int SCREEN_WIDTH_PX = 160;
+static const int SCREEN_HEIGHT_PX = 120;
+static const uint16_t BACKGROUND = 0x0000;
+static const int LAYER_COUNT = 4;
+static const int FRAMES = 500;
+
+struct TestLayer
+{
+  std::vector<uint16_t> pixels;
+  CompositorSurface surface;
+};
+
+static TestLayer layers[LAYER_COUNT];
+static CompositorSurface surfaces[LAYER_COUNT];
+
+static uint32_t nextRandom(uint32_t *state)
+{
+  *state = *state * 1103515245u + 12345u;
+  return *state >> 16;
+}
+
+static void makeLayer(int index, int width, int height, int x, int y)
+{
+  TestLayer &layer = layers[index];
+  layer.pixels.resize(width * height);
+  for (int i = 0; i < width * height; ++i)
+  {
+    layer.pixels[i] = (uint16_t)(0x1000 * (index + 1) + i); // Unique per layer and pixel
+  }
+  layer.surface = {layer.pixels.data(), width, height, x, y, true};
+}
+
+static void syncSurfaces()
+{
+  for (int i = 0; i < LAYER_COUNT; ++i)
+  {
+    surfaces[i] = layers[i].surface;
+  }
+}
+
+static void markLayer(CompositorDirtyList *dirty, int index)
+{
+  const CompositorSurface &surface = layers[index].surface;
+  compositorDirtyAdd(dirty, {surface.x, surface.y, surface.width, surface.height}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX);
+}
+
+static std::vector<uint16_t> fullRedraw()
+{
+  std::vector<uint16_t> screen(SCREEN_WIDTH_PX * SCREEN_HEIGHT_PX);
+  syncSurfaces();
+  compositorComposeRegion(screen.data(), SCREEN_WIDTH_PX, surfaces, LAYER_COUNT, {0, 0, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX}, BACKGROUND);
+  return screen;
+}
+
+void setUp()
+{
+  makeLayer(0, 140, 100, 10, 10); // Map
+  makeLayer(1, 80, 20, 0, 0);     // HUD widgets
+  makeLayer(2, 80, 20, 80, 0);
+  makeLayer(3, 30, 30, 120, 90);  // Partly off screen
+}
+
+void tearDown() {}
+
+void test_touching_rects_merge()
+{
+  CompositorDirtyList dirty = {};
+  compositorDirtyAdd(&dirty, {0, 0, 10, 10}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX);
+  compositorDirtyAdd(&dirty, {10, 0, 10, 10}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX); // Shares an edge
+  TEST_ASSERT_EQUAL_INT(1, dirty.count);
+  TEST_ASSERT_EQUAL_INT(20, dirty.rects[0].w);
+  compositorDirtyAdd(&dirty, {50, 50, 10, 10}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX);
+  TEST_ASSERT_EQUAL_INT(2, dirty.count);
+}
+
+void test_merge_repeats_until_stable()
+{
+  CompositorDirtyList dirty = {};
+  compositorDirtyAdd(&dirty, {0, 0, 10, 10}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX);
+  compositorDirtyAdd(&dirty, {30, 0, 10, 10}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX);
+  // Bridges both
+  compositorDirtyAdd(&dirty, {5, 5, 30, 2}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX);
+  TEST_ASSERT_EQUAL_INT(1, dirty.count);
+  TEST_ASSERT_EQUAL_INT(0, dirty.rects[0].x);
+  TEST_ASSERT_EQUAL_INT(40, dirty.rects[0].w);
+}
+
+void test_rects_clipped_to_screen()
+{
+  CompositorDirtyList dirty = {};
+  compositorDirtyAdd(&dirty, {-20, -20, 30, 30}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX);
+  TEST_ASSERT_EQUAL_INT(1, dirty.count);
+  TEST_ASSERT_EQUAL_INT(0, dirty.rects[0].x);
+  TEST_ASSERT_EQUAL_INT(10, dirty.rects[0].w);
+  compositorDirtyAdd(&dirty, {SCREEN_WIDTH_PX + 5, 0, 10, 10}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX);
+  TEST_ASSERT_EQUAL_INT(1, dirty.count);
+}
+
+void test_full_list_folds_into_one()
+{
+  CompositorDirtyList dirty = {};
+  for (int i = 0; i <= COMPOSITOR_MAX_DIRTY_RECTS; ++i)
+  {
+    compositorDirtyAdd(&dirty, {i * 12, (i % 2) * 50, 5, 5}, SCREEN_WIDTH_PX, SCREEN_HEIGHT_PX);
+  }
+  TEST_ASSERT_EQUAL_INT(1, dirty.count);
+  TEST_ASSERT_EQUAL_INT(0, dirty.rects[0].x);
+  TEST_ASSERT_EQUAL_INT(COMPOSITOR_MAX_DIRTY_RECTS * 12 + 5, dirty.rects[0].w);
+}
+
+void test_compose_layers_bottom_to_top()
+{
+  layers[2].surface.visible = false;
+  std::vector<uint16_t> screen = fullRedraw();
+  TEST_ASSERT_EQUAL_UINT32(layers[1].pixels[15 * 80 + 15], screen[15 * SCREEN_WIDTH_PX + 15]); // HUD over the map
+  TEST_ASSERT_EQUAL_UINT32(layers[0].pixels[5 * 140 + 90], screen[15 * SCREEN_WIDTH_PX + 100]); // Map under the hidden widget
+  TEST_ASSERT_EQUAL_UINT32(BACKGROUND, screen[115 * SCREEN_WIDTH_PX + 5]);                      // Nothing covers it
+  TEST_ASSERT_EQUAL_UINT32(layers[3].pixels[10 * 30 + 20], screen[100 * SCREEN_WIDTH_PX + 140]);  // Last layer on top
+}
+
+void test_double_buffered_frames_match_full_redraw()
+{
+  std::vector<uint16_t> buffers[2] = {fullRedraw(), fullRedraw()};
+  CompositorDirtyList dirty = {};
+  CompositorDirtyList previous = {};
+  uint32_t random = 99;
+  uint64_t composedPixels = 0;
+  int backBuffer = 0;
+  for (int frame = 0; frame < FRAMES; ++frame)
+  {
+    // Changes like the GUI makes them: move the map, toggle and redraw widgets
+    int changes = 1 + nextRandom(&random) % 3;
+    for (int change = 0; change < changes; ++change)
+    {
+      int index = nextRandom(&random) % LAYER_COUNT;
+      CompositorSurface &surface = layers[index].surface;
+      switch (nextRandom(&random) % 3)
+      {
+      case 0: // compositorSetLayerPosition()
+        markLayer(&dirty, index);
+        surface.x += (int)(nextRandom(&random) % 11) - 5;
+        surface.y += (int)(nextRandom(&random) % 11) - 5;
+        markLayer(&dirty, index);
+        break;
+      case 1: // compositorSetLayerVisible()
+        surface.visible = !surface.visible;
+        markLayer(&dirty, index);
+        break;
+      default: // Redrawn content, compositorMarkDirtyRect()
+        layers[index].pixels[nextRandom(&random) % layers[index].pixels.size()] ^= 0x5555;
+        markLayer(&dirty, index);
+        break;
+      }
+    }
+    if (dirty.count == 0)
+    {
+      continue; // Changes off screen only, compositorFlush() submits no frame
+    }
+    syncSurfaces();
+    for (int i = 0; i < dirty.count; ++i)
+    {
+      composedPixels += (uint64_t)dirty.rects[i].w * dirty.rects[i].h;
+    }
+    std::vector<uint16_t> &target = buffers[backBuffer];
+    backBuffer = 1 - backBuffer;
+    int regions = compositorComposeFrame(target.data(), SCREEN_WIDTH_PX, surfaces, LAYER_COUNT, &dirty, &previous, BACKGROUND);
+    TEST_ASSERT_EQUAL_INT(previous.count, regions);
+    TEST_ASSERT_EQUAL_INT(0, dirty.count);
+    TEST_ASSERT_TRUE_MESSAGE(target == fullRedraw(), "Composed frame differs from a full redraw");
+  }
+  printf("%.1f%% of the screen composed per frame on average\n",
+         100.0 * composedPixels / ((double)FRAMES * SCREEN_WIDTH_PX * SCREEN_HEIGHT_PX));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_touching_rects_merge);
+  RUN_TEST(test_merge_repeats_until_stable);
+  RUN_TEST(test_rects_clipped_to_screen);
+  RUN_TEST(test_full_list_folds_into_one);
+  RUN_TEST(test_compose_layers_bottom_to_top);
+  RUN_TEST(test_double_buffered_frames_match_full_redraw);
+  return UNITY_END();
+}
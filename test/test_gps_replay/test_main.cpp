@@ -0,0 +1,171 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include "nmea_parser.h"
+
+#ifndef TEST_FIXTURE_DIR
+#define TEST_FIXTURE_DIR "test/fixtures"
+#endif
+
+// Replay of the recorded 10 Hz log in the chunk sizes the GPS task hands to the parser: the UART driver returns
+// whatever arrived since the last read, from single bytes up to GPS_SERIAL_RX_CHUNK_SIZE (256)
+
+static const char GPS_LOG_PATH[] = TEST_FIXTURE_DIR "/gps_10hz.nmea";
+
+// Contents of gps_10hz.nmea, see tools/make_test_fixtures.py
+static const uint32_t LOG_EPOCHS = 301; // 1 Hz epoch at power-up, then 300 at 10 Hz
+static const uint32_t LOG_GGA = 301;
+static const uint32_t LOG_RMC = 301;
+static const uint32_t LOG_VTG = 1;
+static const uint32_t LOG_GSA = 1;
+static const uint32_t LOG_UNSUPPORTED = 6; // 2 TXT, GLL, 2 GSV, ZDA
+static const uint32_t LOG_CHECKSUM_ERRORS = 1;
+static const uint32_t LOG_MALFORMED = 1;
+static const double LOG_LAST_LONGITUDE = 7.440434 + 31.0 * 10.0 / 76000.0;
+static const double LOG_LAST_ALTITUDE = 1531.0;
+
+static std::string gpsLog;
+
+struct ReplayResult
+{
+  uint32_t callbacks;
+  uint32_t fixes;
+  uint32_t lastFixTime;
+  bool timeIncreasing;
+};
+
+static void countFix(NmeaSentenceType type, const NmeaFix &fix, bool epochComplete, void *context)
+{
+  (void)type;
+  ReplayResult *result = (ReplayResult *)context;
+  result->callbacks++;
+  if (epochComplete && fix.locationValid)
+  {
+    if (result->fixes > 0 && fix.time <= result->lastFixTime)
+    {
+      result->timeIncreasing = false;
+    }
+    result->fixes++;
+    result->lastFixTime = fix.time;
+  }
+}
+
+static void assertReplay(const NmeaParser &parser, const ReplayResult &result)
+{
+  const NmeaParserStats &stats = parser.stats();
+  TEST_ASSERT_EQUAL_UINT32(gpsLog.size(), stats.bytes);
+  TEST_ASSERT_EQUAL_UINT32(LOG_GGA, stats.sentences[NMEA_GGA].parsed);
+  TEST_ASSERT_EQUAL_UINT32(LOG_RMC, stats.sentences[NMEA_RMC].parsed);
+  TEST_ASSERT_EQUAL_UINT32(LOG_VTG, stats.sentences[NMEA_VTG].parsed);
+  TEST_ASSERT_EQUAL_UINT32(LOG_GSA, stats.sentences[NMEA_GSA].parsed);
+  TEST_ASSERT_EQUAL_UINT32(LOG_UNSUPPORTED, stats.unsupported);
+  TEST_ASSERT_EQUAL_UINT32(LOG_CHECKSUM_ERRORS, stats.checksumErrors);
+  TEST_ASSERT_EQUAL_UINT32(LOG_MALFORMED, stats.malformed);
+  TEST_ASSERT_EQUAL_UINT32(LOG_EPOCHS, stats.epochs);
+
+  TEST_ASSERT_EQUAL_UINT32(LOG_GGA + LOG_RMC + LOG_VTG + LOG_GSA, result.callbacks);
+  TEST_ASSERT_EQUAL_UINT32(LOG_EPOCHS, result.fixes);
+  TEST_ASSERT_TRUE(result.timeIncreasing);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-5, LOG_LAST_LONGITUDE, parser.fix().longitude);
+  TEST_ASSERT_DOUBLE_WITHIN(0.05, LOG_LAST_ALTITUDE, parser.fix().altitude);
+}
+
+static void replayInChunks(size_t chunkSize)
+{
+  NmeaParser parser;
+  ReplayResult result = {0, 0, 0, true};
+  for (size_t offset = 0; offset < gpsLog.size(); offset += chunkSize)
+  {
+    size_t length = gpsLog.size() - offset < chunkSize ? gpsLog.size() - offset : chunkSize;
+    parser.parse(gpsLog.data() + offset, length, countFix, &result);
+  }
+  assertReplay(parser, result);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fixture_present()
+{
+  TEST_ASSERT_TRUE_MESSAGE(gpsLog.size() > 0, "tools/make_test_fixtures.py writes test/fixtures/gps_10hz.nmea");
+}
+
+void test_replay_whole_log()
+{
+  replayInChunks(gpsLog.size());
+}
+
+void test_replay_single_bytes()
+{
+  replayInChunks(1);
+}
+
+void test_replay_odd_chunks()
+{
+  replayInChunks(7);
+}
+
+void test_replay_fifo_threshold_chunks()
+{
+  replayInChunks(120); // UART RX FIFO full threshold
+}
+
+void test_replay_rx_chunk_size()
+{
+  replayInChunks(256); // GPS_SERIAL_RX_CHUNK_SIZE
+}
+
+void test_replay_varying_chunks()
+{
+  // Reads at arbitrary moments cut sentences anywhere
+  NmeaParser parser;
+  ReplayResult result = {0, 0, 0, true};
+  uint32_t random = 12345;
+  size_t offset = 0;
+  while (offset < gpsLog.size())
+  {
+    random = random * 1103515245u + 12345u;
+    size_t length = 1 + (random >> 16) % 256;
+    length = gpsLog.size() - offset < length ? gpsLog.size() - offset : length;
+    parser.parse(gpsLog.data() + offset, length, countFix, &result);
+    offset += length;
+  }
+  assertReplay(parser, result);
+}
+
+static std::string readFile(const char *path)
+{
+  std::string data;
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr)
+  {
+    return data;
+  }
+  char buffer[4096];
+  size_t length;
+  while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    data.append(buffer, length);
+  }
+  fclose(file);
+  return data;
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  gpsLog = readFile(GPS_LOG_PATH);
+  UNITY_BEGIN();
+  RUN_TEST(test_fixture_present);
+  if (gpsLog.size() > 0)
+  {
+    RUN_TEST(test_replay_whole_log);
+    RUN_TEST(test_replay_single_bytes);
+    RUN_TEST(test_replay_odd_chunks);
+    RUN_TEST(test_replay_fifo_threshold_chunks);
+    RUN_TEST(test_replay_rx_chunk_size);
+    RUN_TEST(test_replay_varying_chunks);
+  }
+  return UNITY_END();
+}
@@ -0,0 +1,214 @@
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <TinyGPSPlus.h>
+#include "nmea_parser.h"
+
+#ifndef TEST_FIXTURE_DIR
+#define TEST_FIXTURE_DIR "test/fixtures"
+#endif
+
+static const char GPS_LOG_PATH[] = TEST_FIXTURE_DIR "/gps_10hz.nmea";
+static const int BENCHMARK_PASSES = 200;
+
+static std::string readFile(const char *path)
+{
+  std::string data;
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr)
+  {
+    return data;
+  }
+  char buffer[4096];
+  size_t length;
+  while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    data.append(buffer, length);
+  }
+  fclose(file);
+  return data;
+}
+
+static void parseString(NmeaParser &parser, const char *text, NmeaSentenceCallback callback = nullptr, void *context = nullptr)
+{
+  parser.parse(text, strlen(text), callback, context);
+}
+
+struct EpochCounter
+{
+  uint32_t sentences;
+  uint32_t fixes;
+};
+
+static void countEpochs(NmeaSentenceType type, const NmeaFix &fix, bool epochComplete, void *context)
+{
+  (void)type;
+  EpochCounter *counter = (EpochCounter *)context;
+  counter->sentences++;
+  if (epochComplete && fix.locationValid)
+  {
+    counter->fixes++;
+  }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_gga_fields()
+{
+  NmeaParser parser;
+  parseString(parser, "$GPGGA,123519.50,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*6C\r\n");
+  const NmeaFix &fix = parser.fix();
+  TEST_ASSERT_EQUAL_UINT32(1, parser.stats().sentences[NMEA_GGA].parsed);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, 48.1173, fix.latitude);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, 11.516666667, fix.longitude);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, 545.4, fix.altitude);
+  TEST_ASSERT_EQUAL_UINT32(1, fix.altitudeCount);
+  TEST_ASSERT_EQUAL_UINT32(12351950, fix.time);
+  TEST_ASSERT_EQUAL_UINT8(1, fix.quality);
+  TEST_ASSERT_EQUAL_UINT8(8, fix.satellites);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.9f, fix.hdop);
+  TEST_ASSERT_TRUE(fix.locationValid);
+}
+
+void test_rmc_fields_any_talker()
+{
+  NmeaParser parser;
+  parseString(parser, "$GNRMC,123519.00,A,4807.038,S,01131.000,W,022.4,084.4,230394,003.1,W*55\r\n");
+  const NmeaFix &fix = parser.fix();
+  TEST_ASSERT_EQUAL_UINT32(1, parser.stats().sentences[NMEA_RMC].parsed);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, -48.1173, fix.latitude);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, -11.516666667, fix.longitude);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, 22.4 * 1.852, fix.speedKmph);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, 84.4, fix.courseDeg);
+  TEST_ASSERT_EQUAL_UINT32(230394, fix.date);
+  TEST_ASSERT_TRUE(fix.locationValid);
+}
+
+void test_void_rmc_invalidates_location()
+{
+  NmeaParser parser;
+  parseString(parser, "$GNRMC,123519.00,A,4807.038,S,01131.000,W,022.4,084.4,230394,003.1,W*55\r\n");
+  parseString(parser, "$GPRMC,123520.00,V,,,,,,,230394,,,N*75\r\n");
+  TEST_ASSERT_EQUAL_UINT32(2, parser.stats().sentences[NMEA_RMC].parsed);
+  TEST_ASSERT_FALSE(parser.fix().locationValid);
+}
+
+void test_vtg_and_gsa_fields()
+{
+  NmeaParser parser;
+  parseString(parser, "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n");
+  parseString(parser, "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\r\n");
+  const NmeaFix &fix = parser.fix();
+  TEST_ASSERT_EQUAL_UINT32(1, parser.stats().sentences[NMEA_VTG].parsed);
+  TEST_ASSERT_EQUAL_UINT32(1, parser.stats().sentences[NMEA_GSA].parsed);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, 10.2, fix.speedKmph);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, 54.7, fix.courseDeg);
+  TEST_ASSERT_EQUAL_UINT8(3, fix.fixMode);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.5f, fix.pdop);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.3f, fix.hdop);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.1f, fix.vdop);
+}
+
+void test_checksum_error_rejected()
+{
+  NmeaParser parser;
+  // Last checksum digit off by one
+  parseString(parser, "$GPGGA,123519.50,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*6D\r\n");
+  TEST_ASSERT_EQUAL_UINT32(0, parser.stats().sentences[NMEA_GGA].parsed);
+  TEST_ASSERT_EQUAL_UINT32(1, parser.stats().sentences[NMEA_GGA].checksumErrors);
+  TEST_ASSERT_EQUAL_UINT32(1, parser.stats().checksumErrors);
+  TEST_ASSERT_FALSE(parser.fix().locationValid);
+}
+
+void test_one_fix_per_epoch()
+{
+  NmeaParser parser;
+  EpochCounter counter = {};
+  // GGA and RMC of one epoch, then the next epoch in the opposite order
+  parseString(parser, "$GNGGA,120000.00,4656.8558,N,00726.4260,E,1,12,0.8,1500.0,M,48.0,M,,*40\r\n", countEpochs, &counter);
+  TEST_ASSERT_EQUAL_UINT32(0, counter.fixes);
+  parseString(parser, "$GNRMC,120000.00,A,4656.8558,N,00726.4260,E,19.44,90.00,161026,,,A*42\r\n", countEpochs, &counter);
+  TEST_ASSERT_EQUAL_UINT32(1, counter.fixes);
+  parseString(parser, "$GNRMC,120000.10,A,4656.8558,N,00726.4268,E,19.44,90.00,161026,,,A*4B\r\n", countEpochs, &counter);
+  parseString(parser, "$GNGGA,120000.10,4656.8558,N,00726.4268,E,1,12,0.8,1500.1,M,48.0,M,,*48\r\n", countEpochs, &counter);
+  TEST_ASSERT_EQUAL_UINT32(4, counter.sentences);
+  TEST_ASSERT_EQUAL_UINT32(2, counter.fixes);
+  TEST_ASSERT_EQUAL_UINT32(2, parser.stats().epochs);
+}
+
+void test_rmc_only_receiver_completes_every_epoch()
+{
+  NmeaParser parser;
+  EpochCounter counter = {};
+  parseString(parser, "$GNRMC,120000.00,A,4656.8558,N,00726.4260,E,19.44,90.00,161026,,,A*42\r\n", countEpochs, &counter);
+  parseString(parser, "$GNRMC,120000.10,A,4656.8558,N,00726.4268,E,19.44,90.00,161026,,,A*4B\r\n", countEpochs, &counter);
+  parseString(parser, "$GNRMC,120000.20,A,4656.8558,N,00726.4276,E,19.44,90.00,161026,,,A*47\r\n", countEpochs, &counter);
+  // The first epoch is only known to be complete when the second one starts
+  TEST_ASSERT_EQUAL_UINT32(2, counter.fixes);
+  TEST_ASSERT_EQUAL_UINT32(3, counter.sentences);
+}
+
+void test_benchmark_against_tinygpsplus()
+{
+  std::string log = readFile(GPS_LOG_PATH);
+  TEST_ASSERT_TRUE_MESSAGE(log.size() > 0, "tools/make_test_fixtures.py writes test/fixtures/gps_10hz.nmea");
+
+  NmeaParser reference;
+  reference.parse(log.data(), log.size());
+  TinyGPSPlus tinyReference;
+  for (char c : log)
+  {
+    tinyReference.encode(c);
+  }
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, tinyReference.location.lat(), reference.fix().latitude);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, tinyReference.location.lng(), reference.fix().longitude);
+  TEST_ASSERT_DOUBLE_WITHIN(1e-6, tinyReference.altitude.meters(), reference.fix().altitude);
+  TEST_ASSERT_EQUAL_UINT32(tinyReference.failedChecksum(), reference.stats().checksumErrors);
+
+  uint32_t checksum = 0; // Keeps the loops from being optimized away
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+  {
+    NmeaParser parser;
+    parser.parse(log.data(), log.size());
+    checksum += parser.stats().epochs;
+  }
+  double nmeaNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+  {
+    TinyGPSPlus tinyGps;
+    for (char c : log)
+    {
+      tinyGps.encode(c);
+    }
+    checksum += tinyGps.passedChecksum();
+  }
+  double tinyNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  double bytes = (double)log.size() * BENCHMARK_PASSES;
+  printf("%u bytes x %d passes (checksum %u)\n", (unsigned)log.size(), BENCHMARK_PASSES, (unsigned)checksum);
+  printf("NmeaParser  %.2f ns/byte\n", nmeaNs / bytes);
+  printf("TinyGPSPlus %.2f ns/byte (%.1fx)\n", tinyNs / bytes, tinyNs / nmeaNs);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_gga_fields);
+  RUN_TEST(test_rmc_fields_any_talker);
+  RUN_TEST(test_void_rmc_invalidates_location);
+  RUN_TEST(test_vtg_and_gsa_fields);
+  RUN_TEST(test_checksum_error_rejected);
+  RUN_TEST(test_one_fix_per_epoch);
+  RUN_TEST(test_rmc_only_receiver_completes_every_epoch);
+  RUN_TEST(test_benchmark_against_tinygpsplus);
+  return UNITY_END();
+}
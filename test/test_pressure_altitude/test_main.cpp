@@ -0,0 +1,144 @@
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <M5Unified.h>
+#include "config.h"
+#include "pressure_altitude.h"
+
+// Accuracy of the cubic table against the double precision formula, and its speed against pow() and powf()
+
+static const float TABLE_MAX_HPA = PRESSURE_ALTITUDE_MIN_HPA + PRESSURE_ALTITUDE_SEGMENTS * PRESSURE_ALTITUDE_STEP_HPA;
+static const double MAX_ERROR_M = 0.01; // The barometer resolves about 10 cm
+static const int BENCHMARK_SAMPLES = 1024;
+static const int BENCHMARK_PASSES = 2000;
+
+static double referenceAltitude(double pressureHpa, double qnhHpa)
+{
+  return ALTITUDE_CONSTANT_A * (1.0 - pow(pressureHpa / qnhHpa, 1.0 / ALTITUDE_CONSTANT_B));
+}
+
+static float pressureToAltitudePowf(float pressureHpa, float qnhHpa)
+{
+  return ALTITUDE_CONSTANT_A * (1.0f - powf(pressureHpa / qnhHpa, 1.0f / ALTITUDE_CONSTANT_B));
+}
+
+void setUp()
+{
+  initPressureAltitude();
+}
+
+void tearDown() {}
+
+void test_table_error_below_a_centimetre()
+{
+  const float qnhValues[] = {VARIO_QNH_HPA, 950.0f, 1050.0f};
+  for (float qnh : qnhValues)
+  {
+    setPressureAltitudeQnh(qnh);
+    TEST_ASSERT_EQUAL_FLOAT(qnh, getPressureAltitudeQnh());
+    double maxTableError = 0.0;
+    double maxPowfError = 0.0;
+    float worstPressure = PRESSURE_ALTITUDE_MIN_HPA;
+    // Fine sweep over the whole table, segment borders included
+    for (int step = 0; PRESSURE_ALTITUDE_MIN_HPA + step * 0.01f < TABLE_MAX_HPA; ++step)
+    {
+      float p = PRESSURE_ALTITUDE_MIN_HPA + step * 0.01f;
+      double reference = referenceAltitude(p, qnh);
+      double tableError = fabs(pressureToAltitude(p) - reference);
+      if (tableError > maxTableError)
+      {
+        maxTableError = tableError;
+        worstPressure = p;
+      }
+      maxPowfError = fmax(maxPowfError, fabs(pressureToAltitudePowf(p, qnh) - reference));
+    }
+    printf("QNH %.2f hPa: max error table %.2f cm (at %.2f hPa), powf %.2f cm\n",
+           qnh, maxTableError * 100.0, worstPressure, maxPowfError * 100.0);
+    TEST_ASSERT_LESS_THAN(MAX_ERROR_M, maxTableError);
+  }
+}
+
+void test_exact_formula_outside_table()
+{
+  setPressureAltitudeQnh(1013.25f);
+  const float outside[] = {100.0f, PRESSURE_ALTITUDE_MIN_HPA - 0.01f, TABLE_MAX_HPA, 1200.0f};
+  for (float p : outside)
+  {
+    TEST_ASSERT_EQUAL_FLOAT(pressureToAltitudeExact(p, 1013.25f), pressureToAltitude(p));
+  }
+  TEST_ASSERT_TRUE(isnan(pressureToAltitude(NAN)));
+}
+
+void test_standard_atmosphere_points()
+{
+  setPressureAltitudeQnh(1013.25f);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, pressureToAltitude(1013.25f));
+  // 1500 m and 3000 m of the standard atmosphere
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 1500.0f, pressureToAltitude(845.56f));
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 3000.0f, pressureToAltitude(701.12f));
+  // A higher QNH puts the same pressure higher
+  setPressureAltitudeQnh(1020.0f);
+  TEST_ASSERT_GREATER_THAN(1500.0f, pressureToAltitude(845.56f));
+}
+
+void test_benchmark_against_pow()
+{
+  // The same pressures through each kernel, like a long recording of samples
+  static float pressures[BENCHMARK_SAMPLES];
+  for (int i = 0; i < BENCHMARK_SAMPLES; ++i)
+  {
+    pressures[i] = PRESSURE_ALTITUDE_MIN_HPA + (TABLE_MAX_HPA - PRESSURE_ALTITUDE_MIN_HPA) * i / BENCHMARK_SAMPLES;
+  }
+  const float qnh = getPressureAltitudeQnh();
+  volatile float sink = 0.0f; // Keeps the loops from being optimized away
+  float sum = 0.0f;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+  {
+    for (int i = 0; i < BENCHMARK_SAMPLES; ++i)
+    {
+      sum += pressureToAltitudeExact(pressures[i], qnh);
+    }
+  }
+  double exactNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+  {
+    for (int i = 0; i < BENCHMARK_SAMPLES; ++i)
+    {
+      sum += pressureToAltitudePowf(pressures[i], qnh);
+    }
+  }
+  double powfNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+  {
+    for (int i = 0; i < BENCHMARK_SAMPLES; ++i)
+    {
+      sum += pressureToAltitude(pressures[i]);
+    }
+  }
+  double tableNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  sink = sum;
+  (void)sink;
+
+  const double samples = (double)BENCHMARK_SAMPLES * BENCHMARK_PASSES;
+  printf("pow %.1f ns/sample, powf %.1f ns/sample, table %.1f ns/sample (%.1fx faster than pow)\n",
+         exactNs / samples, powfNs / samples, tableNs / samples, exactNs / tableNs);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_table_error_below_a_centimetre);
+  RUN_TEST(test_exact_formula_outside_table);
+  RUN_TEST(test_standard_atmosphere_points);
+  RUN_TEST(test_benchmark_against_pow);
+  return UNITY_END();
+}
@@ -0,0 +1,330 @@
+#include <unity.h>
+#include <chrono>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <jpeglib.h>
+#include "baseline_jpeg.h"
+
+#ifndef TEST_FIXTURE_DIR
+#define TEST_FIXTURE_DIR "test/fixtures"
+#endif
+
+// Compares the baseline_jpeg.cpp backend with libjpeg on map style tiles: pixel agreement and decode time.
+// The M5GFX decoder of the firmware does not build on the host, libjpeg is the yardstick here. The sample set is
+// rendered and encoded by the test; JPEG tiles copied to test/fixtures/tiles are decoded and timed as well.
+
+static const char TILE_DIR[] = TEST_FIXTURE_DIR "/tiles";
+static const int TILE_SIZE = 256;
+static const int BENCHMARK_PASSES = 20;
+static const int MAX_CHANNEL_DIFFERENCE = 1; // In RGB565 steps, rounding of the IDCT and the color conversion
+
+struct SampleTile
+{
+  std::string name;
+  std::vector<uint8_t> jpeg;
+  int width;
+  int height;
+};
+
+static std::vector<SampleTile> samples;
+
+static uint32_t nextRandom(uint32_t *state)
+{
+  *state = *state * 1103515245u + 12345u;
+  return *state >> 16;
+}
+
+static void fillRect(std::vector<uint8_t> &rgb, int x0, int y0, int x1, int y1, uint8_t r, uint8_t g, uint8_t b)
+{
+  for (int y = y0 < 0 ? 0 : y0; y < y1 && y < TILE_SIZE; ++y)
+  {
+    for (int x = x0 < 0 ? 0 : x0; x < x1 && x < TILE_SIZE; ++x)
+    {
+      uint8_t *pixel = &rgb[(y * TILE_SIZE + x) * 3];
+      pixel[0] = r;
+      pixel[1] = g;
+      pixel[2] = b;
+    }
+  }
+}
+
+// Flat areas, forest and water, a cased road, contour lines and label-like glyphs on a paper background
+static std::vector<uint8_t> renderMapTile(uint32_t seed)
+{
+  std::vector<uint8_t> rgb(TILE_SIZE * TILE_SIZE * 3);
+  uint32_t random = seed;
+  fillRect(rgb, 0, 0, TILE_SIZE, TILE_SIZE, 242, 239, 233);
+  for (int i = 0; i < 4; ++i)
+  {
+    int x = nextRandom(&random) % TILE_SIZE;
+    int y = nextRandom(&random) % TILE_SIZE;
+    fillRect(rgb, x, y, x + 40 + nextRandom(&random) % 80, y + 30 + nextRandom(&random) % 60, 200, 224, 180);
+  }
+  int lake = nextRandom(&random) % 160;
+  fillRect(rgb, lake, 180, lake + 70, 230, 170, 211, 223);
+  for (int y = 0; y < TILE_SIZE; y += 16)
+  {
+    int phase = nextRandom(&random) % 32;
+    for (int x = 0; x < TILE_SIZE; ++x)
+    {
+      int contourY = y + (((x + phase) % 32) < 16 ? ((x + phase) % 32) / 4 : (32 - (x + phase) % 32) / 4);
+      fillRect(rgb, x, contourY, x + 1, contourY + 1, 190, 150, 110);
+    }
+  }
+  for (int x = 0; x < TILE_SIZE; ++x)
+  {
+    int roadY = 60 + x / 3;
+    fillRect(rgb, x, roadY - 4, x + 1, roadY + 4, 140, 140, 140);
+    fillRect(rgb, x, roadY - 2, x + 1, roadY + 2, 255, 255, 255);
+  }
+  for (int i = 0; i < 30; ++i)
+  {
+    int x = 20 + nextRandom(&random) % 200;
+    int y = 20 + nextRandom(&random) % 200;
+    fillRect(rgb, x, y, x + 2 + nextRandom(&random) % 5, y + 7, 40, 40, 40);
+  }
+  return rgb;
+}
+
+static std::vector<uint8_t> encodeJpeg(const std::vector<uint8_t> &rgb, int quality, int lumaH, int lumaV, bool grayscale,
+                                       int restartRows, bool progressive)
+{
+  jpeg_compress_struct compress;
+  jpeg_error_mgr error;
+  compress.err = jpeg_std_error(&error);
+  jpeg_create_compress(&compress);
+  unsigned char *buffer = nullptr;
+  unsigned long size = 0;
+  jpeg_mem_dest(&compress, &buffer, &size);
+  compress.image_width = TILE_SIZE;
+  compress.image_height = TILE_SIZE;
+  compress.input_components = 3;
+  compress.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&compress);
+  jpeg_set_quality(&compress, quality, TRUE);
+  if (grayscale)
+  {
+    jpeg_set_colorspace(&compress, JCS_GRAYSCALE);
+  }
+  else
+  {
+    compress.comp_info[0].h_samp_factor = lumaH;
+    compress.comp_info[0].v_samp_factor = lumaV;
+  }
+  compress.restart_in_rows = restartRows;
+  if (progressive)
+  {
+    jpeg_simple_progression(&compress);
+  }
+  jpeg_start_compress(&compress, TRUE);
+  while (compress.next_scanline < compress.image_height)
+  {
+    JSAMPROW row = (JSAMPROW)&rgb[compress.next_scanline * TILE_SIZE * 3];
+    jpeg_write_scanlines(&compress, &row, 1);
+  }
+  jpeg_finish_compress(&compress);
+  std::vector<uint8_t> jpeg(buffer, buffer + size);
+  jpeg_destroy_compress(&compress);
+  free(buffer);
+  return jpeg;
+}
+
+// Reference: libjpeg with the same integer IDCT and replicated chroma, packed like the tile cache
+static void decodeWithLibjpeg(const std::vector<uint8_t> &jpeg, std::vector<uint16_t> *pixels)
+{
+  jpeg_decompress_struct decompress;
+  jpeg_error_mgr error;
+  decompress.err = jpeg_std_error(&error);
+  jpeg_create_decompress(&decompress);
+  jpeg_mem_src(&decompress, jpeg.data(), jpeg.size());
+  jpeg_read_header(&decompress, TRUE);
+  decompress.out_color_space = JCS_RGB;
+  decompress.dct_method = JDCT_ISLOW;
+  decompress.do_fancy_upsampling = FALSE;
+  jpeg_start_decompress(&decompress);
+  int width = decompress.output_width;
+  pixels->resize((size_t)width * decompress.output_height);
+  std::vector<uint8_t> row(width * 3);
+  while (decompress.output_scanline < decompress.output_height)
+  {
+    uint16_t *out = pixels->data() + (size_t)decompress.output_scanline * width;
+    JSAMPROW rowPointer = row.data();
+    jpeg_read_scanlines(&decompress, &rowPointer, 1);
+    for (int x = 0; x < width; ++x)
+    {
+      uint16_t color = (uint16_t)(((row[x * 3] & 0xF8) << 8) | ((row[x * 3 + 1] & 0xFC) << 3) | (row[x * 3 + 2] >> 3));
+      out[x] = (uint16_t)((color >> 8) | (color << 8));
+    }
+  }
+  jpeg_finish_decompress(&decompress);
+  jpeg_destroy_decompress(&decompress);
+}
+
+static int channelDifference(uint16_t a, uint16_t b)
+{
+  a = (uint16_t)((a >> 8) | (a << 8));
+  b = (uint16_t)((b >> 8) | (b << 8));
+  int red = abs((a >> 11) - (b >> 11));
+  int green = abs(((a >> 5) & 0x3F) - ((b >> 5) & 0x3F));
+  int blue = abs((a & 0x1F) - (b & 0x1F));
+  return red > green ? (red > blue ? red : blue) : (green > blue ? green : blue);
+}
+
+static std::vector<uint8_t> readFile(const std::string &path)
+{
+  std::vector<uint8_t> data;
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr)
+  {
+    return data;
+  }
+  uint8_t buffer[4096];
+  size_t length;
+  while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    data.insert(data.end(), buffer, buffer + length);
+  }
+  fclose(file);
+  return data;
+}
+
+static void addSample(const std::string &name, const std::vector<uint8_t> &jpeg)
+{
+  BaselineJpegInfo info;
+  if (!baselineJpegInfo(jpeg.data(), jpeg.size(), &info))
+  {
+    printf("%s: not a baseline JPEG, the firmware decodes it with M5GFX\n", name.c_str());
+    return;
+  }
+  samples.push_back({name, jpeg, info.width, info.height});
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_matches_libjpeg()
+{
+  for (const SampleTile &sample : samples)
+  {
+    std::vector<uint16_t> decoded((size_t)sample.width * sample.height);
+    std::vector<uint16_t> reference;
+    TEST_ASSERT_TRUE_MESSAGE(baselineJpegDecode(sample.jpeg.data(), sample.jpeg.size(), decoded.data(), sample.width, sample.height),
+                             sample.name.c_str());
+    decodeWithLibjpeg(sample.jpeg, &reference);
+    int maxDifference = 0;
+    size_t differing = 0;
+    for (size_t i = 0; i < decoded.size(); ++i)
+    {
+      int difference = channelDifference(decoded[i], reference[i]);
+      maxDifference = difference > maxDifference ? difference : maxDifference;
+      differing += difference > 0 ? 1 : 0;
+    }
+    printf("%s: max difference %d, %.2f%% of the pixels differ\n", sample.name.c_str(), maxDifference, 100.0 * differing / decoded.size());
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(MAX_CHANNEL_DIFFERENCE, maxDifference, sample.name.c_str());
+  }
+}
+
+void test_rejects_progressive()
+{
+  std::vector<uint8_t> jpeg = encodeJpeg(renderMapTile(1), 75, 2, 2, false, 0, true);
+  BaselineJpegInfo info;
+  TEST_ASSERT_FALSE(baselineJpegInfo(jpeg.data(), jpeg.size(), &info));
+  std::vector<uint16_t> pixels(TILE_SIZE * TILE_SIZE);
+  TEST_ASSERT_FALSE(baselineJpegDecode(jpeg.data(), jpeg.size(), pixels.data(), TILE_SIZE, TILE_SIZE));
+}
+
+void test_rejects_other_size()
+{
+  const SampleTile &sample = samples.front();
+  std::vector<uint16_t> pixels(TILE_SIZE * TILE_SIZE);
+  TEST_ASSERT_FALSE(baselineJpegDecode(sample.jpeg.data(), sample.jpeg.size(), pixels.data(), TILE_SIZE / 2, TILE_SIZE * 2));
+}
+
+void test_corrupt_data_stays_in_bounds()
+{
+  const SampleTile &sample = samples.front();
+  const uint16_t guard = 0xA5A5;
+  std::vector<uint16_t> pixels(TILE_SIZE * TILE_SIZE + 2, guard);
+  // Truncated in the middle of the scan, then with flipped bytes
+  std::vector<uint8_t> jpeg(sample.jpeg.begin(), sample.jpeg.begin() + sample.jpeg.size() / 2);
+  baselineJpegDecode(jpeg.data(), jpeg.size(), pixels.data() + 1, TILE_SIZE, TILE_SIZE);
+  jpeg = sample.jpeg;
+  uint32_t random = 7;
+  for (int i = 0; i < 50; ++i)
+  {
+    jpeg[jpeg.size() / 4 + nextRandom(&random) % (jpeg.size() / 2)] ^= 0xFF;
+  }
+  baselineJpegDecode(jpeg.data(), jpeg.size(), pixels.data() + 1, TILE_SIZE, TILE_SIZE);
+  TEST_ASSERT_EQUAL_HEX16(guard, pixels.front());
+  TEST_ASSERT_EQUAL_HEX16(guard, pixels.back());
+}
+
+void test_benchmark_against_libjpeg()
+{
+  uint32_t checksum = 0; // Keeps the decodes from being optimized away
+  double baselineUs = 0.0;
+  double libjpegUs = 0.0;
+  for (const SampleTile &sample : samples)
+  {
+    std::vector<uint16_t> pixels((size_t)sample.width * sample.height);
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+    {
+      baselineJpegDecode(sample.jpeg.data(), sample.jpeg.size(), pixels.data(), sample.width, sample.height);
+      checksum += pixels[pass];
+    }
+    double sampleBaselineUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / BENCHMARK_PASSES;
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+    {
+      decodeWithLibjpeg(sample.jpeg, &pixels);
+      checksum += pixels[pass];
+    }
+    double sampleLibjpegUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / BENCHMARK_PASSES;
+    printf("%-24s %6u bytes  SW JPEG %7.1f us  libjpeg %7.1f us\n", sample.name.c_str(), (unsigned)sample.jpeg.size(),
+           sampleBaselineUs, sampleLibjpegUs);
+    baselineUs += sampleBaselineUs;
+    libjpegUs += sampleLibjpegUs;
+  }
+  printf("Average per tile: SW JPEG %.1f us, libjpeg %.1f us (%.2fx, checksum %u)\n", baselineUs / samples.size(),
+         libjpegUs / samples.size(), libjpegUs / baselineUs, (unsigned)checksum);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  addSample("map 4:2:0 q75", encodeJpeg(renderMapTile(1), 75, 2, 2, false, 0, false));
+  addSample("map 4:2:0 q90", encodeJpeg(renderMapTile(2), 90, 2, 2, false, 0, false));
+  addSample("map 4:2:2 q80", encodeJpeg(renderMapTile(3), 80, 2, 1, false, 0, false));
+  addSample("map 4:4:4 q90", encodeJpeg(renderMapTile(4), 90, 1, 1, false, 0, false));
+  addSample("map 4:2:0 restarts", encodeJpeg(renderMapTile(5), 75, 2, 2, false, 1, false));
+  addSample("map grayscale q80", encodeJpeg(renderMapTile(6), 80, 1, 1, true, 0, false));
+  DIR *directory = opendir(TILE_DIR);
+  if (directory != nullptr)
+  {
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != nullptr)
+    {
+      std::string name = entry->d_name;
+      if (name.size() > 4 && (name.compare(name.size() - 4, 4, ".jpg") == 0 || name.compare(name.size() - 4, 4, ".JPG") == 0))
+      {
+        addSample(name, readFile(std::string(TILE_DIR) + "/" + name));
+      }
+    }
+    closedir(directory);
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(test_matches_libjpeg);
+  RUN_TEST(test_rejects_progressive);
+  RUN_TEST(test_rejects_other_size);
+  RUN_TEST(test_corrupt_data_stays_in_bounds);
+  RUN_TEST(test_benchmark_against_libjpeg);
+  return UNITY_END();
+}
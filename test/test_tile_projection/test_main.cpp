@@ -0,0 +1,167 @@
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <M5Unified.h>
+#include "config.h"
+#include "tile_calculator.h"
+
+// projectLatLng() and projectLatLngBatch() against the separate functions they replaced, for agreement and speed
+
+static const int BENCHMARK_POINTS = 20000;
+static const int BENCHMARK_PASSES = 20;
+
+// Previous implementation: every function computed pow(), tan(), cos() and log() on its own
+static void projectLatLngSeparately(double lat, double lng, int zoom, TileProjection *projection)
+{
+  double lat_rad = lat * M_PI / 180.0;
+  double n = pow(2.0, zoom);
+  projection->tileX = (int)floor((lng + 180.0) / 360.0 * n);
+  projection->tileY = (int)floor((1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * n);
+
+  lat_rad = lat * M_PI / 180.0;
+  n = pow(2.0, zoom);
+  double tileX_double = (lng + 180.0) / 360.0 * n;
+  double tileY_double = (1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * n;
+  projection->pixelOffsetX = (int)((tileX_double - floor(tileX_double)) * TILE_SIZE);
+  projection->pixelOffsetY = (int)((tileY_double - floor(tileY_double)) * TILE_SIZE);
+
+  lat_rad = lat * M_PI / 180.0;
+  n = pow(2.0, zoom);
+  projection->globalPixelX = (long)floor(((lng + 180.0) / 360.0 * n) * TILE_SIZE);
+  projection->globalPixelY = (long)floor(((1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * n) * TILE_SIZE);
+}
+
+static std::vector<double> trackLat;
+static std::vector<double> trackLng;
+
+void setUp() {}
+void tearDown() {}
+
+void test_projection_matches_separate_functions()
+{
+  // Rounding may move a point across a pixel border, never further
+  for (int zoom = MIN_ZOOM_LEVEL; zoom <= MAX_ZOOM_LEVEL; ++zoom)
+  {
+    int differences = 0;
+    for (int i = 0; i < BENCHMARK_POINTS; i += 7)
+    {
+      TileProjection before;
+      TileProjection after;
+      projectLatLngSeparately(trackLat[i], trackLng[i], zoom, &before);
+      projectLatLng(trackLat[i], trackLng[i], zoom, &after);
+      if (labs(before.globalPixelX - after.globalPixelX) > 1 || labs(before.globalPixelY - after.globalPixelY) > 1)
+      {
+        differences++;
+      }
+      // Tile and offset always describe the same global pixel
+      TEST_ASSERT_EQUAL(after.globalPixelX, (long)after.tileX * TILE_SIZE + after.pixelOffsetX);
+      TEST_ASSERT_EQUAL(after.globalPixelY, (long)after.tileY * TILE_SIZE + after.pixelOffsetY);
+      TEST_ASSERT_TRUE(after.pixelOffsetX >= 0 && after.pixelOffsetX < TILE_SIZE);
+      TEST_ASSERT_TRUE(after.pixelOffsetY >= 0 && after.pixelOffsetY < TILE_SIZE);
+    }
+    TEST_ASSERT_EQUAL_INT(0, differences);
+  }
+}
+
+void test_wrappers_and_batch_agree()
+{
+  const int count = 256;
+  TileProjection batch[count];
+  projectLatLngBatch(trackLat.data(), trackLng.data(), count, DEFAULT_MAP_ZOOM_LEVEL, batch);
+  for (int i = 0; i < count; ++i)
+  {
+    TileProjection single;
+    projectLatLng(trackLat[i], trackLng[i], DEFAULT_MAP_ZOOM_LEVEL, &single);
+    int tileX, tileY, offsetX, offsetY;
+    long globalX, globalY;
+    latLngToTile(trackLat[i], trackLng[i], DEFAULT_MAP_ZOOM_LEVEL, &tileX, &tileY);
+    latLngToPixelOffset(trackLat[i], trackLng[i], DEFAULT_MAP_ZOOM_LEVEL, &offsetX, &offsetY);
+    latLngToGlobalPixel(trackLat[i], trackLng[i], DEFAULT_MAP_ZOOM_LEVEL, &globalX, &globalY);
+    TEST_ASSERT_EQUAL(single.globalPixelX, batch[i].globalPixelX);
+    TEST_ASSERT_EQUAL(single.globalPixelY, batch[i].globalPixelY);
+    TEST_ASSERT_EQUAL_INT(single.tileX, tileX);
+    TEST_ASSERT_EQUAL_INT(single.tileY, tileY);
+    TEST_ASSERT_EQUAL_INT(single.pixelOffsetX, offsetX);
+    TEST_ASSERT_EQUAL_INT(single.pixelOffsetY, offsetY);
+    TEST_ASSERT_EQUAL(single.globalPixelX, globalX);
+    TEST_ASSERT_EQUAL(single.globalPixelY, globalY);
+  }
+}
+
+void test_pixel_round_trip()
+{
+  TileProjection projection;
+  projectLatLng(46.947597, 7.440434, DEFAULT_MAP_ZOOM_LEVEL, &projection);
+  double lat, lng;
+  pixelToLatLng((int)projection.globalPixelX, (int)projection.globalPixelY, DEFAULT_MAP_ZOOM_LEVEL, &lat, &lng);
+  // The corner of the pixel, less than a pixel (about 3 m at zoom 15) from the point
+  TEST_ASSERT_DOUBLE_WITHIN(0.0001, 46.947597, lat);
+  TEST_ASSERT_DOUBLE_WITHIN(0.0001, 7.440434, lng);
+}
+
+void test_benchmark_against_separate_functions()
+{
+  std::vector<TileProjection> projections(BENCHMARK_POINTS);
+  const int zoom = DEFAULT_MAP_ZOOM_LEVEL;
+  long checksum = 0; // Keeps the loops from being optimized away
+
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+  {
+    for (int i = 0; i < BENCHMARK_POINTS; ++i)
+    {
+      projectLatLngSeparately(trackLat[i], trackLng[i], zoom, &projections[i]);
+      checksum += projections[i].globalPixelX;
+    }
+  }
+  double separateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+  {
+    for (int i = 0; i < BENCHMARK_POINTS; ++i)
+    {
+      projectLatLng(trackLat[i], trackLng[i], zoom, &projections[i]);
+      checksum += projections[i].globalPixelX;
+    }
+  }
+  double singleNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+  {
+    projectLatLngBatch(trackLat.data(), trackLng.data(), BENCHMARK_POINTS, zoom, projections.data());
+    for (int i = 0; i < BENCHMARK_POINTS; ++i)
+    {
+      checksum += projections[i].globalPixelX;
+    }
+  }
+  double batchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  const double points = (double)BENCHMARK_POINTS * BENCHMARK_PASSES;
+  printf("%d points x %d passes at zoom %d (checksum %ld)\n", BENCHMARK_POINTS, BENCHMARK_PASSES, zoom, checksum);
+  printf("Separate functions %.0f points/s, projectLatLng %.0f points/s (%.1fx), projectLatLngBatch %.0f points/s (%.1fx)\n",
+         points * 1e9 / separateNs, points * 1e9 / singleNs, separateNs / singleNs, points * 1e9 / batchNs, separateNs / batchNs);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  initTileCalculator();
+  // A wandering track of about 50 km around Bern, like a long flight log
+  for (int i = 0; i < BENCHMARK_POINTS; ++i)
+  {
+    trackLat.push_back(46.95 + 0.2 * sin(i * 0.0013) + 0.01 * sin(i * 0.07));
+    trackLng.push_back(7.45 + 0.3 * cos(i * 0.0011) + 0.01 * cos(i * 0.05));
+  }
+  UNITY_BEGIN();
+  RUN_TEST(test_projection_matches_separate_functions);
+  RUN_TEST(test_wrappers_and_batch_agree);
+  RUN_TEST(test_pixel_round_trip);
+  RUN_TEST(test_benchmark_against_separate_functions);
+  return UNITY_END();
+}
@@ -0,0 +1,237 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <M5Unified.h>
+#include "config.h" // ALTITUDE_FILTER_SIZE
+#include "altitude_filter.h"
+#include "pressure_altitude.h"
+
+#ifndef TEST_FIXTURE_DIR
+#define TEST_FIXTURE_DIR "test/fixtures"
+#endif
+
+// Replay of a recorded flight through the previous variometer and the fusion filter. The previous task read the
+// latest pressure every BASELINE_INTERVAL_MS, averaged the last ALTITUDE_FILTER_SIZE of those readings (2 s) and held
+// the vertical speed until the next reading. Lag and noise of both are measured against a zero-lag reference, the
+// centered difference of the raw barometric altitude, which is only possible offline.
+
+static const char FLIGHT_PATH[] = TEST_FIXTURE_DIR "/vario_flight.csv";
+static const int REFERENCE_HALF_WINDOW = 25;       // Samples on each side of the centered difference, 1 s keeps its noise low
+static const int MAX_LAG_SAMPLES = 100;            // 2 s at 50 Hz
+static const uint32_t BASELINE_INTERVAL_MS = 200;  // Update interval of the previous variometer task
+static const float FLIGHT_BARO_OFFSET_M = -54.0f; // QNH 1020 hPa of the fixture against VARIO_QNH_HPA, at 1500 m
+
+struct Flight
+{
+  std::vector<uint32_t> timeMs;
+  std::vector<float> baroAltitude;
+  std::vector<float> gpsAltitude; // NAN without a GPS fix on that sample
+};
+
+struct LagNoise
+{
+  uint32_t lagMs;
+  double errorRms; // Against the reference at zero shift, m/s
+  double noiseRms; // Left at the best shift, m/s
+};
+
+static Flight flight;
+static std::vector<float> reference;
+
+// One barometer sample per line: "time_ms,pressure_hPa[,gps_altitude_m]"
+static bool loadFlight(const char *path, Flight *loaded)
+{
+  FILE *file = fopen(path, "r");
+  if (file == nullptr)
+  {
+    return false;
+  }
+  char line[64];
+  while (fgets(line, sizeof(line), file) != nullptr)
+  {
+    unsigned long ms;
+    float pressure;
+    float gps;
+    int fields = sscanf(line, "%lu,%f,%f", &ms, &pressure, &gps);
+    if (fields >= 2)
+    {
+      loaded->timeMs.push_back(ms);
+      loaded->baroAltitude.push_back(pressureToAltitude(pressure));
+      loaded->gpsAltitude.push_back(fields == 3 ? gps : NAN);
+    }
+  }
+  fclose(file);
+  return !loaded->timeMs.empty();
+}
+
+// The lag is the shift with the smallest RMS error against the reference, the noise the RMS error left at that shift
+static LagNoise compareWithReference(const char *name, const std::vector<float> &speed)
+{
+  int count = (int)speed.size();
+  int bestShift = 0;
+  double bestRms = INFINITY;
+  double zeroShiftRms = 0.0;
+  for (int shift = 0; shift <= MAX_LAG_SAMPLES && shift < count; ++shift)
+  {
+    double sum = 0.0;
+    int used = 0;
+    for (int i = 0; i + shift < count; ++i)
+    {
+      if (isnan(reference[i]))
+      {
+        continue;
+      }
+      double error = speed[i + shift] - reference[i];
+      sum += error * error;
+      used++;
+    }
+    double rms = used > 0 ? sqrt(sum / used) : INFINITY;
+    if (shift == 0)
+    {
+      zeroShiftRms = rms;
+    }
+    if (rms < bestRms)
+    {
+      bestRms = rms;
+      bestShift = shift;
+    }
+  }
+  // Shift times the average sample spacing
+  LagNoise result;
+  result.lagMs = count > 1 ? (uint32_t)((uint64_t)bestShift * (flight.timeMs[count - 1] - flight.timeMs[0]) / (count - 1)) : 0;
+  result.errorRms = zeroShiftRms;
+  result.noiseRms = bestRms;
+  printf("%s: lag %u ms, error %.3f m/s, noise %.3f m/s\n", name, (unsigned)result.lagMs, result.errorRms, result.noiseRms);
+  return result;
+}
+
+// The previous task on the barometer sample grid: a new reading every BASELINE_INTERVAL_MS, held in between
+static std::vector<float> movingAverageSpeed()
+{
+  int count = (int)flight.timeMs.size();
+  std::vector<float> speed(count);
+  float window[ALTITUDE_FILTER_SIZE];
+  for (int j = 0; j < ALTITUDE_FILTER_SIZE; ++j)
+  {
+    window[j] = flight.baroAltitude[0]; // The task filled the buffer with the first reading
+  }
+  int windowIndex = 0;
+  float previousAverage = flight.baroAltitude[0];
+  uint32_t previousMs = flight.timeMs[0];
+  float verticalSpeed = 0.0f;
+  for (int i = 0; i < count; ++i)
+  {
+    if (flight.timeMs[i] - previousMs >= BASELINE_INTERVAL_MS)
+    {
+      window[windowIndex] = flight.baroAltitude[i];
+      windowIndex = (windowIndex + 1) % ALTITUDE_FILTER_SIZE;
+      float average = 0.0f;
+      for (int j = 0; j < ALTITUDE_FILTER_SIZE; ++j)
+      {
+        average += window[j];
+      }
+      average /= ALTITUDE_FILTER_SIZE;
+      verticalSpeed = (average - previousAverage) / ((flight.timeMs[i] - previousMs) / 1000.0f);
+      previousAverage = average;
+      previousMs = flight.timeMs[i];
+    }
+    speed[i] = verticalSpeed;
+  }
+  return speed;
+}
+
+// Fed like variometerTask(): predict to the sample time, then the GPS altitude if there is one, then the barometer
+static std::vector<float> fusedSpeed(AltitudeFilter *filter, bool withGps)
+{
+  int count = (int)flight.timeMs.size();
+  std::vector<float> speed(count);
+  for (int i = 0; i < count; ++i)
+  {
+    if (i == 0)
+    {
+      filter->reset(flight.baroAltitude[0]);
+    }
+    else
+    {
+      filter->predict((flight.timeMs[i] - flight.timeMs[i - 1]) / 1000.0f);
+      if (withGps && !isnan(flight.gpsAltitude[i]))
+      {
+        filter->updateGps(flight.gpsAltitude[i]);
+      }
+      filter->updateBaro(flight.baroAltitude[i]);
+    }
+    speed[i] = filter->verticalSpeed();
+  }
+  return speed;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fusion_filter_beats_moving_average()
+{
+  LagNoise average = compareWithReference("Moving average", movingAverageSpeed());
+  AltitudeFilter filter;
+  LagNoise fused = compareWithReference("Fusion filter", fusedSpeed(&filter, true));
+
+  TEST_ASSERT_LESS_THAN_UINT32(average.lagMs, fused.lagMs);
+  TEST_ASSERT_LESS_THAN_FLOAT(average.noiseRms, fused.noiseRms);
+  TEST_ASSERT_LESS_THAN_FLOAT(average.errorRms, fused.errorRms);
+}
+
+void test_gps_finds_barometer_offset()
+{
+  AltitudeFilter filter;
+  fusedSpeed(&filter, true);
+  printf("Barometer offset %.1f m\n", filter.baroOffset());
+  TEST_ASSERT_FLOAT_WITHIN(3.0f, FLIGHT_BARO_OFFSET_M, filter.baroOffset());
+  // Altitude is the GPS reference, not the barometric altitude of the wrong QNH
+  TEST_ASSERT_FLOAT_WITHIN(3.0f, flight.baroAltitude.back() - FLIGHT_BARO_OFFSET_M, filter.altitude());
+}
+
+void test_filter_without_gps_follows_barometer()
+{
+  AltitudeFilter filter;
+  fusedSpeed(&filter, false);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 0.0f, filter.baroOffset());
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, flight.baroAltitude.back(), filter.altitude());
+}
+
+void test_replay_time_per_sample()
+{
+  int count = (int)flight.timeMs.size();
+  AltitudeFilter filter;
+  unsigned long startUs = micros();
+  fusedSpeed(&filter, true);
+  unsigned long elapsedUs = micros() - startUs;
+  printf("Fusion filter %.3f us per sample on the host\n", (double)elapsedUs / count);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  initPressureAltitude();
+  bool loaded = loadFlight(FLIGHT_PATH, &flight);
+  UNITY_BEGIN();
+  if (!loaded)
+  {
+    TEST_MESSAGE("tools/make_test_fixtures.py writes test/fixtures/vario_flight.csv");
+    UNITY_END();
+    return 1;
+  }
+  // Zero-lag reference of the whole replay
+  int count = (int)flight.timeMs.size();
+  reference.assign(count, NAN);
+  for (int i = REFERENCE_HALF_WINDOW; i + REFERENCE_HALF_WINDOW < count; ++i)
+  {
+    reference[i] = (flight.baroAltitude[i + REFERENCE_HALF_WINDOW] - flight.baroAltitude[i - REFERENCE_HALF_WINDOW]) /
+                   ((flight.timeMs[i + REFERENCE_HALF_WINDOW] - flight.timeMs[i - REFERENCE_HALF_WINDOW]) / 1000.0f);
+  }
+  RUN_TEST(test_fusion_filter_beats_moving_average);
+  RUN_TEST(test_gps_finds_barometer_offset);
+  RUN_TEST(test_filter_without_gps_follows_barometer);
+  RUN_TEST(test_replay_time_per_sample);
+  return UNITY_END();
+}
@@ -0,0 +1,357 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <M5Unified.h>
+#include "config.h"
+#include "vario_tone.h"
+
+// The tone generator rendered on the host in the blocks varioAudioTask() streams, with the profile of initVarioAudio()
+
+static const uint32_t SAMPLE_RATE = VARIO_AUDIO_SAMPLE_RATE;
+static const int BLOCK = VARIO_AUDIO_BLOCK_SAMPLES;
+static const int WINDOW = SAMPLE_RATE / 500; // 2 ms, long enough to contain a peak of the lowest tone
+static const float ON_LEVEL = VARIO_TONE_AMPLITUDE / 4.0f;
+
+static VarioToneProfile makeProfile()
+{
+  VarioToneProfile profile;
+  profile.climbThreshold = ALTITUDE_CHANGE_THRESHOLD_MPS;
+  profile.climbExitThreshold = ALTITUDE_CHANGE_THRESHOLD_MPS - VARIO_TONE_HYSTERESIS_MPS;
+  profile.climbBaseHz = RISING_TONE_BASE_FREQ_HZ;
+  profile.climbHzPerMps = RISING_TONE_MULTIPLIER_HZ_PER_MPS;
+  profile.climbPeriodMs = VARIO_CLIMB_PERIOD_MS;
+  profile.climbPeriodMsPerMps = VARIO_CLIMB_PERIOD_MS_PER_MPS;
+  profile.climbMinPeriodMs = VARIO_CLIMB_MIN_PERIOD_MS;
+  profile.climbDuty = VARIO_CLIMB_DUTY;
+  profile.sinkThreshold = ALTITUDE_CHANGE_THRESHOLD_MPS;
+  profile.sinkExitThreshold = ALTITUDE_CHANGE_THRESHOLD_MPS - VARIO_TONE_HYSTERESIS_MPS;
+  profile.sinkBaseHz = SINKING_TONE_BASE_FREQ_HZ;
+  profile.sinkHzPerMps = SINKING_TONE_MULTIPLIER_HZ_PER_MPS;
+  profile.minHz = MIN_TONE_FREQ_HZ;
+  profile.sinkAlarmThreshold = VARIO_SINK_ALARM_THRESHOLD_MPS;
+  profile.sinkAlarmExitThreshold = VARIO_SINK_ALARM_THRESHOLD_MPS + VARIO_TONE_HYSTERESIS_MPS;
+  profile.sinkAlarmHighHz = VARIO_SINK_ALARM_HIGH_HZ;
+  profile.sinkAlarmLowHz = VARIO_SINK_ALARM_LOW_HZ;
+  profile.sinkAlarmPeriodMs = VARIO_SINK_ALARM_PERIOD_MS;
+  profile.glideMs = VARIO_TONE_GLIDE_MS;
+  profile.rampMs = VARIO_TONE_RAMP_MS;
+  profile.amplitude = VARIO_TONE_AMPLITUDE;
+  return profile;
+}
+
+static VarioToneGenerator generator;
+
+// Render ms milliseconds in blocks, the vertical speed of every block from speedOfBlock
+static void render(std::vector<int16_t> *out, int ms, float (*speedOfBlock)(int block))
+{
+  int blocks = ms * (int)SAMPLE_RATE / 1000 / BLOCK;
+  for (int block = 0; block < blocks; ++block)
+  {
+    generator.setVerticalSpeed(speedOfBlock(block));
+    size_t start = out->size();
+    out->resize(start + BLOCK);
+    generator.render(out->data() + start, BLOCK);
+  }
+}
+
+static void render(std::vector<int16_t> *out, int ms, float verticalSpeed)
+{
+  generator.setVerticalSpeed(verticalSpeed);
+  int blocks = ms * (int)SAMPLE_RATE / 1000 / BLOCK;
+  size_t start = out->size();
+  out->resize(start + (size_t)blocks * BLOCK);
+  for (int block = 0; block < blocks; ++block)
+  {
+    generator.render(out->data() + start + (size_t)block * BLOCK, BLOCK);
+  }
+}
+
+static bool windowOn(const std::vector<int16_t> &samples, size_t window)
+{
+  int peak = 0;
+  for (size_t i = window * WINDOW; i < (window + 1) * WINDOW && i < samples.size(); ++i)
+  {
+    peak = abs(samples[i]) > peak ? abs(samples[i]) : peak;
+  }
+  return peak > ON_LEVEL;
+}
+
+// Start times (ms) of the beeps
+static std::vector<float> beepStarts(const std::vector<int16_t> &samples)
+{
+  std::vector<float> starts;
+  bool wasOn = false;
+  for (size_t window = 0; window < samples.size() / WINDOW; ++window)
+  {
+    bool on = windowOn(samples, window);
+    if (on && !wasOn)
+    {
+      starts.push_back(window * WINDOW * 1000.0f / SAMPLE_RATE);
+    }
+    wasOn = on;
+  }
+  return starts;
+}
+
+static float onFraction(const std::vector<int16_t> &samples, size_t fromSample)
+{
+  size_t on = 0;
+  size_t windows = 0;
+  for (size_t window = fromSample / WINDOW; window < samples.size() / WINDOW; ++window)
+  {
+    on += windowOn(samples, window) ? 1 : 0;
+    windows++;
+  }
+  return windows > 0 ? (float)on / windows : 0.0f;
+}
+
+// Frequency of every full cycle from upward zero crossings, interpolated between samples
+struct Cycle
+{
+  float timeMs; // Middle of the cycle
+  float hz;
+};
+
+static std::vector<Cycle> cycles(const std::vector<int16_t> &samples, size_t from, size_t to)
+{
+  std::vector<Cycle> result;
+  float previousCrossing = -1.0f;
+  for (size_t i = from + 1; i < to && i < samples.size(); ++i)
+  {
+    if (samples[i - 1] < 0 && samples[i] >= 0)
+    {
+      float crossing = (i - 1) + (float)-samples[i - 1] / (samples[i] - samples[i - 1]);
+      if (previousCrossing >= 0.0f)
+      {
+        Cycle cycle = {(crossing + previousCrossing) / 2.0f * 1000.0f / SAMPLE_RATE, SAMPLE_RATE / (crossing - previousCrossing)};
+        result.push_back(cycle);
+      }
+      previousCrossing = crossing;
+    }
+  }
+  return result;
+}
+
+static float averageHz(const std::vector<int16_t> &samples, size_t from, size_t to)
+{
+  std::vector<Cycle> measured = cycles(samples, from, to);
+  float sum = 0.0f;
+  for (const Cycle &cycle : measured)
+  {
+    sum += cycle.hz;
+  }
+  return measured.empty() ? 0.0f : sum / measured.size();
+}
+
+static size_t msToSample(float ms)
+{
+  return (size_t)(ms * SAMPLE_RATE / 1000.0f);
+}
+
+// Largest step between neighbouring samples
+static int largestStep(const std::vector<int16_t> &samples)
+{
+  int largest = 0;
+  for (size_t i = 1; i < samples.size(); ++i)
+  {
+    int step = abs(samples[i] - samples[i - 1]);
+    largest = step > largest ? step : largest;
+  }
+  return largest;
+}
+
+// A sine of amplitude A at f Hz changes by at most A * 2 pi f / rate between samples, plus A * 2 pi / 256 for the
+// steps of the sine table of the generator; a click is a jump towards A
+static float maxSineStep(float hz)
+{
+  return VARIO_TONE_AMPLITUDE * 2.0f * (float)M_PI * (hz / SAMPLE_RATE + 1.0f / 256);
+}
+
+void setUp()
+{
+  generator.begin(makeProfile(), SAMPLE_RATE);
+  generator.setEnabled(true);
+}
+
+void tearDown() {}
+
+void test_quiet_between_thresholds()
+{
+  std::vector<int16_t> samples;
+  render(&samples, 1000, 0.3f);
+  render(&samples, 1000, -0.3f);
+  TEST_ASSERT_EQUAL_INT(0, largestStep(samples));
+}
+
+void test_disabled_is_silent()
+{
+  std::vector<int16_t> samples;
+  generator.setEnabled(false);
+  render(&samples, 1000, 3.0f);
+  render(&samples, 1000, -6.0f);
+  TEST_ASSERT_EQUAL_INT(0, largestStep(samples));
+}
+
+void test_climb_beeps_faster_and_higher()
+{
+  const float rates[] = {1.0f, 2.0f, 4.0f};
+  for (float rate : rates)
+  {
+    setUp();
+    std::vector<int16_t> samples;
+    render(&samples, 3000, rate);
+    std::vector<float> starts = beepStarts(samples);
+    float expectedPeriodMs = VARIO_CLIMB_PERIOD_MS - (rate - ALTITUDE_CHANGE_THRESHOLD_MPS) * VARIO_CLIMB_PERIOD_MS_PER_MPS;
+    expectedPeriodMs = expectedPeriodMs > VARIO_CLIMB_MIN_PERIOD_MS ? expectedPeriodMs : VARIO_CLIMB_MIN_PERIOD_MS;
+    TEST_ASSERT_GREATER_OR_EQUAL(3, (int)starts.size());
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 0.0f, starts[0]); // The first beep starts at once
+    for (size_t i = 1; i < starts.size(); ++i)
+    {
+      TEST_ASSERT_FLOAT_WITHIN(2.5f, expectedPeriodMs, starts[i] - starts[i - 1]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, VARIO_CLIMB_DUTY, onFraction(samples, 0));
+    float expectedHz = RISING_TONE_BASE_FREQ_HZ + rate * RISING_TONE_MULTIPLIER_HZ_PER_MPS;
+    TEST_ASSERT_FLOAT_WITHIN(expectedHz * 0.01f, expectedHz, averageHz(samples, msToSample(10), msToSample(expectedPeriodMs * VARIO_CLIMB_DUTY - 10)));
+  }
+}
+
+void test_sink_is_continuous_and_falls()
+{
+  const float rates[] = {-1.0f, -3.0f};
+  for (float rate : rates)
+  {
+    setUp();
+    std::vector<int16_t> samples;
+    render(&samples, 1000, rate);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, onFraction(samples, msToSample(10)));
+    float expectedHz = SINKING_TONE_BASE_FREQ_HZ + rate * SINKING_TONE_MULTIPLIER_HZ_PER_MPS;
+    TEST_ASSERT_FLOAT_WITHIN(expectedHz * 0.01f, expectedHz, averageHz(samples, msToSample(10), samples.size()));
+  }
+}
+
+void test_sink_alarm_siren()
+{
+  std::vector<int16_t> samples;
+  render(&samples, 2000, VARIO_SINK_ALARM_THRESHOLD_MPS - 1.0f);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, onFraction(samples, msToSample(10)));
+  // High and low half of every period, measured away from the glide after each change
+  const float halfMs = VARIO_SINK_ALARM_PERIOD_MS / 2.0f;
+  for (int half = 0; half < 8; ++half)
+  {
+    float startMs = half * halfMs;
+    float expectedHz = half % 2 == 0 ? VARIO_SINK_ALARM_HIGH_HZ : VARIO_SINK_ALARM_LOW_HZ;
+    float hz = averageHz(samples, msToSample(startMs + 8 * VARIO_TONE_GLIDE_MS / 2), msToSample(startMs + halfMs));
+    TEST_ASSERT_FLOAT_WITHIN(expectedHz * 0.01f, expectedHz, hz);
+  }
+}
+
+void test_no_clicks_at_gate_edges_and_mode_changes()
+{
+  // Fast beeps, then every mode change in both directions, switched at block boundaries like the task does
+  std::vector<int16_t> samples;
+  render(&samples, 3000, [](int block) {
+    static const float speeds[] = {4.0f, 0.0f, -2.0f, -6.0f, -2.0f, 3.0f, -6.0f, 0.0f, 1.0f};
+    return speeds[(block / 40) % 9]; // A new speed every 320 ms
+  });
+  int step = largestStep(samples);
+  printf("Largest step %d, a sine at the highest pitch %.0f\n", step, maxSineStep(VARIO_SINK_ALARM_HIGH_HZ));
+  TEST_ASSERT_LESS_OR_EQUAL(maxSineStep(VARIO_SINK_ALARM_HIGH_HZ), (float)step);
+
+  // A beep ramps in and out over VARIO_TONE_RAMP_MS instead of starting at full amplitude
+  setUp();
+  std::vector<int16_t> beep;
+  render(&beep, 100, 2.0f);
+  int rampSamples = (int)msToSample(VARIO_TONE_RAMP_MS);
+  int peakAtStart = 0;
+  for (int i = 0; i < rampSamples / 4; ++i)
+  {
+    peakAtStart = abs(beep[i]) > peakAtStart ? abs(beep[i]) : peakAtStart;
+  }
+  TEST_ASSERT_LESS_OR_EQUAL(VARIO_TONE_AMPLITUDE / 4 + 1, peakAtStart);
+}
+
+void test_glide_time_constant()
+{
+  // A running sink tone changes pitch: it approaches the new pitch exponentially with VARIO_TONE_GLIDE_MS
+  const float fromRate = -1.0f;
+  const float toRate = -3.0f;
+  const float fromHz = SINKING_TONE_BASE_FREQ_HZ + fromRate * SINKING_TONE_MULTIPLIER_HZ_PER_MPS;
+  const float toHz = SINKING_TONE_BASE_FREQ_HZ + toRate * SINKING_TONE_MULTIPLIER_HZ_PER_MPS;
+  std::vector<int16_t> samples;
+  render(&samples, 200, fromRate);
+  size_t changeSample = samples.size();
+  render(&samples, 200, toRate);
+
+  float changeMs = changeSample * 1000.0f / SAMPLE_RATE;
+  float oneTimeConstantHz = toHz + (fromHz - toHz) / (float)M_E;
+  float crossedMs = -1.0f;
+  for (const Cycle &cycle : cycles(samples, changeSample, samples.size()))
+  {
+    float t = cycle.timeMs - changeMs;
+    if (t > 3.0f * VARIO_TONE_GLIDE_MS)
+    {
+      TEST_ASSERT_FLOAT_WITHIN(4.0f, toHz + (fromHz - toHz) * expf(-t / VARIO_TONE_GLIDE_MS), cycle.hz);
+    }
+    if (crossedMs < 0.0f && cycle.hz < oneTimeConstantHz)
+    {
+      crossedMs = t;
+    }
+  }
+  printf("Pitch 1/e of the way from %.0f to %.0f Hz after %.1f ms\n", fromHz, toHz, crossedMs);
+  TEST_ASSERT_FLOAT_WITHIN(0.15f * VARIO_TONE_GLIDE_MS, VARIO_TONE_GLIDE_MS, crossedMs);
+}
+
+void test_noise_at_climb_threshold_keeps_cadence()
+{
+  // Vertical speed jumping around the climb threshold every block
+  std::vector<int16_t> samples;
+  render(&samples, 3000, [](int block) {
+    return block % 2 == 0 ? ALTITUDE_CHANGE_THRESHOLD_MPS + 0.1f : ALTITUDE_CHANGE_THRESHOLD_MPS - 0.1f;
+  });
+  std::vector<float> starts = beepStarts(samples);
+  // Beeps of the period at the threshold, not one per block pair
+  TEST_ASSERT_GREATER_OR_EQUAL(4, (int)starts.size());
+  TEST_ASSERT_LESS_OR_EQUAL(6, (int)starts.size());
+  for (size_t i = 1; i < starts.size(); ++i)
+  {
+    TEST_ASSERT_FLOAT_WITHIN(20.0f, VARIO_CLIMB_PERIOD_MS, starts[i] - starts[i - 1]);
+  }
+}
+
+void test_noise_below_climb_threshold_stays_quiet()
+{
+  std::vector<int16_t> samples;
+  render(&samples, 3000, [](int block) {
+    return block % 2 == 0 ? ALTITUDE_CHANGE_THRESHOLD_MPS - 0.05f : ALTITUDE_CHANGE_THRESHOLD_MPS - 0.15f;
+  });
+  TEST_ASSERT_EQUAL_INT(0, largestStep(samples));
+}
+
+void test_noise_at_sink_threshold_keeps_tone()
+{
+  std::vector<int16_t> samples;
+  render(&samples, 100, -ALTITUDE_CHANGE_THRESHOLD_MPS - 0.5f);
+  render(&samples, 2000, [](int block) {
+    return block % 2 == 0 ? -ALTITUDE_CHANGE_THRESHOLD_MPS - 0.1f : -ALTITUDE_CHANGE_THRESHOLD_MPS + 0.1f;
+  });
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, onFraction(samples, msToSample(10)));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_quiet_between_thresholds);
+  RUN_TEST(test_disabled_is_silent);
+  RUN_TEST(test_climb_beeps_faster_and_higher);
+  RUN_TEST(test_sink_is_continuous_and_falls);
+  RUN_TEST(test_sink_alarm_siren);
+  RUN_TEST(test_no_clicks_at_gate_edges_and_mode_changes);
+  RUN_TEST(test_glide_time_constant);
+  RUN_TEST(test_noise_at_climb_threshold_keeps_cadence);
+  RUN_TEST(test_noise_below_climb_threshold_stays_quiet);
+  RUN_TEST(test_noise_at_sink_threshold_keeps_tone);
+  return UNITY_END();
+}
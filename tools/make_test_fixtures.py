@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Generate the input files of the host tests in test/fixtures.
+
+Usage:
+    python3 tools/make_test_fixtures.py
+
+gps_10hz.nmea: output of a CASIC receiver (M5Stack GPS unit) after power-up.
+One second at its 1 Hz default with every sentence type and two status texts,
+then GPS_NAV_RATE_HZ = 10 with only GGA and RMC, as configureGpsReceiver()
+sets it, while flying east at 36 km/h and climbing at 1 m/s. A corrupted GSV
+and a cut-off text line stand in for UART bit errors. The host tests assert
+the sentence and epoch counts this produces.
+
+vario_flight.csv: barometer samples at BARO_PRESSURE_RATE_HZ = 50 as
+"time_ms,pressure_hPa[,gps_altitude_m]" lines, the GPS altitude on every fifth
+line (10 Hz). Two minutes of glide, a thermal circled with a varying climb,
+strong sink and glide again. The pressure follows the barometric formula of
+the firmware for a QNH of 1020 hPa against VARIO_QNH_HPA = 1013.25, so the
+filter has to find a barometer offset of about -54 m. Barometer noise 0.25 m,
+GPS noise 4 m, both seeded.
+
+The output is deterministic, so the files only change with this script.
+"""
+
+import math
+import os
+import random
+
+FIXTURE_DIR = os.path.join(os.path.dirname(__file__), "..", "test", "fixtures")
+
+GPS_EPOCHS = 300  # 30 s at 10 Hz
+GPS_START_LATITUDE = 46.947597
+GPS_START_LONGITUDE = 7.440434
+GPS_START_ALTITUDE = 1500.0
+
+VARIO_RATE_HZ = 50
+VARIO_GPS_EVERY = 5  # 10 Hz
+VARIO_SECONDS = 120
+VARIO_START_ALTITUDE = 1500.0
+VARIO_TRUE_QNH_HPA = 1020.0
+VARIO_BARO_NOISE_M = 0.25
+VARIO_GPS_NOISE_M = 4.0
+VARIO_SEED = 2026
+# (start s, vertical speed m/s); the speed ramps over 2 s into every phase
+VARIO_PHASES = [(0, -1.2), (20, 1.5), (60, -1.5), (80, -4.5), (95, -1.0)]
+VARIO_THERMAL = (20, 60)  # Circling: +-1 m/s with the 10 s turn period
+
+
+def nmea(body):
+    """Complete "$..." with checksum and line end."""
+    checksum = 0
+    for c in body[1:]:
+        checksum ^= ord(c)
+    return "%s*%02X\r\n" % (body, checksum)
+
+
+def nmea_time(seconds):
+    whole = int(seconds)
+    return "%02d%02d%06.3f" % (12 + whole // 3600, whole // 60 % 60, seconds - whole + whole % 60)
+
+
+def nmea_coordinate(degrees, width):
+    whole = int(abs(degrees))
+    return "%0*d%07.4f" % (width, whole, (abs(degrees) - whole) * 60.0)
+
+
+def gps_position(seconds):
+    latitude = GPS_START_LATITUDE
+    longitude = GPS_START_LONGITUDE + seconds * 10.0 / 76000.0  # 10 m/s east, ~76 km per degree at 47 deg
+    altitude = GPS_START_ALTITUDE + seconds * 1.0
+    return latitude, longitude, altitude
+
+
+def gga(seconds):
+    latitude, longitude, altitude = gps_position(seconds)
+    return nmea("$GNGGA,%s,%s,N,%s,E,1,12,0.8,%.1f,M,48.0,M,,"
+                % (nmea_time(seconds), nmea_coordinate(latitude, 2), nmea_coordinate(longitude, 3), altitude))
+
+
+def rmc(seconds):
+    latitude, longitude, _ = gps_position(seconds)
+    return nmea("$GNRMC,%s,A,%s,N,%s,E,19.44,90.00,161026,,,A"
+                % (nmea_time(seconds), nmea_coordinate(latitude, 2), nmea_coordinate(longitude, 3)))
+
+
+def write_gps_log(path):
+    lines = [
+        nmea("$GPTXT,01,01,02,MA=CASIC"),
+        nmea("$GPTXT,01,01,02,ANTSTATUS=OK"),
+    ]
+    # One epoch at the 1 Hz default, all sentences
+    latitude, longitude, altitude = gps_position(0.0)
+    lines += [
+        gga(0.0),
+        nmea("$GNGLL,%s,N,%s,E,%s,A,A" % (nmea_coordinate(latitude, 2), nmea_coordinate(longitude, 3), nmea_time(0.0))),
+        nmea("$GNGSA,A,3,02,05,12,13,15,18,20,25,29,,,,1.4,0.8,1.1,1"),
+        nmea("$GPGSV,2,1,08,02,35,141,40,05,60,280,42,12,28,067,38,13,41,210,41,0"),
+        nmea("$GPGSV,2,2,08,15,17,310,33,18,12,035,30,20,55,110,44,25,07,250,28,0"),
+        rmc(0.0),
+        nmea("$GNVTG,90.00,T,,M,19.44,N,36.00,K,A"),
+        nmea("$GNZDA,%s,16,10,2026,00,00" % nmea_time(0.0)),
+    ]
+    # Bit errors: a GSV with a wrong checksum, a text line cut off before its checksum
+    corrupted = nmea("$GPGSV,2,1,08,02,35,141,40,05,60,280,42,12,28,067,38,13,41,210,41,0")
+    lines.append(corrupted.replace("141", "142", 1))
+    lines.append("$GPTXT,01,01,02,ANTS\r\n")
+    # configureGpsReceiver(): 10 Hz, GGA and RMC only
+    for epoch in range(1, GPS_EPOCHS + 1):
+        seconds = 1.0 + epoch / 10.0
+        lines += [gga(seconds), rmc(seconds)]
+
+    with open(path, "w", newline="") as out:
+        out.writelines(lines)
+
+
+def vertical_speed(seconds):
+    speed = VARIO_PHASES[0][1]
+    for (start, phase_speed), (_, previous_speed) in zip(VARIO_PHASES[1:], VARIO_PHASES):
+        if seconds >= start:
+            speed = previous_speed + (phase_speed - previous_speed) * min(1.0, (seconds - start) / 2.0)
+    if VARIO_THERMAL[0] <= seconds < VARIO_THERMAL[1]:
+        speed += math.sin(2.0 * math.pi * (seconds - VARIO_THERMAL[0]) / 10.0)
+    return speed
+
+
+def altitude_to_pressure(altitude):
+    """Inverse of pressureToAltitude(): 44330 * (1 - (p / qnh)^(1 / 5.255))."""
+    return VARIO_TRUE_QNH_HPA * (1.0 - altitude / 44330.0) ** 5.255
+
+
+def write_vario_flight(path):
+    rng = random.Random(VARIO_SEED)
+    altitude = VARIO_START_ALTITUDE
+    dt = 1.0 / VARIO_RATE_HZ
+    lines = []
+    for sample in range(VARIO_SECONDS * VARIO_RATE_HZ):
+        seconds = sample * dt
+        altitude += vertical_speed(seconds) * dt
+        pressure = altitude_to_pressure(altitude + rng.gauss(0.0, VARIO_BARO_NOISE_M))
+        line = "%d,%.4f" % (round(seconds * 1000), pressure)
+        if sample % VARIO_GPS_EVERY == 0:
+            line += ",%.1f" % (altitude + rng.gauss(0.0, VARIO_GPS_NOISE_M))
+        lines.append(line + "\n")
+
+    with open(path, "w", newline="") as out:
+        out.writelines(lines)
+
+
+def main():
+    os.makedirs(FIXTURE_DIR, exist_ok=True)
+    write_gps_log(os.path.join(FIXTURE_DIR, "gps_10hz.nmea"))
+    write_vario_flight(os.path.join(FIXTURE_DIR, "vario_flight.csv"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Pack a z/x/y tile directory into a single FlightHelper tile archive (.fhta).
+
+Usage:
+    python3 tools/pack_tiles.py maps/pixelkarte-farbe maps/pixelkarte-farbe.fhta
+    python3 tools/pack_tiles.py maps/hike maps/hike.fhta
+
+Pre-merged variants (base JPEG with PNG overlays composited, needs Pillow):
+    python3 tools/pack_tiles.py maps/pixelkarte-farbe maps/pixelkarte-farbe+hike.fhta --overlay maps/hike
+    python3 tools/pack_tiles.py maps/pixelkarte-farbe maps/pixelkarte-farbe+hike+bike.fhta \
+        --overlay maps/hike --overlay maps/bike
+The device uses a pre-merged archive for the matching overlay combination and
+skips PNG decoding entirely. Overlays are applied in the order given; the
+device draws hike before bike.
+
+Existence bitmaps for layers kept as loose files (lets the device skip missing
+tiles without opening them):
+    python3 tools/pack_tiles.py maps/hike maps/hike.fhtx --exists
+
+Copy the resulting .fhta/.fhtx files to /maps on the SD card. The device prefers an
+archive over the loose tile directory of the same layer.
+
+Layout (little endian, see src/tile_archive.h):
+    header   32 bytes: "FHTA", version u16, entry size u16, entry count u32,
+                       index offset u32, data offset u32, format u8, 11 reserved
+    index    entry count * (key u64, offset u32, length u32), sorted by key
+    blobs    tile files, contiguous in index order
+"""
+
+import argparse
+import io
+import os
+import struct
+import sys
+
+MAGIC = b"FHTA"
+VERSION = 1
+HEADER = struct.Struct("<4sHHIIIB11x")
+ENTRY = struct.Struct("<QII")
+EXISTS_MAGIC = b"FHTX"
+EXISTS_VERSION = 1
+EXISTS_HEADER = struct.Struct("<4sHH")
+EXISTS_ZOOM = struct.Struct("<B3xIIII")
+FORMATS = {".jpeg": 0, ".jpg": 0, ".png": 1}
+MAX_OFFSET = 0xFFFFFFFF  # Offsets are u32; FAT32 files cannot exceed 4GB anyway
+
+
+def tile_key(z, x, y):
+    """Sort key matching tileArchiveKey() in src/tile_archive.h."""
+    return (z << 48) | (x << 24) | y
+
+
+def collect_tiles(tile_dir):
+    """Return [(key, path)] and the blob format for every z/x/y.<ext> below tile_dir."""
+    tiles = []
+    formats = set()
+    for z_name in os.listdir(tile_dir):
+        z_dir = os.path.join(tile_dir, z_name)
+        if not z_name.isdigit() or not os.path.isdir(z_dir):
+            continue
+        for x_name in os.listdir(z_dir):
+            x_dir = os.path.join(z_dir, x_name)
+            if not x_name.isdigit() or not os.path.isdir(x_dir):
+                continue
+            for file_name in os.listdir(x_dir):
+                y_name, ext = os.path.splitext(file_name)
+                if not y_name.isdigit() or ext.lower() not in FORMATS:
+                    continue
+                formats.add(FORMATS[ext.lower()])
+                z, x, y = int(z_name), int(x_name), int(y_name)
+                if z > 24:
+                    sys.exit("Zoom %d exceeds the archive key range" % z)
+                tiles.append((tile_key(z, x, y), os.path.join(x_dir, file_name)))
+    if len(formats) > 1:
+        sys.exit("%s mixes JPEG and PNG tiles; pack them into separate archives" % tile_dir)
+    tiles.sort()
+    return tiles, formats.pop() if formats else 0
+
+
+def merge_tile(base_path, overlay_paths, quality):
+    """Composite the PNG overlays onto the base tile and return the JPEG bytes."""
+    from PIL import Image  # Only needed for pre-merged archives
+
+    image = Image.open(base_path).convert("RGBA")
+    for overlay_path in overlay_paths:
+        overlay = Image.open(overlay_path).convert("RGBA")
+        if overlay.size != image.size:
+            overlay = overlay.resize(image.size)
+        image = Image.alpha_composite(image, overlay)
+    out = io.BytesIO()
+    image.convert("RGB").save(out, "JPEG", quality=quality)
+    return out.getvalue()
+
+
+def tile_blobs(tiles, overlay_dirs, quality):
+    """Yield the blob of every tile, merging the overlays where they exist."""
+    for key, path in tiles:
+        z, x, y = key >> 48, (key >> 24) & 0xFFFFFF, key & 0xFFFFFF
+        overlay_paths = [p for p in (os.path.join(d, str(z), str(x), "%d.png" % y) for d in overlay_dirs)
+                         if os.path.isfile(p)]
+        if overlay_paths:
+            yield merge_tile(path, overlay_paths, quality)
+        else:
+            with open(path, "rb") as tile:
+                yield tile.read()
+
+
+def write_archive(tiles, blob_format, out_path, overlay_dirs=(), quality=90):
+    index_offset = HEADER.size
+    data_offset = index_offset + len(tiles) * ENTRY.size
+
+    # Blobs are written first and the index is filled in afterwards, since merged sizes are not known up front
+    entries = []
+    offset = data_offset
+    with open(out_path, "wb") as out:
+        out.seek(data_offset)
+        for (key, _), blob in zip(tiles, tile_blobs(tiles, overlay_dirs, quality)):
+            entries.append((key, offset, len(blob)))
+            out.write(blob)
+            offset += len(blob)
+            if offset > MAX_OFFSET:
+                sys.exit("Archive would exceed 4GB; split the zoom levels into several archives")
+        out.seek(0)
+        out.write(HEADER.pack(MAGIC, VERSION, ENTRY.size, len(tiles), index_offset, data_offset, blob_format))
+        for entry in entries:
+            out.write(ENTRY.pack(*entry))
+    return offset
+
+
+def write_existence_index(tiles, out_path):
+    """Write per-zoom bounding-box bitmaps, see src/tile_exists.h."""
+    zooms = {}
+    for key, _ in tiles:
+        z, x, y = key >> 48, (key >> 24) & 0xFFFFFF, key & 0xFFFFFF
+        zooms.setdefault(z, []).append((x, y))
+
+    with open(out_path, "wb") as out:
+        out.write(EXISTS_HEADER.pack(EXISTS_MAGIC, EXISTS_VERSION, len(zooms)))
+        for z in sorted(zooms):
+            coords = zooms[z]
+            min_x = min(x for x, _ in coords)
+            min_y = min(y for _, y in coords)
+            width = max(x for x, _ in coords) - min_x + 1
+            height = max(y for _, y in coords) - min_y + 1
+            bits = bytearray((width * height + 7) // 8)
+            for x, y in coords:
+                bit = (y - min_y) * width + (x - min_x)
+                bits[bit // 8] |= 1 << (bit % 8)
+            out.write(EXISTS_ZOOM.pack(z, min_x, min_y, width, height))
+            out.write(bits)
+            print("Zoom %d: %d tiles, %dx%d bitmap (%d bytes)" % (z, len(coords), width, height, len(bits)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("tile_dir", help="Directory containing <z>/<x>/<y>.<ext> tiles")
+    parser.add_argument("archive", help="Output .fhta file (.fhtx with --exists)")
+    parser.add_argument("--overlay", action="append", default=[], metavar="DIR",
+                        help="PNG overlay directory to composite onto every base tile (repeatable)")
+    parser.add_argument("--quality", type=int, default=90, help="JPEG quality of merged tiles (default 90)")
+    parser.add_argument("--exists", action="store_true",
+                        help="Write only the existence bitmaps (.fhtx) instead of an archive")
+    args = parser.parse_args()
+
+    tiles, blob_format = collect_tiles(args.tile_dir)
+    if not tiles:
+        sys.exit("No tiles found below %s" % args.tile_dir)
+    if args.exists:
+        write_existence_index(tiles, args.archive)
+        return
+    if args.overlay and blob_format != FORMATS[".jpeg"]:
+        sys.exit("Overlays can only be merged onto JPEG base tiles")
+    size = write_archive(tiles, blob_format, args.archive, args.overlay, args.quality)
+    print("Packed %d tiles into %s (%.1f MB)" % (len(tiles), args.archive, size / 1e6))
+
+
+if __name__ == "__main__":
+    main()